@@ -54,7 +54,7 @@
 #endif
 
 /*---------------------------------------------------------------------------*/
-MEMB(transactions_memb, coap_transaction_t, COAP_MAX_OPEN_TRANSACTIONS);
+MEMB_FREELIST(transactions_memb, coap_transaction_t, COAP_MAX_OPEN_TRANSACTIONS);
 LIST(transactions_list);
 
 static struct process *transaction_handler_process = NULL;
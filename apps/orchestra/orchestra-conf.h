@@ -49,6 +49,9 @@
 #define ORCHESTRA_RULES { &eb_per_time_source, &unicast_per_neighbor_rpl_storing, &default_common }
 /* Example configuration for RPL non-storing mode: */
 /* #define ORCHESTRA_RULES { &eb_per_time_source, &unicast_per_neighbor_rpl_ns, &default_common } */
+/* Example configuration with traffic-adaptive uplink cells (the adaptive rule
+ * must come before the unicast rule): */
+/* #define ORCHESTRA_RULES { &eb_per_time_source, &unicast_adaptive_uplink, &unicast_per_neighbor_rpl_storing, &default_common } */
 
 #endif /* ORCHESTRA_CONF_RULES */
 
@@ -102,4 +105,46 @@
 #define ORCHESTRA_COLLISION_FREE_HASH             0 /* Set to 1 if ORCHESTRA_LINKADDR_HASH returns unique hashes */
 #endif /* ORCHESTRA_CONF_COLLISION_FREE_HASH */
 
+/* Length of the slotframe holding the adaptive uplink cells */
+#ifdef ORCHESTRA_CONF_ADAPTIVE_PERIOD
+#define ORCHESTRA_ADAPTIVE_PERIOD                 ORCHESTRA_CONF_ADAPTIVE_PERIOD
+#else /* ORCHESTRA_CONF_ADAPTIVE_PERIOD */
+#define ORCHESTRA_ADAPTIVE_PERIOD                 ORCHESTRA_UNICAST_PERIOD
+#endif /* ORCHESTRA_CONF_ADAPTIVE_PERIOD */
+
+/* Maximum number of extra uplink cells per child and adaptive slotframe */
+#ifdef ORCHESTRA_CONF_ADAPTIVE_MAX_LEVEL
+#define ORCHESTRA_ADAPTIVE_MAX_LEVEL              ORCHESTRA_CONF_ADAPTIVE_MAX_LEVEL
+#else /* ORCHESTRA_CONF_ADAPTIVE_MAX_LEVEL */
+#define ORCHESTRA_ADAPTIVE_MAX_LEVEL              3
+#endif /* ORCHESTRA_CONF_ADAPTIVE_MAX_LEVEL */
+
+/* Length, in adaptive slotframes, of the epoch over which traffic is counted */
+#ifdef ORCHESTRA_CONF_ADAPTIVE_EPOCH
+#define ORCHESTRA_ADAPTIVE_EPOCH                  ORCHESTRA_CONF_ADAPTIVE_EPOCH
+#else /* ORCHESTRA_CONF_ADAPTIVE_EPOCH */
+#define ORCHESTRA_ADAPTIVE_EPOCH                  8
+#endif /* ORCHESTRA_CONF_ADAPTIVE_EPOCH */
+
+/* A cell is added when an epoch's traffic reaches this share of the current
+ * capacity, and removed when it would fit in this share of one cell less */
+#ifdef ORCHESTRA_CONF_ADAPTIVE_HIGH_PERCENT
+#define ORCHESTRA_ADAPTIVE_HIGH_PERCENT           ORCHESTRA_CONF_ADAPTIVE_HIGH_PERCENT
+#else /* ORCHESTRA_CONF_ADAPTIVE_HIGH_PERCENT */
+#define ORCHESTRA_ADAPTIVE_HIGH_PERCENT           75
+#endif /* ORCHESTRA_CONF_ADAPTIVE_HIGH_PERCENT */
+
+#ifdef ORCHESTRA_CONF_ADAPTIVE_LOW_PERCENT
+#define ORCHESTRA_ADAPTIVE_LOW_PERCENT            ORCHESTRA_CONF_ADAPTIVE_LOW_PERCENT
+#else /* ORCHESTRA_CONF_ADAPTIVE_LOW_PERCENT */
+#define ORCHESTRA_ADAPTIVE_LOW_PERCENT            40
+#endif /* ORCHESTRA_CONF_ADAPTIVE_LOW_PERCENT */
+
+/* Number of children whose uplink traffic a parent tracks */
+#ifdef ORCHESTRA_CONF_ADAPTIVE_MAX_CHILDREN
+#define ORCHESTRA_ADAPTIVE_MAX_CHILDREN           ORCHESTRA_CONF_ADAPTIVE_MAX_CHILDREN
+#else /* ORCHESTRA_CONF_ADAPTIVE_MAX_CHILDREN */
+#define ORCHESTRA_ADAPTIVE_MAX_CHILDREN           8
+#endif /* ORCHESTRA_CONF_ADAPTIVE_MAX_CHILDREN */
+
 #endif /* __ORCHESTRA_CONF_H__ */
@@ -0,0 +1,412 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+/**
+ * \file
+ *         Orchestra: a sender-based slotframe that adds dedicated uplink cells
+ *         from a child to its RPL parent while the child's traffic is high,
+ *         and removes them again when it drops.
+ *
+ *         There is no negotiation: both ends of a link derive the number of
+ *         extra cells ("level") from the same event, a unicast frame from
+ *         child to parent being ACKed. TSCH reports it to both ends
+ *         (TSCH_CALLBACK_LINK_ACKED) with the ASN of the slot it happened in,
+ *         and the frame is counted in the epoch that slot belongs to, however
+ *         late it is reported. The parent counts every frame it ACKed, the
+ *         child only those whose ACK it got, so the parent's count is never
+ *         lower; as a level never decreases with a higher count, the parent
+ *         always listens on at least the cells its child sends in.
+ *         A child whose queue keeps backing up saturates its current cells,
+ *         which raises its level.
+ *         The cells of child c at level L are, for k = 1..L:
+ *           (hash(c.MAC) * ORCHESTRA_ADAPTIVE_MAX_LEVEL + k - 1) % ORCHESTRA_ADAPTIVE_PERIOD
+ *
+ *         Must be placed before the regular unicast rule in ORCHESTRA_RULES;
+ *         uplink packets it does not take fall through to that rule.
+ */
+
+#include "contiki.h"
+#include "orchestra.h"
+#include "net/packetbuf.h"
+#include "lib/memb.h"
+#include "lib/list.h"
+#include <string.h>
+
+#define DEBUG DEBUG_NONE
+#include "net/ip/uip-debug.h"
+
+#if ORCHESTRA_ADAPTIVE_HIGH_PERCENT <= ORCHESTRA_ADAPTIVE_LOW_PERCENT
+#error ORCHESTRA_ADAPTIVE_HIGH_PERCENT must be above ORCHESTRA_ADAPTIVE_LOW_PERCENT
+#endif
+
+#if ORCHESTRA_COLLISION_FREE_HASH && \
+  ORCHESTRA_ADAPTIVE_PERIOD >= (ORCHESTRA_MAX_HASH + 1) * ORCHESTRA_ADAPTIVE_MAX_LEVEL
+#define ADAPTIVE_SLOT_SHARED_FLAG     0
+#else
+#define ADAPTIVE_SLOT_SHARED_FLAG     LINK_OPTION_SHARED
+#endif
+
+/* Number of slots in an epoch */
+#define EPOCH_SLOTS ((uint32_t)ORCHESTRA_ADAPTIVE_PERIOD * ORCHESTRA_ADAPTIVE_EPOCH)
+/* Frames an epoch can carry at a given level: the regular unicast cell
+ * plus one cell per level, once per slotframe */
+#define CAPACITY(level) ((uint16_t)ORCHESTRA_ADAPTIVE_EPOCH * ((level) + 1))
+/* The epoch a slot belongs to */
+#define EPOCH_OF(asn) ((asn)->ls4b / EPOCH_SLOTS)
+/* An epoch is evaluated this many slots into the next one, so that the
+ * frames of its last slots have been reported by then */
+#define EVAL_DELAY_SLOTS (ORCHESTRA_ADAPTIVE_PERIOD / 2 + 1)
+
+/* A neighbor we have (or may get) adaptive cells with */
+struct adaptive_nbr {
+  struct adaptive_nbr *next;
+  linkaddr_t addr;
+  /* The epoch of the last frame counted */
+  uint32_t epoch;
+  /* Frames ACKed in that epoch, and in the epoch before it */
+  uint16_t count;
+  uint16_t prev_count;
+  /* Number of extra cells currently installed */
+  uint8_t level;
+};
+
+static uint16_t slotframe_handle = 0;
+static uint16_t channel_offset = 0;
+static struct tsch_slotframe *sf_adaptive;
+
+/* Our own uplink towards the parent */
+static struct adaptive_nbr uplink;
+/* Children sending to us */
+MEMB(children_memb, struct adaptive_nbr, ORCHESTRA_ADAPTIVE_MAX_CHILDREN);
+LIST(children_list);
+
+/* Used to spread uplink packets over the regular and the extra cells */
+static uint8_t uplink_rr;
+static struct ctimer epoch_timer;
+/* The last epoch whose counts were evaluated */
+static uint32_t evaluated_epoch;
+
+/*---------------------------------------------------------------------------*/
+static uint16_t
+get_cell_timeslot(const linkaddr_t *addr, uint8_t k)
+{
+  return ((uint32_t)ORCHESTRA_LINKADDR_HASH(addr) * ORCHESTRA_ADAPTIVE_MAX_LEVEL + k - 1)
+      % ORCHESTRA_ADAPTIVE_PERIOD;
+}
+/*---------------------------------------------------------------------------*/
+static void
+reset_count(struct adaptive_nbr *n)
+{
+  /* The first frame counted sets the epoch */
+  n->epoch = 0;
+  n->count = 0;
+  n->prev_count = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+count_frame(struct adaptive_nbr *n, uint32_t epoch)
+{
+  if(epoch != n->epoch) {
+    if((int32_t)(epoch - n->epoch) < 0) {
+      /* Frames are reported in slot order; never count one backwards */
+      return;
+    }
+    n->prev_count = epoch == n->epoch + 1 ? n->count : 0;
+    n->count = 0;
+    n->epoch = epoch;
+  }
+  n->count++;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+frames_in(const struct adaptive_nbr *n, uint32_t epoch)
+{
+  if(n->epoch == epoch) {
+    return n->count;
+  }
+  if(n->epoch == epoch + 1) {
+    return n->prev_count;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+next_level(uint8_t level, uint16_t count)
+{
+  if(level < ORCHESTRA_ADAPTIVE_MAX_LEVEL
+     && (uint32_t)count * 100 >= (uint32_t)CAPACITY(level) * ORCHESTRA_ADAPTIVE_HIGH_PERCENT) {
+    return level + 1;
+  }
+  if(level > 0
+     && (uint32_t)count * 100 <= (uint32_t)CAPACITY(level - 1) * ORCHESTRA_ADAPTIVE_LOW_PERCENT) {
+    return level - 1;
+  }
+  return level;
+}
+/*---------------------------------------------------------------------------*/
+/* Bring the slotframe in line with the current levels. Only the timeslots
+ * whose link changes are touched. */
+static void
+update_links(void)
+{
+  static uint8_t options[ORCHESTRA_ADAPTIVE_PERIOD];
+  struct adaptive_nbr *c;
+  struct tsch_link *l;
+  uint16_t ts;
+  uint8_t k;
+
+  memset(options, 0, sizeof(options));
+  for(k = 1; k <= uplink.level; k++) {
+    options[get_cell_timeslot(&linkaddr_node_addr, k)] |= LINK_OPTION_TX | ADAPTIVE_SLOT_SHARED_FLAG;
+  }
+  for(c = list_head(children_list); c != NULL; c = list_item_next(c)) {
+    for(k = 1; k <= c->level; k++) {
+      options[get_cell_timeslot(&c->addr, k)] |= LINK_OPTION_RX;
+    }
+  }
+
+  for(ts = 0; ts < ORCHESTRA_ADAPTIVE_PERIOD; ts++) {
+    const linkaddr_t *addr = (options[ts] & LINK_OPTION_TX) ? &uplink.addr : &tsch_broadcast_address;
+    l = tsch_schedule_get_link_by_timeslot(sf_adaptive, ts);
+    if(options[ts] == 0) {
+      if(l != NULL) {
+        tsch_schedule_remove_link(sf_adaptive, l);
+      }
+    } else if(l == NULL || l->link_options != options[ts] || !linkaddr_cmp(&l->addr, addr)) {
+      tsch_schedule_add_link(sf_adaptive, options[ts], LINK_TYPE_NORMAL, addr, ts, channel_offset);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+reset_uplink(const linkaddr_t *addr)
+{
+  linkaddr_copy(&uplink.addr, addr);
+  uplink.level = 0;
+  reset_count(&uplink);
+}
+/*---------------------------------------------------------------------------*/
+static struct adaptive_nbr *
+get_child(const linkaddr_t *addr)
+{
+  struct adaptive_nbr *c;
+  for(c = list_head(children_list); c != NULL; c = list_item_next(c)) {
+    if(linkaddr_cmp(&c->addr, addr)) {
+      return c;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct adaptive_nbr *
+add_child(const linkaddr_t *addr)
+{
+  struct adaptive_nbr *c;
+  if(addr == NULL || linkaddr_cmp(addr, &linkaddr_null)) {
+    return NULL;
+  }
+  c = get_child(addr);
+  if(c != NULL) {
+    return c;
+  }
+  c = memb_alloc(&children_memb);
+  if(c == NULL) {
+    PRINTF("Orchestra adaptive: no room for child %u\n", addr->u8[LINKADDR_SIZE - 1]);
+    return NULL;
+  }
+  linkaddr_copy(&c->addr, addr);
+  c->level = 0;
+  reset_count(c);
+  list_add(children_list, c);
+  return c;
+}
+/*---------------------------------------------------------------------------*/
+static void schedule_epoch_timer(void);
+
+static void
+epoch_end(void *ptr)
+{
+  struct adaptive_nbr *c;
+  struct adaptive_nbr *next;
+  uint32_t epoch;
+  uint16_t frames;
+  uint8_t level;
+  int changed = 0;
+
+  if(!tsch_is_associated) {
+    changed = uplink.level != 0;
+    uplink.level = 0;
+    for(c = list_head(children_list); c != NULL; c = list_item_next(c)) {
+      changed |= c->level != 0;
+      c->level = 0;
+    }
+  } else if((epoch = EPOCH_OF(&tsch_current_asn) - 1) != evaluated_epoch) {
+    /* Evaluate the epoch that just ended, once */
+    evaluated_epoch = epoch;
+    if(!linkaddr_cmp(&uplink.addr, &linkaddr_null)) {
+      level = next_level(uplink.level, frames_in(&uplink, epoch));
+      changed |= level != uplink.level;
+      uplink.level = level;
+    }
+    for(c = list_head(children_list); c != NULL; c = next) {
+      next = list_item_next(c);
+      frames = frames_in(c, epoch);
+      if(c->level == 0 && frames == 0 && c->epoch != epoch + 1) {
+        /* Idle child without cells, forget it until it sends again */
+        list_remove(children_list, c);
+        memb_free(&children_memb, c);
+        continue;
+      }
+      level = next_level(c->level, frames);
+      changed |= level != c->level;
+      c->level = level;
+    }
+  }
+
+  if(changed) {
+    PRINTF("Orchestra adaptive: uplink level %u\n", uplink.level);
+    update_links();
+  }
+  schedule_epoch_timer();
+}
+/*---------------------------------------------------------------------------*/
+/* Fire EVAL_DELAY_SLOTS into the next epoch, or into the current one if
+ * that point is still ahead */
+static void
+schedule_epoch_timer(void)
+{
+  uint32_t slots_left = EPOCH_SLOTS;
+  uint32_t pos;
+  clock_time_t delay;
+
+  if(tsch_is_associated) {
+    pos = tsch_current_asn.ls4b % EPOCH_SLOTS;
+    if(pos < EVAL_DELAY_SLOTS) {
+      slots_left = EVAL_DELAY_SLOTS - pos;
+    } else {
+      slots_left = EPOCH_SLOTS - pos + EVAL_DELAY_SLOTS;
+    }
+  }
+  delay = (slots_left * (TSCH_DEFAULT_TS_TIMESLOT_LENGTH / 100) * CLOCK_SECOND) / 10000;
+  ctimer_set(&epoch_timer, delay + 1, epoch_end, NULL);
+}
+/*---------------------------------------------------------------------------*/
+static void
+child_added(const linkaddr_t *linkaddr)
+{
+  add_child(linkaddr);
+}
+/*---------------------------------------------------------------------------*/
+static void
+child_removed(const linkaddr_t *linkaddr)
+{
+  struct adaptive_nbr *c = linkaddr != NULL ? get_child(linkaddr) : NULL;
+  if(c != NULL) {
+    list_remove(children_list, c);
+    memb_free(&children_memb, c);
+    update_links();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+link_acked(const linkaddr_t *addr, int is_tx, const struct tsch_asn_t *asn)
+{
+  struct adaptive_nbr *c;
+
+  if(is_tx) {
+    if(!linkaddr_cmp(&uplink.addr, &linkaddr_null)
+       && linkaddr_cmp(addr, &uplink.addr)) {
+      count_frame(&uplink, EPOCH_OF(asn));
+    }
+  } else if(!linkaddr_cmp(addr, &uplink.addr)) {
+    /* In non-storing mode we never hear about children; treat any node that
+     * sends us unicast as one, except our parent (the time source, which
+     * uplink tracks) */
+    c = add_child(addr);
+    if(c != NULL) {
+      count_frame(c, EPOCH_OF(asn));
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+select_packet(uint16_t *slotframe, uint16_t *timeslot)
+{
+  const linkaddr_t *dest = packetbuf_addr(PACKETBUF_ADDR_RECEIVER);
+  if(uplink.level > 0
+     && packetbuf_attr(PACKETBUF_ATTR_FRAME_TYPE) == FRAME802154_DATAFRAME
+     && !linkaddr_cmp(&uplink.addr, &linkaddr_null)
+     && linkaddr_cmp(dest, &uplink.addr)) {
+    /* One packet in (level + 1) is left to the regular unicast cell */
+    uplink_rr = (uplink_rr + 1) % (uplink.level + 1);
+    if(uplink_rr == 0) {
+      return 0;
+    }
+    if(slotframe != NULL) {
+      *slotframe = slotframe_handle;
+    }
+    if(timeslot != NULL) {
+      /* Any of our extra cells */
+      *timeslot = 0xffff;
+    }
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+new_time_source(const struct tsch_neighbor *old, const struct tsch_neighbor *new)
+{
+  if(new != old) {
+    reset_uplink(new != NULL ? &new->addr : &linkaddr_null);
+    update_links();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+init(uint16_t sf_handle)
+{
+  slotframe_handle = sf_handle;
+  channel_offset = sf_handle;
+  memb_init(&children_memb);
+  list_init(children_list);
+  reset_uplink(&linkaddr_null);
+  /* Starts empty; links are added as traffic grows */
+  sf_adaptive = tsch_schedule_add_slotframe(slotframe_handle, ORCHESTRA_ADAPTIVE_PERIOD);
+  schedule_epoch_timer();
+}
+/*---------------------------------------------------------------------------*/
+struct orchestra_rule unicast_adaptive_uplink = {
+  init,
+  new_time_source,
+  select_packet,
+  child_added,
+  child_removed,
+  link_acked,
+};
@@ -106,6 +106,18 @@ orchestra_callback_child_removed(const linkaddr_t *addr)
 }
 /*---------------------------------------------------------------------------*/
 void
+orchestra_callback_link_acked(const linkaddr_t *addr, int is_tx, const struct tsch_asn_t *asn)
+{
+  /* Notify all Orchestra rules that a unicast frame was ACKed */
+  int i;
+  for(i = 0; i < NUM_RULES; i++) {
+    if(all_rules[i]->link_acked != NULL) {
+      all_rules[i]->link_acked(addr, is_tx, asn);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
 orchestra_callback_packet_ready(void)
 {
   int i;
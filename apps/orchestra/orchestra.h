@@ -50,12 +50,14 @@ struct orchestra_rule {
   int  (* select_packet)(uint16_t *slotframe, uint16_t *timeslot);
   void (* child_added)(const linkaddr_t *addr);
   void (* child_removed)(const linkaddr_t *addr);
+  void (* link_acked)(const linkaddr_t *addr, int is_tx, const struct tsch_asn_t *asn);
 };
 
 struct orchestra_rule eb_per_time_source;
 struct orchestra_rule unicast_per_neighbor_rpl_storing;
 struct orchestra_rule unicast_per_neighbor_rpl_ns;
 struct orchestra_rule default_common;
+struct orchestra_rule unicast_adaptive_uplink;
 
 extern linkaddr_t orchestra_parent_linkaddr;
 extern int orchestra_parent_knows_us;
@@ -71,5 +73,8 @@ void orchestra_callback_new_time_source(const struct tsch_neighbor *old, const s
 void orchestra_callback_child_added(const linkaddr_t *addr);
 /* Set with #define NETSTACK_CONF_ROUTING_NEIGHBOR_REMOVED_CALLBACK orchestra_callback_child_removed */
 void orchestra_callback_child_removed(const linkaddr_t *addr);
+/* Needed by rules that count traffic, such as unicast_adaptive_uplink.
+ * Set with #define TSCH_CALLBACK_LINK_ACKED orchestra_callback_link_acked */
+void orchestra_callback_link_acked(const linkaddr_t *addr, int is_tx, const struct tsch_asn_t *asn);
 
 #endif /* __ORCHESTRA_H__ */
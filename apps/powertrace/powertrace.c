@@ -64,6 +64,14 @@ struct powertrace_sniff_stats {
 
 #define MAX_NUM_STATS  16
 
+/* Number of processes reported, longest running first, when processes
+   are profiled (PROCESS_CONF_PROFILE). */
+#ifdef POWERTRACE_CONF_PROCESSES
+#define POWERTRACE_PROCESSES POWERTRACE_CONF_PROCESSES
+#else
+#define POWERTRACE_PROCESSES 5
+#endif
+
 MEMB(stats_memb, struct powertrace_sniff_stats, MAX_NUM_STATS);
 LIST(stats_list);
 
@@ -85,6 +93,10 @@ powertrace_print(char *str)
   unsigned long time, all_time, radio, all_radio;
   
   struct powertrace_sniff_stats *s;
+#if PROCESS_CONF_PROFILE
+  struct process *top[POWERTRACE_PROCESSES];
+  int i, n;
+#endif /* PROCESS_CONF_PROFILE */
 
   energest_flush();
 
@@ -133,6 +145,19 @@ powertrace_print(char *str)
          (int)((100L * listen) / time),
          (int)((10000L * listen) / time - (100L * listen / time) * 100));
 
+#if PROCESS_CONF_PROFILE
+  /* Run time and longest call are in rtimer ticks, like the energest
+     times above. */
+  n = process_profile_top(top, POWERTRACE_PROCESSES);
+  for(i = 0; i < n; i++) {
+    printf("%s %lu PP %d.%d %lu %d %lu %lu %lu %s\n",
+           str, clock_time(), linkaddr_node_addr.u8[0],
+           linkaddr_node_addr.u8[1], seqno, i,
+           top[i]->runtime, top[i]->nevents + top[i]->npolls,
+           top[i]->maxtime, PROCESS_NAME_STRING(top[i]));
+  }
+#endif /* PROCESS_CONF_PROFILE */
+
   for(s = list_head(stats_list); s != NULL; s = list_item_next(s)) {
 
 #if ! NETSTACK_CONF_WITH_IPV6
@@ -43,6 +43,10 @@
 #include <stdio.h>
 #include <string.h>
 
+#if PROCESS_CONF_PROFILE
+#include "sys/rtimer.h"
+#endif /* PROCESS_CONF_PROFILE */
+
 /*---------------------------------------------------------------------------*/
 PROCESS(shell_ps_process, "ps");
 SHELL_COMMAND(ps_command,
@@ -65,9 +69,79 @@ PROCESS_THREAD(shell_ps_process, ev, data)
   PROCESS_END();
 }
 /*---------------------------------------------------------------------------*/
+#if PROCESS_CONF_PROFILE
+#define TOP_DEFAULT 5
+#define TOP_MAX     16
+
+PROCESS(shell_top_process, "top");
+SHELL_COMMAND(top_command,
+	      "top",
+	      "top [num]: list the processes that have run the longest",
+	      &shell_top_process);
+/*---------------------------------------------------------------------------*/
+/* Convert rtimer ticks to microseconds without overflowing. */
+static unsigned long
+ticks_to_us(unsigned long t)
+{
+  unsigned long r;
+
+  r = t % RTIMER_ARCH_SECOND;
+  return t / RTIMER_ARCH_SECOND * 1000000UL +
+    r * 1000 / RTIMER_ARCH_SECOND * 1000 +
+    r * 1000 % RTIMER_ARCH_SECOND * 1000 / RTIMER_ARCH_SECOND;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(shell_top_process, ev, data)
+{
+  struct process *top[TOP_MAX];
+  struct process *p;
+  unsigned long total, percent;
+  char buf[80];
+  int num, n, i;
+
+  PROCESS_BEGIN();
+
+  num = shell_strtolong(data, NULL);
+  if(num <= 0) {
+    num = TOP_DEFAULT;
+  } else if(num > TOP_MAX) {
+    num = TOP_MAX;
+  }
+
+  total = 0;
+  for(p = PROCESS_LIST(); p != NULL; p = p->next) {
+    total += p->runtime;
+  }
+
+  shell_output_str(&top_command, "cpu% time(ms) calls max(us) name", "");
+  n = process_profile_top(top, num);
+  for(i = 0; i < n; i++) {
+    p = top[i];
+    if(total >= 100) {
+      percent = p->runtime / (total / 100);
+    } else if(total > 0) {
+      percent = p->runtime * 100 / total;
+    } else {
+      percent = 0;
+    }
+    snprintf(buf, sizeof(buf), "%3lu %lu %lu %lu ",
+             percent,
+             ticks_to_us(p->runtime) / 1000,
+             p->nevents + p->npolls,
+             ticks_to_us(p->maxtime));
+    shell_output_str(&top_command, buf, PROCESS_NAME_STRING(p));
+  }
+
+  PROCESS_END();
+}
+#endif /* PROCESS_CONF_PROFILE */
+/*---------------------------------------------------------------------------*/
 void
 shell_ps_init(void)
 {
   shell_register_command(&ps_command);
+#if PROCESS_CONF_PROFILE
+  shell_register_command(&top_command);
+#endif /* PROCESS_CONF_PROFILE */
 }
 /*---------------------------------------------------------------------------*/
@@ -64,7 +64,11 @@ static const uint8_t sbox[256] =   {
 0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
 0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16 };
 
-static uint8_t round_keys[11][AES_128_KEY_LENGTH];
+/* Expanded keys of the most recently used keys */
+static uint8_t key_cache[AES_128_KEY_CACHE_SIZE][11][AES_128_KEY_LENGTH];
+static uint8_t key_cache_used;
+static uint8_t key_cache_next;
+static uint8_t (*round_keys)[AES_128_KEY_LENGTH] = key_cache[0];
 
 /*---------------------------------------------------------------------------*/
 /* multiplies by 2 in GF(2) */
@@ -76,27 +80,49 @@ galois_mul2(uint8_t value)
 }
 /*---------------------------------------------------------------------------*/
 static void
-set_key(const uint8_t *key)
+expand_key(uint8_t keys[11][AES_128_KEY_LENGTH], const uint8_t *key)
 {
   uint8_t i;
   uint8_t j;
   uint8_t rcon;
   
   rcon = 0x01;
-  memcpy(round_keys[0], key, AES_128_KEY_LENGTH);
+  memcpy(keys[0], key, AES_128_KEY_LENGTH);
   for(i = 1; i <= 10; i++) {
-    round_keys[i][0] = sbox[round_keys[i - 1][13]] ^ round_keys[i - 1][0] ^ rcon;
-    round_keys[i][1] = sbox[round_keys[i - 1][14]] ^ round_keys[i - 1][1];
-    round_keys[i][2] = sbox[round_keys[i - 1][15]] ^ round_keys[i - 1][2];
-    round_keys[i][3] = sbox[round_keys[i - 1][12]] ^ round_keys[i - 1][3];
+    keys[i][0] = sbox[keys[i - 1][13]] ^ keys[i - 1][0] ^ rcon;
+    keys[i][1] = sbox[keys[i - 1][14]] ^ keys[i - 1][1];
+    keys[i][2] = sbox[keys[i - 1][15]] ^ keys[i - 1][2];
+    keys[i][3] = sbox[keys[i - 1][12]] ^ keys[i - 1][3];
     for(j = 4; j < AES_128_BLOCK_SIZE; j++) {
-      round_keys[i][j] = round_keys[i - 1][j] ^ round_keys[i][j - 4];
+      keys[i][j] = keys[i - 1][j] ^ keys[i][j - 4];
     }
     rcon = galois_mul2(rcon);
   }
 }
 /*---------------------------------------------------------------------------*/
 static void
+set_key(const uint8_t *key)
+{
+  uint8_t i;
+
+  /* The first round key is the key itself */
+  for(i = 0; i < key_cache_used; i++) {
+    if(memcmp(key_cache[i][0], key, AES_128_KEY_LENGTH) == 0) {
+      round_keys = key_cache[i];
+      return;
+    }
+  }
+
+  i = key_cache_next;
+  key_cache_next = (key_cache_next + 1) % AES_128_KEY_CACHE_SIZE;
+  if(key_cache_used < AES_128_KEY_CACHE_SIZE) {
+    key_cache_used++;
+  }
+  expand_key(key_cache[i], key);
+  round_keys = key_cache[i];
+}
+/*---------------------------------------------------------------------------*/
+static void
 encrypt(uint8_t *state)
 {
   uint8_t buf1, buf2, buf3, buf4, round, i;
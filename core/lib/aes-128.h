@@ -51,6 +51,15 @@
 #define AES_128            aes_128_driver
 #endif /* AES_128_CONF */
 
+/* The number of expanded keys kept by software AES-128 drivers, so that
+   switching between keys, as TSCH does per frame, does not redo the
+   key schedule */
+#ifdef AES_128_CONF_KEY_CACHE_SIZE
+#define AES_128_KEY_CACHE_SIZE AES_128_CONF_KEY_CACHE_SIZE
+#else /* AES_128_CONF_KEY_CACHE_SIZE */
+#define AES_128_KEY_CACHE_SIZE 2
+#endif /* AES_128_CONF_KEY_CACHE_SIZE */
+
 /**
  * Structure of AES drivers.
  */
@@ -74,4 +83,7 @@ void aes_128_set_padded_key(uint8_t *key, uint8_t key_len);
 
 extern const struct aes_128_driver AES_128;
 
+/* The software driver, which hardware drivers may fall back on */
+extern const struct aes_128_driver aes_128_driver;
+
 #endif /* AES_128_H_ */
@@ -59,34 +59,33 @@ set_iv(uint8_t *iv,
   iv[15] = counter;
 }
 /*---------------------------------------------------------------------------*/
-/* XORs the block m[pos] ... m[pos + 15] with K_{counter} */
+/* Generates the key stream block S_{counter} from the CTR IV a */
 static void
-ctr_step(const uint8_t *nonce,
-    uint8_t pos,
-    uint8_t *m_and_result,
-    uint8_t m_len,
-    uint8_t counter)
+ctr_block(const uint8_t *a, uint8_t counter, uint8_t *s)
 {
-  uint8_t a[AES_128_BLOCK_SIZE];
-  uint8_t i;
-  
-  set_iv(a, CCM_STAR_ENCRYPTION_FLAGS, nonce, counter);
-  AES_128.encrypt(a);
-  
-  for(i = 0; (pos + i < m_len) && (i < AES_128_BLOCK_SIZE); i++) {
-    m_and_result[pos + i] ^= a[i];
-  }
+  memcpy(s, a, AES_128_BLOCK_SIZE);
+  s[15] = counter;
+  AES_128.encrypt(s);
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Runs the CBC-MAC over a and m and the CTR pass over m in a single pass
+ * over m. In forward direction, each block is authenticated before it is
+ * encrypted; otherwise, it is decrypted before it is authenticated. This
+ * gives the same result as running the two passes one after the other.
+ */
 static void
-mic(const uint8_t *nonce,
-    const uint8_t *m, uint8_t m_len,
-    const uint8_t *a, uint8_t a_len,
-    uint8_t *result,
-    uint8_t mic_len)
+aead(const uint8_t* nonce,
+    uint8_t* m, uint8_t m_len,
+    const uint8_t* a, uint8_t a_len,
+    uint8_t *result, uint8_t mic_len,
+    int forward)
 {
   uint8_t x[AES_128_BLOCK_SIZE];
-  uint8_t pos;
+  uint8_t ctr_iv[AES_128_BLOCK_SIZE];
+  uint8_t s[AES_128_BLOCK_SIZE];
+  uint16_t pos;
+  uint8_t counter;
   uint8_t i;
   
   set_iv(x, CCM_STAR_AUTH_FLAGS(a_len, mic_len), nonce, m_len);
@@ -110,33 +109,27 @@ mic(const uint8_t *nonce,
     }
   }
   
-  if(m_len) {
-    pos = 0;
-    while(pos < m_len) {
-      for(i = 0; (pos + i < m_len) && (i < AES_128_BLOCK_SIZE); i++) {
+  set_iv(ctr_iv, CCM_STAR_ENCRYPTION_FLAGS, nonce, 0);
+  pos = 0;
+  counter = 1;
+  while(pos < m_len) {
+    ctr_block(ctr_iv, counter++, s);
+    for(i = 0; (pos + i < m_len) && (i < AES_128_BLOCK_SIZE); i++) {
+      if(forward) {
+        x[i] ^= m[pos + i];
+        m[pos + i] ^= s[i];
+      } else {
+        m[pos + i] ^= s[i];
         x[i] ^= m[pos + i];
       }
-      pos += AES_128_BLOCK_SIZE;
-      AES_128.encrypt(x);
     }
+    pos += AES_128_BLOCK_SIZE;
+    AES_128.encrypt(x);
   }
   
-  ctr_step(nonce, 0, x, AES_128_BLOCK_SIZE, 0);
-  
-  memcpy(result, x, mic_len);
-}
-/*---------------------------------------------------------------------------*/
-static void
-ctr(const uint8_t *nonce, uint8_t *m, uint8_t m_len)
-{
-  uint8_t pos;
-  uint8_t counter;
-  
-  pos = 0;
-  counter = 1;
-  while(pos < m_len) {
-    ctr_step(nonce, pos, m, m_len, counter++);
-    pos += AES_128_BLOCK_SIZE;
+  ctr_block(ctr_iv, 0, s);
+  for(i = 0; i < mic_len; i++) {
+    result[i] = x[i] ^ s[i];
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -146,30 +139,6 @@ set_key(const uint8_t *key)
   AES_128.set_key(key);
 }
 /*---------------------------------------------------------------------------*/
-static void
-aead(const uint8_t* nonce,
-    uint8_t* m, uint8_t m_len,
-    const uint8_t* a, uint8_t a_len,
-    uint8_t *result, uint8_t mic_len,
-    int forward)
-{
-  if(!forward) {
-    /* decrypt */
-    ctr(nonce, m, m_len);
-  }
-  
-  mic(nonce,
-    m, m_len,
-    a, a_len,
-    result,
-    mic_len);
-  
-  if(forward) {
-    /* encrypt */
-    ctr(nonce, m, m_len);
-  }
-}
-/*---------------------------------------------------------------------------*/
 const struct ccm_star_driver ccm_star_driver = {
   set_key,
   aead
@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Lock-free ring of fixed-size elements
+ */
+
+#include <string.h>
+#include "lib/lfring.h"
+
+/*
+ * The producer publishes put_ptr with release semantics after writing
+ * the element, and the consumer reads it with acquire semantics before
+ * reading the element; likewise for get_ptr in the other direction.
+ * Without the atomic builtins, a compiler barrier is enough on the
+ * single-core MCUs where only interrupts can interleave.
+ */
+#if defined(__ATOMIC_ACQUIRE)
+#define LOAD_ACQUIRE(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else
+#if defined(__GNUC__)
+#define BARRIER() __asm__ __volatile__("" ::: "memory")
+#else
+#define BARRIER()
+#endif
+static lfring_index_t
+load_acquire(lfring_index_t *p)
+{
+  lfring_index_t v = *(volatile lfring_index_t *)p;
+  BARRIER();
+  return v;
+}
+#define LOAD_ACQUIRE(p)     load_acquire(p)
+#define STORE_RELEASE(p, v) do { BARRIER();                              \
+    *(volatile lfring_index_t *)(p) = (v); } while(0)
+#endif
+
+#define ELEM(r, i) ((uint8_t *)(r)->data + \
+                    ((i) & (r)->mask) * (r)->elem_size)
+
+/*
+ * The sequence numbers of multi-producer rings are stored minus the
+ * offset of their element, so that a ring in zeroed memory, such as a
+ * static LFRING_MP(), is empty and ready for use without lfring_init().
+ */
+#define SEQ_TO_STORED(r, i, v) ((lfring_index_t)((v) - ((i) & (r)->mask)))
+#define STORED_TO_SEQ(r, i, v) ((lfring_index_t)((v) + ((i) & (r)->mask)))
+/*---------------------------------------------------------------------------*/
+void
+lfring_setup(struct lfring *r, void *data, unsigned short elem_size,
+             lfring_index_t size, lfring_index_t *seq)
+{
+  r->data = data;
+  r->seq = seq;
+  r->elem_size = elem_size;
+  r->mask = size - 1;
+  lfring_init(r);
+}
+/*---------------------------------------------------------------------------*/
+void
+lfring_init(struct lfring *r)
+{
+  lfring_index_t i;
+
+  r->put_ptr = r->get_ptr = 0;
+  if(r->seq != NULL) {
+    for(i = 0; i <= r->mask; i++) {
+      r->seq[i] = SEQ_TO_STORED(r, i, i);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Number of free elements, as seen by the single producer. */
+static int
+space(struct lfring *r)
+{
+  return r->mask + 1 -
+    (lfring_index_t)(r->put_ptr - LOAD_ACQUIRE(&r->get_ptr));
+}
+/*---------------------------------------------------------------------------*/
+void *
+lfring_peek_put(struct lfring *r)
+{
+  if(space(r) == 0) {
+    return NULL;
+  }
+  return ELEM(r, r->put_ptr);
+}
+/*---------------------------------------------------------------------------*/
+void
+lfring_commit_put(struct lfring *r)
+{
+  STORE_RELEASE(&r->put_ptr, (lfring_index_t)(r->put_ptr + 1));
+}
+/*---------------------------------------------------------------------------*/
+int
+lfring_put(struct lfring *r, const void *elem)
+{
+  return lfring_put_bulk(r, elem, 1);
+}
+/*---------------------------------------------------------------------------*/
+int
+lfring_put_bulk(struct lfring *r, const void *elems, int n)
+{
+  int first;
+  int room;
+
+  room = space(r);
+  if(n > room) {
+    n = room;
+  }
+  if(n <= 0) {
+    return 0;
+  }
+
+  /* Copy in at most two chunks, split where the ring wraps. */
+  first = r->mask + 1 - (r->put_ptr & r->mask);
+  if(first > n) {
+    first = n;
+  }
+  memcpy(ELEM(r, r->put_ptr), elems, first * r->elem_size);
+  if(n > first) {
+    memcpy(r->data, (const uint8_t *)elems + first * r->elem_size,
+           (n - first) * r->elem_size);
+  }
+
+  STORE_RELEASE(&r->put_ptr, (lfring_index_t)(r->put_ptr + n));
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+#if LFRING_MP_SUPPORTED
+/*
+ * Each element has a sequence number that tells its state: equal to
+ * the index that will next be put into it when free, and one past that
+ * index once the element has been written. A producer claims an index
+ * by advancing put_ptr with compare-and-swap, so it never waits for
+ * another producer and may run in an interrupt handler.
+ */
+int
+lfring_mp_put(struct lfring *r, const void *elem)
+{
+  lfring_index_t pos;
+  lfring_index_t *seq;
+
+  pos = __atomic_load_n(&r->put_ptr, __ATOMIC_RELAXED);
+  while(1) {
+    seq = &r->seq[pos & r->mask];
+    if(STORED_TO_SEQ(r, pos, __atomic_load_n(seq, __ATOMIC_ACQUIRE)) == pos) {
+      if(__atomic_compare_exchange_n(&r->put_ptr, &pos,
+                                     (lfring_index_t)(pos + 1), 0,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+      /* Another producer claimed it; pos now holds the new put_ptr. */
+    } else {
+      lfring_index_t cur = __atomic_load_n(&r->put_ptr, __ATOMIC_RELAXED);
+      if(cur == pos) {
+        /* The element has not been consumed yet: the ring is full. */
+        return 0;
+      }
+      pos = cur;
+    }
+  }
+
+  memcpy(ELEM(r, pos), elem, r->elem_size);
+  __atomic_store_n(seq, SEQ_TO_STORED(r, pos, pos + 1), __ATOMIC_RELEASE);
+  return 1;
+}
+#endif /* LFRING_MP_SUPPORTED */
+/*---------------------------------------------------------------------------*/
+/* Number of elements ready for the consumer, at most n. */
+static int
+available(struct lfring *r, int n)
+{
+  lfring_index_t pos;
+  int i;
+
+  if(r->seq == NULL) {
+    i = (lfring_index_t)(LOAD_ACQUIRE(&r->put_ptr) - r->get_ptr);
+    return i < n ? i : n;
+  }
+
+  /* Multi-producer: elements may be completed out of order, so stop at
+     the first one that has not been written yet. */
+  pos = r->get_ptr;
+  for(i = 0; i < n; i++, pos++) {
+    if(STORED_TO_SEQ(r, pos, LOAD_ACQUIRE(&r->seq[pos & r->mask])) !=
+       (lfring_index_t)(pos + 1)) {
+      break;
+    }
+  }
+  return i;
+}
+/*---------------------------------------------------------------------------*/
+/* Give n elements back to the producers. */
+static void
+release(struct lfring *r, int n)
+{
+  lfring_index_t pos;
+  int i;
+
+  if(r->seq != NULL) {
+    pos = r->get_ptr;
+    for(i = 0; i < n; i++, pos++) {
+      STORE_RELEASE(&r->seq[pos & r->mask],
+                    SEQ_TO_STORED(r, pos, pos + r->mask + 1));
+    }
+  }
+  STORE_RELEASE(&r->get_ptr, (lfring_index_t)(r->get_ptr + n));
+}
+/*---------------------------------------------------------------------------*/
+void *
+lfring_peek_get(struct lfring *r)
+{
+  if(available(r, 1) == 0) {
+    return NULL;
+  }
+  return ELEM(r, r->get_ptr);
+}
+/*---------------------------------------------------------------------------*/
+void
+lfring_commit_get(struct lfring *r)
+{
+  release(r, 1);
+}
+/*---------------------------------------------------------------------------*/
+int
+lfring_get(struct lfring *r, void *elem)
+{
+  return lfring_get_bulk(r, elem, 1);
+}
+/*---------------------------------------------------------------------------*/
+int
+lfring_get_bulk(struct lfring *r, void *elems, int n)
+{
+  int first;
+
+  n = available(r, n);
+  if(n <= 0) {
+    return 0;
+  }
+
+  first = r->mask + 1 - (r->get_ptr & r->mask);
+  if(first > n) {
+    first = n;
+  }
+  memcpy(elems, ELEM(r, r->get_ptr), first * r->elem_size);
+  if(n > first) {
+    memcpy((uint8_t *)elems + first * r->elem_size, r->data,
+           (n - first) * r->elem_size);
+  }
+
+  release(r, n);
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+int
+lfring_elements(struct lfring *r)
+{
+  return (lfring_index_t)(LOAD_ACQUIRE(&r->put_ptr) -
+                          LOAD_ACQUIRE(&r->get_ptr));
+}
+/*---------------------------------------------------------------------------*/
+int
+lfring_size(const struct lfring *r)
+{
+  return r->mask + 1;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Lock-free ring of fixed-size elements
+ *
+ *         A ring of fixed-size elements, such as pointers or packet
+ *         descriptors, for handing data from one context to another
+ *         without disabling interrupts: from an interrupt handler to a
+ *         process on an MCU, or between threads on the native platform.
+ *
+ *         A ring declared with LFRING() has a single producer and a
+ *         single consumer. A ring declared with LFRING_MP() may have
+ *         several producers, for instance an interrupt handler and a
+ *         process, and requires atomic compare-and-swap (see
+ *         LFRING_MP_SUPPORTED). In both cases there is one consumer.
+ *
+ *         The indices are free-running lfring_index_t counters that are
+ *         only written by one side each. They must be read and written
+ *         atomically, so on 8-bit MCUs LFRING_CONF_INDEX_TYPE should be
+ *         set to uint8_t. The size must be a power of two, and at most
+ *         half the range of lfring_index_t.
+ */
+
+#ifndef LFRING_H_
+#define LFRING_H_
+
+#include "contiki-conf.h"
+#include "sys/cc.h"
+
+#ifdef LFRING_CONF_INDEX_TYPE
+typedef LFRING_CONF_INDEX_TYPE lfring_index_t;
+#else
+typedef uint16_t lfring_index_t;
+#endif
+
+#if defined(__GCC_ATOMIC_INT_LOCK_FREE) && __GCC_ATOMIC_INT_LOCK_FREE == 2
+#define LFRING_MP_SUPPORTED 1
+#else
+#define LFRING_MP_SUPPORTED 0
+#endif
+
+struct lfring {
+  void *data;
+  /* Per-element sequence numbers of multi-producer rings, else NULL. */
+  lfring_index_t *seq;
+  unsigned short elem_size;
+  lfring_index_t mask;
+  lfring_index_t put_ptr;
+  lfring_index_t get_ptr;
+};
+
+/**
+ * \brief Declare a single-producer ring
+ * \param name The name of the ring
+ * \param type The type of the elements
+ * \param size The number of elements, a power of two
+ */
+#define LFRING(name, type, size)                                \
+  static type CC_CONCAT(name,_lfring_data)[size];               \
+  static struct lfring name = { CC_CONCAT(name,_lfring_data),   \
+                                NULL, sizeof(type), (size) - 1 }
+
+/**
+ * \brief Declare a multi-producer ring
+ * \param name The name of the ring
+ * \param type The type of the elements
+ * \param size The number of elements, a power of two
+ */
+#define LFRING_MP(name, type, size)                             \
+  static type CC_CONCAT(name,_lfring_data)[size];               \
+  static lfring_index_t CC_CONCAT(name,_lfring_seq)[size];      \
+  static struct lfring name = { CC_CONCAT(name,_lfring_data),   \
+                                CC_CONCAT(name,_lfring_seq),    \
+                                sizeof(type), (size) - 1 }
+
+/**
+ * \brief Set up a ring with storage allocated by the caller
+ * \param r Pointer to the ring
+ * \param data Storage for size elements
+ * \param elem_size The size of one element
+ * \param size The number of elements, a power of two
+ * \param seq size sequence numbers for a multi-producer ring, or NULL
+ */
+void lfring_setup(struct lfring *r, void *data, unsigned short elem_size,
+                  lfring_index_t size, lfring_index_t *seq);
+
+/**
+ * \brief Empty a ring. Rings declared with LFRING() or LFRING_MP()
+ *        start out empty, so this is only needed to reuse one.
+ * \param r Pointer to the ring
+ */
+void lfring_init(struct lfring *r);
+
+/**
+ * \brief Copy an element into the ring (single producer)
+ * \retval 1 Success
+ * \retval 0 The ring is full
+ */
+int lfring_put(struct lfring *r, const void *elem);
+
+/**
+ * \brief Copy up to n elements into the ring (single producer)
+ * \return The number of elements put
+ */
+int lfring_put_bulk(struct lfring *r, const void *elems, int n);
+
+/**
+ * \brief Get the element that the next lfring_commit_put() will add,
+ *        to fill it in place (single producer)
+ * \return A pointer to the element, or NULL if the ring is full
+ */
+void *lfring_peek_put(struct lfring *r);
+
+/**
+ * \brief Add the element returned by lfring_peek_put() (single producer)
+ */
+void lfring_commit_put(struct lfring *r);
+
+#if LFRING_MP_SUPPORTED
+/**
+ * \brief Copy an element into a multi-producer ring. May be called
+ *        concurrently from several threads or interrupt levels.
+ * \retval 1 Success
+ * \retval 0 The ring is full
+ */
+int lfring_mp_put(struct lfring *r, const void *elem);
+#endif /* LFRING_MP_SUPPORTED */
+
+/**
+ * \brief Copy the first element out of the ring and remove it
+ * \retval 1 Success
+ * \retval 0 The ring is empty
+ */
+int lfring_get(struct lfring *r, void *elem);
+
+/**
+ * \brief Copy up to n elements out of the ring and remove them
+ * \return The number of elements got
+ */
+int lfring_get_bulk(struct lfring *r, void *elems, int n);
+
+/**
+ * \brief Get the first element in place, without removing it
+ * \return A pointer to the element, or NULL if the ring is empty
+ */
+void *lfring_peek_get(struct lfring *r);
+
+/**
+ * \brief Remove the element returned by lfring_peek_get()
+ */
+void lfring_commit_get(struct lfring *r);
+
+/**
+ * \brief Return the number of elements in the ring. Only exact when
+ *        called by the consumer of a single-producer ring.
+ */
+int lfring_elements(struct lfring *r);
+
+/**
+ * \brief Return the number of elements the ring can hold
+ */
+int lfring_size(const struct lfring *r);
+
+#endif /* LFRING_H_ */
@@ -53,6 +53,30 @@ memb_init(struct memb *m)
 {
   memset(m->count, 0, m->num);
   memset(m->mem, 0, m->size * m->num);
+#if MEMB_WITH_FREELIST
+  if(m->next != NULL) {
+    m->free_head = m->fresh = m->nused = 0;
+  }
+#endif /* MEMB_WITH_FREELIST */
+#if MEMB_WITH_STATS
+  m->used = m->hwm = m->failures = 0;
+#endif /* MEMB_WITH_STATS */
+}
+/*---------------------------------------------------------------------------*/
+/* Index of the chunk ptr points to, or -1 if it is not one. */
+static int
+chunk_index(struct memb *m, void *ptr)
+{
+  unsigned long offset;
+
+  if(!memb_inmemb(m, ptr)) {
+    return -1;
+  }
+  offset = (char *)ptr - (char *)m->mem;
+  if(offset % m->size != 0) {
+    return -1;
+  }
+  return offset / m->size;
 }
 /*---------------------------------------------------------------------------*/
 void *
@@ -60,44 +84,79 @@ memb_alloc(struct memb *m)
 {
   int i;
 
+#if MEMB_WITH_FREELIST
+  if(m->next != NULL) {
+    if(m->free_head != 0) {
+      i = m->free_head - 1;
+      m->free_head = m->next[i];
+    } else if(m->fresh < m->num) {
+      i = m->fresh++;
+    } else {
+      goto failed;
+    }
+    ++m->nused;
+    goto found;
+  }
+#endif /* MEMB_WITH_FREELIST */
+
   for(i = 0; i < m->num; ++i) {
     if(m->count[i] == 0) {
-      /* If this block was unused, we increase the reference count to
-	 indicate that it now is used and return a pointer to the
-	 memory block. */
-      ++(m->count[i]);
-      return (void *)((char *)m->mem + (i * m->size));
+      goto found;
     }
   }
 
+#if MEMB_WITH_FREELIST
+failed:
+#endif /* MEMB_WITH_FREELIST */
   /* No free block was found, so we return NULL to indicate failure to
      allocate block. */
+#if MEMB_WITH_STATS
+  ++m->failures;
+#endif /* MEMB_WITH_STATS */
   return NULL;
+
+found:
+  /* If this block was unused, we increase the reference count to
+     indicate that it now is used and return a pointer to the
+     memory block. */
+  ++(m->count[i]);
+#if MEMB_WITH_STATS
+  if(++m->used > m->hwm) {
+    m->hwm = m->used;
+  }
+#endif /* MEMB_WITH_STATS */
+  return (void *)((char *)m->mem + (i * m->size));
 }
 /*---------------------------------------------------------------------------*/
 char
 memb_free(struct memb *m, void *ptr)
 {
   int i;
-  char *ptr2;
 
-  /* Walk through the list of blocks and try to find the block to
-     which the pointer "ptr" points to. */
-  ptr2 = (char *)m->mem;
-  for(i = 0; i < m->num; ++i) {
-    
-    if(ptr2 == (char *)ptr) {
-      /* We've found to block to which "ptr" points so we decrease the
-	 reference count and return the new value of it. */
-      if(m->count[i] > 0) {
-	/* Make sure that we don't deallocate free memory. */
-	--(m->count[i]);
+  /* Find the block to which the pointer "ptr" points. */
+  i = chunk_index(m, ptr);
+  if(i < 0) {
+    return -1;
+  }
+
+  /* Decrease the reference count and return the new value of it. */
+  if(m->count[i] > 0) {
+    /* Make sure that we don't deallocate free memory. */
+    --(m->count[i]);
+    if(m->count[i] == 0) {
+#if MEMB_WITH_FREELIST
+      if(m->next != NULL) {
+        m->next[i] = m->free_head;
+        m->free_head = i + 1;
+        --m->nused;
       }
-      return m->count[i];
+#endif /* MEMB_WITH_FREELIST */
+#if MEMB_WITH_STATS
+      --m->used;
+#endif /* MEMB_WITH_STATS */
     }
-    ptr2 += m->size;
   }
-  return -1;
+  return m->count[i];
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -113,6 +172,12 @@ memb_numfree(struct memb *m)
   int i;
   int num_free = 0;
 
+#if MEMB_WITH_FREELIST
+  if(m->next != NULL) {
+    return m->num - m->nused;
+  }
+#endif /* MEMB_WITH_FREELIST */
+
   for(i = 0; i < m->num; ++i) {
     if(m->count[i] == 0) {
       ++num_free;
@@ -65,6 +65,28 @@
 
 #include "sys/cc.h"
 
+/*
+ * With MEMB_CONF_WITH_FREELIST, pools declared with MEMB_FREELIST()
+ * keep a list of their free blocks, so that memb_alloc() does not
+ * search for one. The links are kept in a separate array, so the
+ * contents of freed blocks are left untouched.
+ */
+#ifdef MEMB_CONF_WITH_FREELIST
+#define MEMB_WITH_FREELIST MEMB_CONF_WITH_FREELIST
+#else
+#define MEMB_WITH_FREELIST 0
+#endif
+
+/*
+ * With MEMB_CONF_WITH_STATS, each pool counts its blocks in use, the
+ * high-water mark of that number, and failed allocations.
+ */
+#ifdef MEMB_CONF_WITH_STATS
+#define MEMB_WITH_STATS MEMB_CONF_WITH_STATS
+#else
+#define MEMB_WITH_STATS 0
+#endif
+
 /**
  * Declare a memory block.
  *
@@ -93,11 +115,44 @@ MEMB(connections, struct connection, 16);
                                           CC_CONCAT(name,_memb_count), \
                                           (void *)CC_CONCAT(name,_memb_mem)}
 
+/**
+ * Declare a memory block with constant time allocation.
+ *
+ * Same as MEMB(), but with MEMB_CONF_WITH_FREELIST set, memb_alloc()
+ * and memb_numfree() take constant time instead of searching the
+ * block, at the cost of an unsigned short per chunk. Meant for large
+ * pools; without MEMB_CONF_WITH_FREELIST it is the same as MEMB().
+ */
+#if MEMB_WITH_FREELIST
+#define MEMB_FREELIST(name, structure, num) \
+        static char CC_CONCAT(name,_memb_count)[num]; \
+        static structure CC_CONCAT(name,_memb_mem)[num]; \
+        static unsigned short CC_CONCAT(name,_memb_next)[num]; \
+        static struct memb name = {sizeof(structure), num, \
+                                          CC_CONCAT(name,_memb_count), \
+                                          (void *)CC_CONCAT(name,_memb_mem), \
+                                          CC_CONCAT(name,_memb_next)}
+#else /* MEMB_WITH_FREELIST */
+#define MEMB_FREELIST(name, structure, num) MEMB(name, structure, num)
+#endif /* MEMB_WITH_FREELIST */
+
 struct memb {
   unsigned short size;
   unsigned short num;
   char *count;
   void *mem;
+#if MEMB_WITH_FREELIST
+  /* Links of the list of freed chunks, NULL when the block was
+     declared with MEMB(). Links and free_head hold an index plus one,
+     zero ending the list. Chunks from fresh on have never been
+     allocated and are not on the list, so a block in zeroed memory is
+     ready for use, as with MEMB(). */
+  unsigned short *next;
+  unsigned short free_head, fresh, nused;
+#endif /* MEMB_WITH_FREELIST */
+#if MEMB_WITH_STATS
+  unsigned short used, hwm, failures;
+#endif /* MEMB_WITH_STATS */
 };
 
 /**
@@ -49,15 +49,166 @@
 #include "contiki-conf.h"
 #include <string.h>
 
+#if MMEM_STATS
+#include "sys/rtimer.h"
+#endif /* MMEM_STATS */
+
 #ifdef MMEM_CONF_SIZE
 #define MMEM_SIZE MMEM_CONF_SIZE
 #else
 #define MMEM_SIZE 4096
 #endif
 
+/* Number of size classes of free blocks. Class n holds blocks of at
+   least MIN_SIZE << n bytes; the last class holds all larger ones. */
+#ifdef MMEM_CONF_CLASSES
+#define MMEM_CLASSES MMEM_CONF_CLASSES
+#else
+#define MMEM_CLASSES 8
+#endif
+
 LIST(mmemlist);
 unsigned int avail_memory;
+
+#if MMEM_SEGREGATED
+/* A free block. It is stored in the free memory itself, so all
+   blocks are rounded up to a multiple of its size. */
+struct free_block {
+  struct free_block *next;
+  unsigned int size;
+};
+
+#define MIN_SIZE sizeof(struct free_block)
+#define BLOCK_SIZE(size) \
+  ((((size) > 0 ? (size) : 1) + MIN_SIZE - 1) / MIN_SIZE * MIN_SIZE)
+
+static struct free_block memory[MMEM_SIZE / sizeof(struct free_block)];
+#define ARENA ((char *)memory)
+#define ARENA_SIZE sizeof(memory)
+
+static struct free_block *free_lists[MMEM_CLASSES];
+/* Offset of the unused memory at the end of the arena. */
+static unsigned int top;
+#else /* MMEM_SEGREGATED */
 static char memory[MMEM_SIZE];
+#endif /* MMEM_SEGREGATED */
+
+#if MMEM_STATS
+static struct mmem_stats stats;
+static rtimer_clock_t stall_start;
+
+#define STALL_BEGIN() stall_start = RTIMER_NOW()
+/*---------------------------------------------------------------------------*/
+static void
+stall_end(unsigned int moved)
+{
+  unsigned long t;
+
+  t = (rtimer_clock_t)(RTIMER_NOW() - stall_start);
+  if(t > stats.max_stall) {
+    stats.max_stall = t;
+  }
+  stats.compactions++;
+  stats.moved += moved;
+}
+#else /* MMEM_STATS */
+#define STALL_BEGIN()
+#define stall_end(moved) ((void)(moved))
+#endif /* MMEM_STATS */
+
+#if MMEM_SEGREGATED
+/*---------------------------------------------------------------------------*/
+static int
+size_class(unsigned int size)
+{
+  int c;
+
+  for(c = 0; c < MMEM_CLASSES - 1 && size >= (MIN_SIZE << (c + 1)); c++);
+  return c;
+}
+/*---------------------------------------------------------------------------*/
+static void
+put_free(char *ptr, unsigned int size)
+{
+  struct free_block *b;
+  int c;
+
+  if(ptr + size == ARENA + top) {
+    /* The block is at the end of the used memory, so give it back to
+       the unused memory instead. */
+    top -= size;
+    return;
+  }
+
+  b = (struct free_block *)ptr;
+  b->size = size;
+  c = size_class(size);
+  b->next = free_lists[c];
+  free_lists[c] = b;
+}
+/*---------------------------------------------------------------------------*/
+static char *
+get_free(unsigned int size)
+{
+  struct free_block **bp;
+  struct free_block *b;
+  int c;
+
+  /* Blocks in the class of the requested size may be too small, but
+     all blocks in the larger classes are large enough. */
+  c = size_class(size);
+  for(bp = &free_lists[c]; *bp != NULL; bp = &(*bp)->next) {
+    if((*bp)->size >= size) {
+      goto found;
+    }
+  }
+  for(c++; c < MMEM_CLASSES; c++) {
+    if(free_lists[c] != NULL) {
+      bp = &free_lists[c];
+      goto found;
+    }
+  }
+  return NULL;
+
+found:
+  b = *bp;
+  *bp = b->next;
+  if(b->size > size) {
+    put_free((char *)b + size, b->size - size);
+  }
+  return (char *)b;
+}
+/*---------------------------------------------------------------------------*/
+void
+mmem_compact(void)
+{
+  struct mmem *n;
+  char *dst;
+  unsigned int size;
+  unsigned int moved;
+
+  STALL_BEGIN();
+
+  /* The list of allocations is kept sorted by address, so moving each
+     block down to the end of the previous one never overwrites a
+     block that is yet to be moved. */
+  moved = 0;
+  dst = ARENA;
+  for(n = list_head(mmemlist); n != NULL; n = n->next) {
+    size = BLOCK_SIZE(n->size);
+    if(n->ptr != dst) {
+      memmove(dst, n->ptr, size);
+      n->ptr = dst;
+      moved += size;
+    }
+    dst += size;
+  }
+  top = dst - ARENA;
+  memset(free_lists, 0, sizeof(free_lists));
+
+  stall_end(moved);
+}
+#endif /* MMEM_SEGREGATED */
 
 /*---------------------------------------------------------------------------*/
 /**
@@ -82,8 +233,51 @@ static char memory[MMEM_SIZE];
 int
 mmem_alloc(struct mmem *m, unsigned int size)
 {
+#if MMEM_SEGREGATED
+  unsigned int block_size;
+  char *ptr;
+  struct mmem *n;
+  struct mmem *prev;
+
+  block_size = BLOCK_SIZE(size);
+  if(avail_memory < block_size) {
+#if MMEM_STATS
+    stats.failures++;
+#endif /* MMEM_STATS */
+    return 0;
+  }
+
+  ptr = get_free(block_size);
+  if(ptr == NULL) {
+    if(ARENA_SIZE - top < block_size) {
+      /* The free memory is in pieces that are too small. There is
+         always room at the end after compacting, since no memory is
+         lost when splitting blocks. */
+      mmem_compact();
+    }
+    ptr = ARENA + top;
+    top += block_size;
+  }
+
+  m->ptr = ptr;
+  m->size = size;
+  avail_memory -= block_size;
+
+  /* Keep the list sorted by address for mmem_compact(). */
+  prev = NULL;
+  for(n = list_head(mmemlist);
+      n != NULL && (char *)n->ptr < ptr;
+      n = n->next) {
+    prev = n;
+  }
+  list_insert(mmemlist, prev, m);
+  return 1;
+#else /* MMEM_SEGREGATED */
   /* Check if we have enough memory left for this allocation. */
   if(avail_memory < size) {
+#if MMEM_STATS
+    stats.failures++;
+#endif /* MMEM_STATS */
     return 0;
   }
 
@@ -104,6 +298,7 @@ mmem_alloc(struct mmem *m, unsigned int size)
   /* Return non-zero to indicate that we were able to allocate
      memory. */
   return 1;
+#endif /* MMEM_SEGREGATED */
 }
 /*---------------------------------------------------------------------------*/
 /**
@@ -118,9 +313,26 @@ mmem_alloc(struct mmem *m, unsigned int size)
 void
 mmem_free(struct mmem *m)
 {
+#if MMEM_SEGREGATED
+  unsigned int block_size;
+
+  list_remove(mmemlist, m);
+
+  block_size = BLOCK_SIZE(m->size);
+  avail_memory += block_size;
+  if(list_head(mmemlist) == NULL) {
+    /* Nothing left to move, so start over with all memory unused. */
+    top = 0;
+    memset(free_lists, 0, sizeof(free_lists));
+  } else {
+    put_free(m->ptr, block_size);
+  }
+#else /* MMEM_SEGREGATED */
   struct mmem *n;
 
   if(m->next != NULL) {
+    STALL_BEGIN();
+
     /* Compact the memory after the allocation that is to be removed
        by moving it downwards. */
     memmove(m->ptr, m->next->ptr,
@@ -131,12 +343,16 @@ mmem_free(struct mmem *m)
     for(n = m->next; n != NULL; n = n->next) {
       n->ptr = (void *)((char *)n->ptr - m->size);
     }
+
+    stall_end(&memory[MMEM_SIZE - avail_memory] - (char *)m->ptr -
+              m->size);
   }
 
   avail_memory += m->size;
 
   /* Remove the memory block from the list. */
   list_remove(mmemlist, m);
+#endif /* MMEM_SEGREGATED */
 }
 /*---------------------------------------------------------------------------*/
 /**
@@ -156,9 +372,41 @@ mmem_init(void)
     return;
   }
   list_init(mmemlist);
+#if MMEM_SEGREGATED
+  avail_memory = ARENA_SIZE;
+  top = 0;
+  memset(free_lists, 0, sizeof(free_lists));
+#else /* MMEM_SEGREGATED */
   avail_memory = MMEM_SIZE;
+#endif /* MMEM_SEGREGATED */
   inited = 1;
 }
 /*---------------------------------------------------------------------------*/
+#if MMEM_STATS
+void
+mmem_stats(struct mmem_stats *s)
+{
+#if MMEM_SEGREGATED
+  struct free_block *b;
+  int c;
+#endif /* MMEM_SEGREGATED */
+
+  *s = stats;
+  s->avail = avail_memory;
+#if MMEM_SEGREGATED
+  s->largest = ARENA_SIZE - top;
+  for(c = 0; c < MMEM_CLASSES; c++) {
+    for(b = free_lists[c]; b != NULL; b = b->next) {
+      if(b->size > s->largest) {
+        s->largest = b->size;
+      }
+    }
+  }
+#else /* MMEM_SEGREGATED */
+  s->largest = avail_memory;
+#endif /* MMEM_SEGREGATED */
+}
+/*---------------------------------------------------------------------------*/
+#endif /* MMEM_STATS */
 
 /** @} */
@@ -59,6 +59,29 @@
 #ifndef MMEM_H_
 #define MMEM_H_
 
+#include "contiki-conf.h"
+
+/*
+ * With MMEM_CONF_SEGREGATED, freed blocks are kept on free lists
+ * sorted into size classes instead of being compacted at once, so
+ * mmem_free() takes constant time. The memory is compacted only when
+ * an allocation does not fit anywhere else, or when mmem_compact() is
+ * called. As before, blocks may move on any call to mmem_alloc().
+ */
+#ifdef MMEM_CONF_SEGREGATED
+#define MMEM_SEGREGATED MMEM_CONF_SEGREGATED
+#else
+#define MMEM_SEGREGATED 0
+#endif
+
+/* With MMEM_CONF_STATS, mmem_stats() reports fragmentation and the
+   time spent moving memory around. */
+#ifdef MMEM_CONF_STATS
+#define MMEM_STATS MMEM_CONF_STATS
+#else
+#define MMEM_STATS 0
+#endif
+
 /*---------------------------------------------------------------------------*/
 /**
  * \brief      Get a pointer to the managed memory
@@ -87,6 +110,43 @@ int  mmem_alloc(struct mmem *m, unsigned int size);
 void mmem_free(struct mmem *);
 void mmem_init(void);
 
+#if MMEM_SEGREGATED
+/**
+ * \brief      Compact the managed memory
+ *
+ *             Moves all allocated blocks to the start of the memory,
+ *             merging the free space into one block. mmem_alloc()
+ *             does this when needed, but it can be called when the
+ *             system is idle to avoid a stall later on.
+ */
+void mmem_compact(void);
+#endif /* MMEM_SEGREGATED */
+
+#if MMEM_STATS
+struct mmem_stats {
+  /** Bytes not allocated. */
+  unsigned int avail;
+  /** Largest block that can be allocated without moving memory. */
+  unsigned int largest;
+  /** Number of times memory was moved, and the bytes moved. */
+  unsigned int compactions;
+  unsigned long moved;
+  /** Number of failed allocations. */
+  unsigned int failures;
+  /** Longest time spent moving memory in one call, in rtimer ticks. */
+  unsigned long max_stall;
+};
+
+/**
+ * \brief      Get statistics of the managed memory
+ * \param s    A pointer to a struct mmem_stats to fill in
+ *
+ *             The difference between avail and largest is the memory
+ *             lost to fragmentation.
+ */
+void mmem_stats(struct mmem_stats *s);
+#endif /* MMEM_STATS */
+
 #endif /* MMEM_H_ */
 
 /** @} */
@@ -41,6 +41,7 @@
 #include "contiki-net.h"
 #include "net/ip/uip-split.h"
 #include "net/ip/uip-packetqueue.h"
+#include "sys/trace.h"
 
 #if NETSTACK_CONF_WITH_IPV6
 #include "net/ipv6/uip-nd6.h"
@@ -116,6 +117,26 @@ enum {
 
 static uint8_t (* outputfunc)(const uip_lladdr_t *a);
 
+/* Number of destinations for which tcpip_ipv6_output() remembers the
+   next-hop neighbor. A cached entry is valid as long as no route,
+   default router, prefix or neighbor has been added or removed since
+   it was made; 0 disables the cache. */
+#ifdef TCPIP_CONF_NEXTHOP_CACHE_SIZE
+#define TCPIP_NEXTHOP_CACHE_SIZE TCPIP_CONF_NEXTHOP_CACHE_SIZE
+#else
+#define TCPIP_NEXTHOP_CACHE_SIZE 4
+#endif
+
+#if TCPIP_NEXTHOP_CACHE_SIZE > 0
+struct nexthop_cache_entry {
+  uip_ipaddr_t destipaddr;
+  uip_ds6_nbr_t *nbr;
+  uint16_t generation;
+};
+static struct nexthop_cache_entry nexthop_cache[TCPIP_NEXTHOP_CACHE_SIZE];
+static uint8_t nexthop_cache_next;
+#endif /* TCPIP_NEXTHOP_CACHE_SIZE > 0 */
+
 uint8_t
 tcpip_output(const uip_lladdr_t *a)
 {
@@ -202,7 +223,9 @@ packet_input(void)
 #endif /* UIP_CONF_IP_FORWARD */
 
     check_for_tcp_syn();
+    TRACE(TRACE_UIP_INPUT_BEGIN, uip_len, 0, 0);
     uip_input();
+    TRACE(TRACE_UIP_INPUT_END, uip_len, 0, 0);
     if(uip_len > 0) {
 #if UIP_CONF_TCP_SPLIT
       uip_split_output();
@@ -526,16 +549,49 @@ tcpip_input(void)
 }
 /*---------------------------------------------------------------------------*/
 #if NETSTACK_CONF_WITH_IPV6
+#if TCPIP_NEXTHOP_CACHE_SIZE > 0
+static uip_ds6_nbr_t *
+nexthop_cache_lookup(const uip_ipaddr_t *destipaddr)
+{
+  struct nexthop_cache_entry *e;
+
+  for(e = nexthop_cache; e < nexthop_cache + TCPIP_NEXTHOP_CACHE_SIZE; e++) {
+    if(e->nbr != NULL && e->generation == uip_ds6_nexthop_generation &&
+       uip_ipaddr_cmp(&e->destipaddr, destipaddr)) {
+      return e->nbr;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+nexthop_cache_add(const uip_ipaddr_t *destipaddr, uip_ds6_nbr_t *nbr)
+{
+  struct nexthop_cache_entry *e;
+
+  e = &nexthop_cache[nexthop_cache_next];
+  nexthop_cache_next = (nexthop_cache_next + 1) % TCPIP_NEXTHOP_CACHE_SIZE;
+  uip_ipaddr_copy(&e->destipaddr, destipaddr);
+  e->nbr = nbr;
+  e->generation = uip_ds6_nexthop_generation;
+}
+#endif /* TCPIP_NEXTHOP_CACHE_SIZE > 0 */
+/*---------------------------------------------------------------------------*/
 void
 tcpip_ipv6_output(void)
 {
   uip_ds6_nbr_t *nbr = NULL;
   uip_ipaddr_t *nexthop = NULL;
+#if TCPIP_NEXTHOP_CACHE_SIZE > 0
+  uint8_t cacheable = 0;
+#endif /* TCPIP_NEXTHOP_CACHE_SIZE > 0 */
 
   if(uip_len == 0) {
     return;
   }
 
+  TRACE(TRACE_UIP_OUTPUT, uip_len, 0, 0);
+
   if(uip_len > UIP_LINK_MTU) {
     UIP_LOG("tcpip_ipv6_output: Packet to big");
     uip_clear_buf();
@@ -570,6 +626,19 @@ tcpip_ipv6_output(void)
 
     nbr = NULL;
 
+#if TCPIP_NEXTHOP_CACHE_SIZE > 0
+    /* Recently used destinations skip the route and neighbor lookups
+       below as long as the cached next-hop is still valid. */
+    if(nexthop == NULL) {
+      nbr = nexthop_cache_lookup(&UIP_IP_BUF->destipaddr);
+      if(nbr != NULL) {
+        nexthop = &nbr->ipaddr;
+      } else {
+        cacheable = 1;
+      }
+    }
+#endif /* TCPIP_NEXTHOP_CACHE_SIZE > 0 */
+
     /* We first check if the destination address is on our immediate
        link. If so, we simply use the destination address as our
        nexthop address. */
@@ -660,7 +729,9 @@ tcpip_ipv6_output(void)
 
     /* End of next hop determination */
 
-    nbr = uip_ds6_nbr_lookup(nexthop);
+    if(nbr == NULL) {
+      nbr = uip_ds6_nbr_lookup(nexthop);
+    }
     if(nbr == NULL) {
 #if UIP_ND6_SEND_NS
       if((nbr = uip_ds6_nbr_add(nexthop, NULL, 0, NBR_INCOMPLETE, NBR_TABLE_REASON_IPV6_ND, NULL)) == NULL) {
@@ -670,10 +741,7 @@ tcpip_ipv6_output(void)
       } else {
 #if UIP_CONF_IPV6_QUEUE_PKT
         /* Copy outgoing pkt in the queuing buffer for later transmit. */
-        if(uip_packetqueue_alloc(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME) != NULL) {
-          memcpy(uip_packetqueue_buf(&nbr->packethandle), UIP_IP_BUF, uip_len);
-          uip_packetqueue_set_buflen(&nbr->packethandle, uip_len);
-        }
+        uip_packetqueue_alloc(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME);
 #endif
         /* RFC4861, 7.2.2:
          * "If the source address of the packet prompting the solicitation is the
@@ -689,6 +757,7 @@ tcpip_ipv6_output(void)
 
         stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
         nbr->nscount = 1;
+        uip_ds6_nbr_schedule(nbr);
         /* Send the first NS try from here (multicast destination IP address). */
       }
 #else /* UIP_ND6_SEND_NS */
@@ -703,10 +772,7 @@ tcpip_ipv6_output(void)
 #if UIP_CONF_IPV6_QUEUE_PKT
         /* Copy outgoing pkt in the queuing buffer for later transmit and set
            the destination nbr to nbr. */
-        if(uip_packetqueue_alloc(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME) != NULL) {
-          memcpy(uip_packetqueue_buf(&nbr->packethandle), UIP_IP_BUF, uip_len);
-          uip_packetqueue_set_buflen(&nbr->packethandle, uip_len);
-        }
+        uip_packetqueue_alloc(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME);
 #endif /*UIP_CONF_IPV6_QUEUE_PKT*/
         uip_clear_buf();
         return;
@@ -717,10 +783,17 @@ tcpip_ipv6_output(void)
         nbr->state = NBR_DELAY;
         stimer_set(&nbr->reachable, UIP_ND6_DELAY_FIRST_PROBE_TIME);
         nbr->nscount = 0;
+        uip_ds6_nbr_schedule(nbr);
         PRINTF("tcpip_ipv6_output: nbr cache entry stale moving to delay\n");
       }
 #endif /* UIP_ND6_SEND_NS */
 
+#if TCPIP_NEXTHOP_CACHE_SIZE > 0
+      if(cacheable) {
+        nexthop_cache_add(&UIP_IP_BUF->destipaddr, nbr);
+      }
+#endif /* TCPIP_NEXTHOP_CACHE_SIZE > 0 */
+
       tcpip_output(uip_ds6_nbr_get_ll(nbr));
 
 #if UIP_CONF_IPV6_QUEUE_PKT
@@ -728,12 +801,9 @@ tcpip_ipv6_output(void)
        * Send the queued packets from here, may not be 100% perfect though.
        * This happens in a few cases, for example when instead of receiving a
        * NA after sendiong a NS, you receive a NS with SLLAO: the entry moves
-       * to STALE, and you must both send a NA and the queued packet.
+       * to STALE, and you must both send a NA and the queued packets.
        */
-      if(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
-        uip_len = uip_packetqueue_buflen(&nbr->packethandle);
-        memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
-        uip_packetqueue_free(&nbr->packethandle);
+      while(uip_packetqueue_to_uipbuf(&nbr->packethandle)) {
         tcpip_output(uip_ds6_nbr_get_ll(nbr));
       }
 #endif /*UIP_CONF_IPV6_QUEUE_PKT*/
@@ -6,7 +6,7 @@
 
 #include "net/ip/uip-packetqueue.h"
 
-#define MAX_NUM_QUEUED_PACKETS 2
+#define MAX_NUM_QUEUED_PACKETS UIP_PKTBUF_NUM
 MEMB(packets_memb, struct uip_packetqueue_packet, MAX_NUM_QUEUED_PACKETS);
 
 #define DEBUG 0
@@ -17,15 +17,33 @@ MEMB(packets_memb, struct uip_packetqueue_packet, MAX_NUM_QUEUED_PACKETS);
 #define PRINTF(...)
 #endif
 
+/*---------------------------------------------------------------------------*/
+static void
+packet_remove(struct uip_packetqueue_packet *p)
+{
+  struct uip_packetqueue_handle *h = p->handle;
+  struct uip_packetqueue_packet **pp;
+
+  for(pp = &h->packet; *pp != NULL; pp = &(*pp)->next) {
+    if(*pp == p) {
+      *pp = p->next;
+      h->len--;
+      break;
+    }
+  }
+  ctimer_stop(&p->lifetimer);
+  uip_pktbuf_free(p->buf);
+  memb_free(&packets_memb, p);
+}
 /*---------------------------------------------------------------------------*/
 static void
 packet_timedout(void *ptr)
 {
-  struct uip_packetqueue_handle *h = ptr;
+  struct uip_packetqueue_packet *p = ptr;
 
-  PRINTF("uip_packetqueue_free timed out %p\n", h);
-  memb_free(&packets_memb, h->packet);
-  h->packet = NULL;
+  PRINTF("uip_packetqueue_free timed out %p\n", p->handle);
+  UIP_STAT(++uip_stat.nd6.qdrop);
+  packet_remove(p);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -33,54 +51,86 @@ uip_packetqueue_new(struct uip_packetqueue_handle *handle)
 {
   PRINTF("uip_packetqueue_new %p\n", handle);
   handle->packet = NULL;
+  handle->len = 0;
 }
 /*---------------------------------------------------------------------------*/
 struct uip_packetqueue_packet *
 uip_packetqueue_alloc(struct uip_packetqueue_handle *handle, clock_time_t lifetime)
 {
+  struct uip_packetqueue_packet *p, **pp;
+
   PRINTF("uip_packetqueue_alloc %p\n", handle);
-  if(handle->packet != NULL) {
-    PRINTF("alloced\n");
+  if(handle->len >= UIP_PACKETQUEUE_MAX_PER_HANDLE) {
+    PRINTF("queue full\n");
+    UIP_STAT(++uip_stat.nd6.qdrop);
     return NULL;
   }
-  handle->packet = memb_alloc(&packets_memb);
-  if(handle->packet != NULL) {
-    ctimer_set(&handle->packet->lifetimer, lifetime,
-               packet_timedout, handle);
-  } else {
+  p = memb_alloc(&packets_memb);
+  if(p != NULL) {
+    p->buf = uip_pktbuf_new_from_uipbuf();
+    if(p->buf == NULL) {
+      memb_free(&packets_memb, p);
+      p = NULL;
+    }
+  }
+  if(p == NULL) {
     PRINTF("uip_packetqueue_alloc failed\n");
+    UIP_STAT(++uip_stat.nd6.qdrop);
+    return NULL;
+  }
+  p->handle = handle;
+  p->next = NULL;
+  for(pp = &handle->packet; *pp != NULL; pp = &(*pp)->next);
+  *pp = p;
+  handle->len++;
+  UIP_STAT(++uip_stat.nd6.queued);
+  ctimer_set(&p->lifetimer, lifetime, packet_timedout, p);
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+int
+uip_packetqueue_to_uipbuf(struct uip_packetqueue_handle *handle)
+{
+  if(handle->packet == NULL) {
+    return 0;
   }
-  return handle->packet;
+  uip_pktbuf_to_uipbuf(handle->packet->buf);
+  packet_remove(handle->packet);
+  return 1;
 }
 /*---------------------------------------------------------------------------*/
 void
 uip_packetqueue_free(struct uip_packetqueue_handle *handle)
 {
   PRINTF("uip_packetqueue_free %p\n", handle);
-  if(handle->packet != NULL) {
-    ctimer_stop(&handle->packet->lifetimer);
-    memb_free(&packets_memb, handle->packet);
-    handle->packet = NULL;
+  while(handle->packet != NULL) {
+    packet_remove(handle->packet);
   }
 }
 /*---------------------------------------------------------------------------*/
 uint8_t *
 uip_packetqueue_buf(struct uip_packetqueue_handle *h)
 {
-  return h->packet != NULL? h->packet->queue_buf: NULL;
+  return h->packet != NULL? uip_pktbuf_dataptr(h->packet->buf): NULL;
 }
 /*---------------------------------------------------------------------------*/
 uint16_t
 uip_packetqueue_buflen(struct uip_packetqueue_handle *h)
 {
-  return h->packet != NULL? h->packet->queue_buf_len: 0;
+  return h->packet != NULL? uip_pktbuf_datalen(h->packet->buf): 0;
 }
 /*---------------------------------------------------------------------------*/
 void
 uip_packetqueue_set_buflen(struct uip_packetqueue_handle *h, uint16_t len)
 {
   if(h->packet != NULL) {
-    h->packet->queue_buf_len = len;
+    uip_pktbuf_set_datalen(h->packet->buf, len);
   }
 }
 /*---------------------------------------------------------------------------*/
+int
+uip_packetqueue_len(struct uip_packetqueue_handle *h)
+{
+  return h->len;
+}
+/*---------------------------------------------------------------------------*/
@@ -2,34 +2,52 @@
 #define UIP_PACKETQUEUE_H
 
 #include "sys/ctimer.h"
+#include "net/ip/uip-pktbuf.h"
+
+/* Maximum number of packets queued on one handle (i.e. one neighbor) */
+#ifdef UIP_PACKETQUEUE_CONF_MAX_PER_HANDLE
+#define UIP_PACKETQUEUE_MAX_PER_HANDLE UIP_PACKETQUEUE_CONF_MAX_PER_HANDLE
+#else
+#define UIP_PACKETQUEUE_MAX_PER_HANDLE 4
+#endif
 
 struct uip_packetqueue_handle;
 
 struct uip_packetqueue_packet {
-  struct uip_ds6_queued_packet *next;
-  uint8_t queue_buf[UIP_BUFSIZE - UIP_LLH_LEN];
-  uint16_t queue_buf_len;
+  struct uip_packetqueue_packet *next;
+  struct uip_pktbuf *buf;
   struct ctimer lifetimer;
   struct uip_packetqueue_handle *handle;
 };
 
 struct uip_packetqueue_handle {
-  struct uip_packetqueue_packet *packet;
+  struct uip_packetqueue_packet *packet; /* oldest packet, sent first */
+  uint8_t len;
 };
 
 void uip_packetqueue_new(struct uip_packetqueue_handle *handle);
 
 
+/* Append the packet in uip_buf to the queue; its storage comes from the
+   shared uip_pktbuf pool. Returns NULL, and counts a drop, if the queue
+   or the pool is full. */
 struct uip_packetqueue_packet *
 uip_packetqueue_alloc(struct uip_packetqueue_handle *handle, clock_time_t lifetime);
 
+/* Move the oldest queued packet, if any, into uip_buf; returns 1 if one
+   was moved */
+int uip_packetqueue_to_uipbuf(struct uip_packetqueue_handle *handle);
 
+/* Drop all packets queued on the handle */
 void
 uip_packetqueue_free(struct uip_packetqueue_handle *handle);
 
+/* Access to the oldest queued packet */
 uint8_t *uip_packetqueue_buf(struct uip_packetqueue_handle *h);
 uint16_t uip_packetqueue_buflen(struct uip_packetqueue_handle *h);
 void uip_packetqueue_set_buflen(struct uip_packetqueue_handle *h, uint16_t len);
 
+int uip_packetqueue_len(struct uip_packetqueue_handle *h);
+
 
 #endif /* UIP_PACKETQUEUE_H */
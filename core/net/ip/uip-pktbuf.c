@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Implementation of the uIP packet buffer pool
+ */
+
+/**
+ * \addtogroup uippktbuf
+ * @{
+ */
+
+#include "net/ip/uip-pktbuf.h"
+#include "lib/memb.h"
+
+#include <string.h>
+
+#define DEBUG 0
+#if DEBUG
+#include <stdio.h>
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
+
+MEMB(pktbuf_memb, struct uip_pktbuf, UIP_PKTBUF_NUM);
+
+/*---------------------------------------------------------------------------*/
+struct uip_pktbuf *
+uip_pktbuf_new_from_uipbuf(void)
+{
+  struct uip_pktbuf *b;
+
+  if(uip_len > sizeof(b->data)) {
+    return NULL;
+  }
+  b = memb_alloc(&pktbuf_memb);
+  if(b == NULL) {
+    PRINTF("uip_pktbuf_new_from_uipbuf: pool exhausted\n");
+    return NULL;
+  }
+  b->len = uip_len;
+  memcpy(b->data, &uip_buf[UIP_LLH_LEN], uip_len);
+  return b;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_pktbuf_to_uipbuf(struct uip_pktbuf *b)
+{
+  if(memb_inmemb(&pktbuf_memb, b)) {
+    memcpy(&uip_buf[UIP_LLH_LEN], b->data, b->len);
+    uip_len = b->len;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_pktbuf_free(struct uip_pktbuf *b)
+{
+  if(memb_inmemb(&pktbuf_memb, b)) {
+    memb_free(&pktbuf_memb, b);
+  }
+}
+/*---------------------------------------------------------------------------*/
+uint8_t *
+uip_pktbuf_dataptr(struct uip_pktbuf *b)
+{
+  return b->data;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+uip_pktbuf_datalen(struct uip_pktbuf *b)
+{
+  return b->len;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_pktbuf_set_datalen(struct uip_pktbuf *b, uint16_t len)
+{
+  b->len = MIN(len, sizeof(b->data));
+}
+/*---------------------------------------------------------------------------*/
+int
+uip_pktbuf_numfree(void)
+{
+  return memb_numfree(&pktbuf_memb);
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \addtogroup uip
+ * @{
+ */
+
+/**
+ * \defgroup uippktbuf uIP packet buffer pool
+ * @{
+ *
+ * The uip_pktbuf module holds IP packets that must outlive the single
+ * global uip_buf. The packet queue of neighbor discovery
+ * (uip-packetqueue) and the IPv4 tunnel's ARP code park packets that
+ * wait for address resolution here; the pool is sized for them with
+ * UIP_PKTBUF_CONF_NUM. Each buffer has a single owner.
+ *
+ * uip_buf stays the working buffer of the stack: a packet is moved
+ * into a pool buffer with uip_pktbuf_new_from_uipbuf() and back with
+ * uip_pktbuf_to_uipbuf() when it is sent.
+ */
+
+/**
+ * \file
+ *         Header file for the uIP packet buffer pool
+ */
+
+#ifndef UIP_PKTBUF_H_
+#define UIP_PKTBUF_H_
+
+#include "net/ip/uip.h"
+
+/* UIP_PKTBUF_NUM is the number of packet buffers in the pool */
+#ifdef UIP_PKTBUF_CONF_NUM
+#define UIP_PKTBUF_NUM UIP_PKTBUF_CONF_NUM
+#else
+#define UIP_PKTBUF_NUM 2
+#endif
+
+struct uip_pktbuf {
+  uint16_t len;
+  uint8_t data[UIP_BUFSIZE - UIP_LLH_LEN];
+};
+
+/**
+ * \brief Allocate a buffer and copy the IP packet in uip_buf into it
+ * \return The buffer, or NULL if the pool is exhausted
+ */
+struct uip_pktbuf *uip_pktbuf_new_from_uipbuf(void);
+
+/**
+ * \brief Copy the packet held by b into uip_buf and set uip_len
+ */
+void uip_pktbuf_to_uipbuf(struct uip_pktbuf *b);
+
+/**
+ * \brief Return b to the pool
+ */
+void uip_pktbuf_free(struct uip_pktbuf *b);
+
+uint8_t *uip_pktbuf_dataptr(struct uip_pktbuf *b);
+uint16_t uip_pktbuf_datalen(struct uip_pktbuf *b);
+void uip_pktbuf_set_datalen(struct uip_pktbuf *b, uint16_t len);
+
+int uip_pktbuf_numfree(void);
+
+#endif /* UIP_PKTBUF_H_ */
+
+/** @} */
+/** @} */
@@ -1490,6 +1490,10 @@ struct uip_stats {
     uip_stats_t drop;     /**< Number of dropped ND6 packets. */
     uip_stats_t recv;     /**< Number of recived ND6 packets */
     uip_stats_t sent;     /**< Number of sent ND6 packets */
+    uip_stats_t queued;   /**< Number of packets queued during address
+                               resolution */
+    uip_stats_t qdrop;    /**< Number of packets dropped from, or not
+                               admitted to, address resolution queues */
   } nd6;
 #endif /*NETSTACK_CONF_WITH_IPV6*/
 };
@@ -46,7 +46,7 @@
 #define NUM_ENTRIES 32
 #endif /* IP64_ADDRMAP_CONF_ENTRIES */
 
-MEMB(entrymemb, struct ip64_addrmap_entry, NUM_ENTRIES);
+MEMB_FREELIST(entrymemb, struct ip64_addrmap_entry, NUM_ENTRIES);
 LIST(entrylist);
 
 #define FIRST_MAPPED_PORT 10000
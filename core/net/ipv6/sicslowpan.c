@@ -66,9 +66,11 @@
 #include "net/ip/tcpip.h"
 #include "net/ip/uip.h"
 #include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/uip-icmp6.h"
 #include "net/rime/rime.h"
 #include "net/ipv6/sicslowpan.h"
 #include "net/netstack.h"
+#include "sys/trace.h"
 
 #include <stdio.h>
 
@@ -484,6 +486,29 @@ set_packet_attrs(void)
 
 }
 
+#if UIP_CONF_IPV6_RPL
+/* RPL control messages are sent in the MAC priority lane so that they
+   are not queued behind forwarded data. A hop-by-hop header in front of
+   the ICMPv6 header is skipped. */
+static int
+is_routing_control(void)
+{
+  uint8_t proto = UIP_IP_BUF->proto;
+  uint16_t offset = UIP_LLIPH_LEN;
+
+  if(proto == UIP_PROTO_HBHO) {
+    if(offset + 2 > UIP_LLH_LEN + uip_len) {
+      return 0;
+    }
+    proto = uip_buf[offset];
+    offset += (uip_buf[offset + 1] << 3) + 8;
+  }
+  return proto == UIP_PROTO_ICMP6 &&
+    offset < UIP_LLH_LEN + uip_len &&
+    ((struct uip_icmp_hdr *)&uip_buf[offset])->type == ICMP6_RPL;
+}
+#endif /* UIP_CONF_IPV6_RPL */
+
 
 
 #if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06
@@ -492,9 +517,21 @@ set_packet_attrs(void)
  */
 
 /** Addresses contexts for IPHC. */
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > SICSLOWPAN_MAX_CONTEXT_NUMBER + 1
+#error "SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS: IPHC supports at most 16 contexts"
+#endif
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
 static struct sicslowpan_addr_context
 addr_contexts[SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS];
+
+/** Contexts usable for compression, sorted by prefix (binary search). */
+static struct sicslowpan_addr_context *
+contexts_by_prefix[SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS];
+static uint8_t contexts_by_prefix_count;
+
+/** Contexts indexed by their identifier, for decompression. */
+static struct sicslowpan_addr_context *
+contexts_by_number[SICSLOWPAN_MAX_CONTEXT_NUMBER + 1];
 #endif
 
 /** pointer to an address context. */
@@ -536,17 +573,61 @@ static const uint8_t ttl_values[] = {0, 1, 64, 255};
 /** \name IPHC related functions
  * @{                                                                 */
 /*--------------------------------------------------------------------*/
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+/** \brief rebuild the lookup indices after the context table changed */
+static void
+addr_context_reindex(void)
+{
+  struct sicslowpan_addr_context *c;
+  int i, j;
+
+  memset(contexts_by_number, 0, sizeof(contexts_by_number));
+  contexts_by_prefix_count = 0;
+  for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
+    c = &addr_contexts[i];
+    if(c->used != 1 || c->number > SICSLOWPAN_MAX_CONTEXT_NUMBER) {
+      continue;
+    }
+    contexts_by_number[c->number] = c;
+    if(!c->compress) {
+      continue;
+    }
+    /* Insertion sort: the table is small and changes rarely */
+    for(j = contexts_by_prefix_count;
+        j > 0 && memcmp(contexts_by_prefix[j - 1]->prefix, c->prefix, 8) > 0;
+        j--) {
+      contexts_by_prefix[j] = contexts_by_prefix[j - 1];
+    }
+    contexts_by_prefix[j] = c;
+    contexts_by_prefix_count++;
+  }
+}
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+/*--------------------------------------------------------------------*/
 /** \brief find the context corresponding to prefix ipaddr */
 static struct sicslowpan_addr_context*
 addr_context_lookup_by_prefix(uip_ipaddr_t *ipaddr)
 {
 /* Remove code to avoid warnings and save flash if no context is used */
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
-  int i;
-  for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
-    if((addr_contexts[i].used == 1) &&
-       uip_ipaddr_prefixcmp(&addr_contexts[i].prefix, ipaddr, 64)) {
-      return &addr_contexts[i];
+  int low, high, mid, cmp;
+
+  /*
+   * Context prefixes are stored zero-padded to 64 bits: the bits not
+   * covered by a shorter prefix are elided as zeroes (RFC 6282), so a
+   * match always compares the full upper 64 bits of the address.
+   */
+  low = 0;
+  high = contexts_by_prefix_count - 1;
+  while(low <= high) {
+    mid = (low + high) / 2;
+    cmp = memcmp(ipaddr->u8, contexts_by_prefix[mid]->prefix, 8);
+    if(cmp == 0) {
+      return contexts_by_prefix[mid];
+    } else if(cmp < 0) {
+      high = mid - 1;
+    } else {
+      low = mid + 1;
     }
   }
 #endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
@@ -559,12 +640,8 @@ addr_context_lookup_by_number(uint8_t number)
 {
 /* Remove code to avoid warnings and save flash if no context is used */
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
-  int i;
-  for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
-    if((addr_contexts[i].used == 1) &&
-       addr_contexts[i].number == number) {
-      return &addr_contexts[i];
-    }
+  if(number <= SICSLOWPAN_MAX_CONTEXT_NUMBER) {
+    return contexts_by_number[number];
   }
 #endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
   return NULL;
@@ -669,6 +746,7 @@ static void
 compress_hdr_iphc(linkaddr_t *link_destaddr)
 {
   uint8_t tmp, iphc0, iphc1;
+  struct sicslowpan_addr_context *src_context, *dest_context;
 #if DEBUG
   { uint16_t ndx;
     PRINTF("before compression (%d): ", UIP_IP_BUF->len[1]);
@@ -700,10 +778,15 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
 
 
   /* check if dest context exists (for allocating third byte) */
-  /* TODO: fix this so that it remembers the looked up values for
-     avoiding two lookups - or set the lookup values immediately */
-  if(addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr) != NULL ||
-     addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr) != NULL) {
+  src_context = NULL;
+  if(!uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
+    src_context = addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr);
+  }
+  dest_context = NULL;
+  if(!uip_is_addr_mcast(&UIP_IP_BUF->destipaddr)) {
+    dest_context = addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr);
+  }
+  if(dest_context != NULL || src_context != NULL) {
     /* set context flag and increase hc06_ptr */
     PRINTF("IPHC: compressing dest or src ipaddr - setting CID\n");
     iphc1 |= SICSLOWPAN_IPHC_CID;
@@ -796,13 +879,12 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
     PRINTF("IPHC: compressing unspecified - setting SAC\n");
     iphc1 |= SICSLOWPAN_IPHC_SAC;
     iphc1 |= SICSLOWPAN_IPHC_SAM_00;
-  } else if((context = addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr))
-     != NULL) {
+  } else if(src_context != NULL) {
     /* elide the prefix - indicate by CID and set context + SAC */
     PRINTF("IPHC: compressing src with context - setting CID & SAC ctx: %d\n",
-           context->number);
+           src_context->number);
     iphc1 |= SICSLOWPAN_IPHC_CID | SICSLOWPAN_IPHC_SAC;
-    PACKETBUF_IPHC_BUF[2] |= context->number << 4;
+    PACKETBUF_IPHC_BUF[2] |= src_context->number << 4;
     /* compession compare with this nodes address (source) */
 
     iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_SAM_BIT,
@@ -850,10 +932,10 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
     }
   } else {
     /* Address is unicast, try to compress */
-    if((context = addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr)) != NULL) {
+    if(dest_context != NULL) {
       /* elide the prefix */
       iphc1 |= SICSLOWPAN_IPHC_DAC;
-      PACKETBUF_IPHC_BUF[2] |= context->number;
+      PACKETBUF_IPHC_BUF[2] |= dest_context->number;
       /* compession compare with link adress (destination) */
 
       iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_DAM_BIT,
@@ -1294,6 +1376,12 @@ output(const uip_lladdr_t *localdest)
     set_packet_attrs();
   }
 
+#if UIP_CONF_IPV6_RPL
+  if(is_routing_control()) {
+    packetbuf_set_attr(PACKETBUF_ATTR_MAC_PRIORITY, 1);
+  }
+#endif /* UIP_CONF_IPV6_RPL */
+
 #if PACKETBUF_WITH_PACKET_TYPE
 #define TCP_FIN 0x01
 #define TCP_ACK 0x10
@@ -1732,6 +1820,28 @@ input(void)
 }
 /** @} */
 
+#if TRACE_ON
+/*--------------------------------------------------------------------*/
+static uint8_t
+traced_output(const uip_lladdr_t *localdest)
+{
+  uint8_t ret;
+
+  TRACE(TRACE_SICSLOWPAN_OUTPUT_BEGIN, uip_len, 0, 0);
+  ret = output(localdest);
+  TRACE(TRACE_SICSLOWPAN_OUTPUT_END, ret, 0, 0);
+  return ret;
+}
+/*--------------------------------------------------------------------*/
+static void
+traced_input(void)
+{
+  TRACE(TRACE_SICSLOWPAN_INPUT_BEGIN, packetbuf_datalen(), 0, 0);
+  input();
+  TRACE(TRACE_SICSLOWPAN_INPUT_END, uip_len, 0, 0);
+}
+#endif /* TRACE_ON */
+
 /*--------------------------------------------------------------------*/
 /* \brief 6lowpan init function (called by the MAC layer)             */
 /*--------------------------------------------------------------------*/
@@ -1743,7 +1853,11 @@ sicslowpan_init(void)
    * send a packet.
    */
 
+#if TRACE_ON
+  tcpip_set_outputfunc(traced_output);
+#else /* TRACE_ON */
   tcpip_set_outputfunc(output);
+#endif /* TRACE_ON */
 
 #if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06
 /* Preinitialize any address contexts for better header compression
@@ -1754,6 +1868,8 @@ sicslowpan_init(void)
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
   addr_contexts[0].used   = 1;
   addr_contexts[0].number = 0;
+  addr_contexts[0].length = 64;
+  addr_contexts[0].compress = 1;
 #ifdef SICSLOWPAN_CONF_ADDR_CONTEXT_0
   SICSLOWPAN_CONF_ADDR_CONTEXT_0;
 #else
@@ -1770,11 +1886,15 @@ sicslowpan_init(void)
       if (i==1) {
         addr_contexts[1].used   = 1;
         addr_contexts[1].number = 1;
+        addr_contexts[1].length = 64;
+        addr_contexts[1].compress = 1;
         SICSLOWPAN_CONF_ADDR_CONTEXT_1;
 #ifdef SICSLOWPAN_CONF_ADDR_CONTEXT_2
       } else if (i==2) {
         addr_contexts[2].used   = 1;
         addr_contexts[2].number = 2;
+        addr_contexts[2].length = 64;
+        addr_contexts[2].compress = 1;
         SICSLOWPAN_CONF_ADDR_CONTEXT_2;
 #endif
       } else {
@@ -1787,9 +1907,122 @@ sicslowpan_init(void)
   }
 #endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 1 */
 
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  addr_context_reindex();
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+
 #endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
 }
 /*--------------------------------------------------------------------*/
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 && \
+    SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+static void
+addr_context_fill(struct sicslowpan_addr_context *c, uint8_t number,
+                  const uint8_t *prefix, uint8_t length, uint8_t compress)
+{
+  uint8_t bytes;
+
+  c->used = 1;
+  c->number = number;
+  c->length = length;
+  c->compress = compress;
+  memset(c->prefix, 0, sizeof(c->prefix));
+  bytes = length / 8;
+  memcpy(c->prefix, prefix, bytes);
+  if(length % 8) {
+    c->prefix[bytes] = prefix[bytes] & (0xff << (8 - length % 8));
+  }
+}
+#endif
+/*--------------------------------------------------------------------*/
+int
+sicslowpan_context_set(uint8_t number, const uip_ipaddr_t *prefix,
+                       uint8_t length, uint8_t compress)
+{
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 && \
+    SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  struct sicslowpan_addr_context *c;
+  int i;
+
+  if(number > SICSLOWPAN_MAX_CONTEXT_NUMBER || length > 64) {
+    return 0;
+  }
+  c = contexts_by_number[number];
+  for(i = 0; c == NULL && i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
+    if(addr_contexts[i].used != 1) {
+      c = &addr_contexts[i];
+    }
+  }
+  if(c == NULL) {
+    PRINTF("sicslowpan: context table full, cannot add %u\n", number);
+    return 0;
+  }
+  addr_context_fill(c, number, prefix->u8, length, compress);
+  addr_context_reindex();
+  return 1;
+#else
+  return 0;
+#endif
+}
+/*--------------------------------------------------------------------*/
+int
+sicslowpan_context_set_bulk(const struct sicslowpan_addr_context *contexts,
+                            uint8_t count)
+{
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 && \
+    SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  uint8_t seen[SICSLOWPAN_MAX_CONTEXT_NUMBER + 1];
+  int i, n;
+
+  memset(seen, 0, sizeof(seen));
+  memset(addr_contexts, 0, sizeof(addr_contexts));
+  n = 0;
+  for(i = 0; i < count && n < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
+    if(contexts[i].number > SICSLOWPAN_MAX_CONTEXT_NUMBER ||
+       contexts[i].length > 64 || seen[contexts[i].number]) {
+      continue;
+    }
+    seen[contexts[i].number] = 1;
+    addr_context_fill(&addr_contexts[n++], contexts[i].number,
+                      contexts[i].prefix, contexts[i].length,
+                      contexts[i].compress);
+  }
+  addr_context_reindex();
+  return n;
+#else
+  return 0;
+#endif
+}
+/*--------------------------------------------------------------------*/
+int
+sicslowpan_context_remove(uint8_t number)
+{
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 && \
+    SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  struct sicslowpan_addr_context *c;
+
+  c = addr_context_lookup_by_number(number);
+  if(c == NULL) {
+    return 0;
+  }
+  c->used = 0;
+  addr_context_reindex();
+  return 1;
+#else
+  return 0;
+#endif
+}
+/*--------------------------------------------------------------------*/
+const struct sicslowpan_addr_context *
+sicslowpan_context_lookup(uint8_t number)
+{
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06
+  return addr_context_lookup_by_number(number);
+#else
+  return NULL;
+#endif
+}
+/*--------------------------------------------------------------------*/
 int
 sicslowpan_get_last_rssi(void)
 {
@@ -1799,7 +2032,11 @@ sicslowpan_get_last_rssi(void)
 const struct network_driver sicslowpan_driver = {
   "sicslowpan",
   sicslowpan_init,
+#if TRACE_ON
+  traced_input
+#else /* TRACE_ON */
   input
+#endif /* TRACE_ON */
 };
 /*--------------------------------------------------------------------*/
 /** @} */
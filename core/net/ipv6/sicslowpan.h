@@ -220,11 +220,16 @@
  * each context can have upto 8 bytes
  */
 struct sicslowpan_addr_context {
-  uint8_t used; /* possibly use as prefix-length */
+  uint8_t used;
   uint8_t number;
+  uint8_t length;   /* prefix length in bits, at most 64 */
+  uint8_t compress; /* zero if only valid for decompression (6CO C flag) */
   uint8_t prefix[8];
 };
 
+/** \brief The highest context identifier that fits in the IPHC SCI/DCI */
+#define SICSLOWPAN_MAX_CONTEXT_NUMBER 15
+
 /**
  * \name Address compressibility test functions
  * @{
@@ -321,6 +326,54 @@ struct sicslowpan_nh_compressor {
 
 int sicslowpan_get_last_rssi(void);
 
+/**
+ * \name Runtime management of the IPHC address context table
+ *
+ * Contexts can be installed at runtime, e.g. from a 6LoWPAN Context
+ * Option received in a Router Advertisement or from a control plane
+ * that hands out prefixes. The table size is still bounded by
+ * SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS (at most 16); all functions fail
+ * when it is zero or when HC06 compression is not used.
+ * @{
+ */
+
+/**
+ * \brief Install or update the context with identifier number
+ * \param number The context identifier (0-15)
+ * \param prefix The prefix; bits beyond length are ignored
+ * \param length The prefix length in bits (at most 64)
+ * \param compress Non-zero if the context may be used for compression
+ * \return 1 on success, 0 if the table is full or the arguments are invalid
+ */
+int sicslowpan_context_set(uint8_t number, const uip_ipaddr_t *prefix,
+                           uint8_t length, uint8_t compress);
+
+/**
+ * \brief Replace the whole context table in one operation
+ * \param contexts An array of contexts; the used field is ignored
+ * \param count The number of entries in contexts
+ * \return The number of contexts that were installed
+ *
+ * Useful for gateways that serve several prefixes: the lookup index
+ * is rebuilt only once for the whole set.
+ */
+int sicslowpan_context_set_bulk(const struct sicslowpan_addr_context *contexts,
+                                uint8_t count);
+
+/**
+ * \brief Remove the context with identifier number
+ * \return 1 if a context was removed, 0 otherwise
+ */
+int sicslowpan_context_remove(uint8_t number);
+
+/**
+ * \brief Get the context with identifier number
+ * \return The context, or NULL if none is installed
+ */
+const struct sicslowpan_addr_context *sicslowpan_context_lookup(uint8_t number);
+
+/** @} */
+
 extern const struct network_driver sicslowpan_driver;
 
 #endif /* SICSLOWPAN_H_ */
@@ -84,10 +84,22 @@ uip_ds6_nbr_add(const uip_ipaddr_t *ipaddr, const uip_lladdr_t *lladdr,
                 uint8_t isrouter, uint8_t state, nbr_table_reason_t reason,
                 void *data)
 {
-  uip_ds6_nbr_t *nbr = nbr_table_add_lladdr(ds6_neighbors, (linkaddr_t*)lladdr
-                                            , reason, data);
+  uip_ds6_nbr_t *nbr;
+
+  /* nbr_table_add_lladdr() reuses and clears an existing entry for the
+     same link-layer address, so release that entry first: it may be
+     linked into the timer wheel and hold a queued packet. */
+  nbr = nbr_table_get_from_lladdr(ds6_neighbors, lladdr != NULL ?
+                                  (const linkaddr_t *)lladdr : &linkaddr_null);
+  if(nbr != NULL) {
+    uip_ds6_nbr_rm(nbr);
+  }
+
+  nbr = nbr_table_add_lladdr(ds6_neighbors, (linkaddr_t*)lladdr
+                             , reason, data);
   if(nbr) {
     uip_ipaddr_copy(&nbr->ipaddr, ipaddr);
+    UIP_DS6_NEXTHOP_CHANGED();
 #if UIP_ND6_SEND_RA || !UIP_CONF_ROUTER
     nbr->isrouter = isrouter;
 #endif /* UIP_ND6_SEND_RA || !UIP_CONF_ROUTER */
@@ -104,6 +116,8 @@ uip_ds6_nbr_add(const uip_ipaddr_t *ipaddr, const uip_lladdr_t *lladdr,
     }
     stimer_set(&nbr->sendns, 0);
     nbr->nscount = 0;
+    timer_wheel_entry_init(&nbr->expiry);
+    uip_ds6_nbr_schedule(nbr);
 #endif /* UIP_ND6_SEND_NS */
     PRINTF("Adding neighbor with ip addr ");
     PRINT6ADDR(ipaddr);
@@ -130,7 +144,11 @@ uip_ds6_nbr_rm(uip_ds6_nbr_t *nbr)
 #if UIP_CONF_IPV6_QUEUE_PKT
     uip_packetqueue_free(&nbr->packethandle);
 #endif /* UIP_CONF_IPV6_QUEUE_PKT */
+#if UIP_ND6_SEND_NS
+    timer_wheel_stop(&nbr->expiry);
+#endif /* UIP_ND6_SEND_NS */
     NEIGHBOR_STATE_CHANGED(nbr);
+    UIP_DS6_NEXTHOP_CHANGED();
     return nbr_table_remove(ds6_neighbors, nbr);
   }
   return 0;
@@ -237,6 +255,7 @@ uip_ds6_link_neighbor_callback(int status, int numtx)
     if(nbr != NULL && nbr->state != NBR_INCOMPLETE) {
       nbr->state = NBR_REACHABLE;
       stimer_set(&nbr->reachable, UIP_ND6_REACHABLE_TIME / 1000);
+      uip_ds6_nbr_schedule(nbr);
       PRINTF("uip-ds6-neighbor : received a link layer ACK : ");
       PRINTLLADDR((uip_lladdr_t *)dest);
       PRINTF(" is reachable.\n");
@@ -247,82 +266,110 @@ uip_ds6_link_neighbor_callback(int status, int numtx)
 }
 #if UIP_ND6_SEND_NS
 /*---------------------------------------------------------------------------*/
-/** Periodic processing on neighbors */
-void
-uip_ds6_neighbor_periodic(void)
+static unsigned long
+stimer_left(struct stimer *t)
 {
-  uip_ds6_nbr_t *nbr = nbr_table_head(ds6_neighbors);
-  while(nbr != NULL) {
-    switch(nbr->state) {
-    case NBR_REACHABLE:
-      if(stimer_expired(&nbr->reachable)) {
+  return stimer_expired(t) ? 0 : stimer_remaining(t);
+}
+/*---------------------------------------------------------------------------*/
+/** Neighbor state machine step, run when the neighbor's timer expires */
+static void
+nbr_expired(void *ptr)
+{
+  uip_ds6_nbr_t *nbr = ptr;
+
+  switch(nbr->state) {
+  case NBR_REACHABLE:
+    if(stimer_expired(&nbr->reachable)) {
 #if UIP_CONF_IPV6_RPL
-        /* when a neighbor leave its REACHABLE state and is a default router,
-           instead of going to STALE state it enters DELAY state in order to
-           force a NUD on it. Otherwise, if there is no upward traffic, the
-           node never knows if the default router is still reachable. This
-           mimics the 6LoWPAN-ND behavior.
-         */
-        if(uip_ds6_defrt_lookup(&nbr->ipaddr) != NULL) {
-          PRINTF("REACHABLE: defrt moving to DELAY (");
-          PRINT6ADDR(&nbr->ipaddr);
-          PRINTF(")\n");
-          nbr->state = NBR_DELAY;
-          stimer_set(&nbr->reachable, UIP_ND6_DELAY_FIRST_PROBE_TIME);
-          nbr->nscount = 0;
-        } else {
-          PRINTF("REACHABLE: moving to STALE (");
-          PRINT6ADDR(&nbr->ipaddr);
-          PRINTF(")\n");
-          nbr->state = NBR_STALE;
-        }
-#else /* UIP_CONF_IPV6_RPL */
+      /* when a neighbor leave its REACHABLE state and is a default router,
+         instead of going to STALE state it enters DELAY state in order to
+         force a NUD on it. Otherwise, if there is no upward traffic, the
+         node never knows if the default router is still reachable. This
+         mimics the 6LoWPAN-ND behavior.
+       */
+      if(uip_ds6_defrt_lookup(&nbr->ipaddr) != NULL) {
+        PRINTF("REACHABLE: defrt moving to DELAY (");
+        PRINT6ADDR(&nbr->ipaddr);
+        PRINTF(")\n");
+        nbr->state = NBR_DELAY;
+        stimer_set(&nbr->reachable, UIP_ND6_DELAY_FIRST_PROBE_TIME);
+        nbr->nscount = 0;
+      } else {
         PRINTF("REACHABLE: moving to STALE (");
         PRINT6ADDR(&nbr->ipaddr);
         PRINTF(")\n");
         nbr->state = NBR_STALE;
-#endif /* UIP_CONF_IPV6_RPL */
       }
-      break;
-    case NBR_INCOMPLETE:
-      if(nbr->nscount >= UIP_ND6_MAX_MULTICAST_SOLICIT) {
-        uip_ds6_nbr_rm(nbr);
-      } else if(stimer_expired(&nbr->sendns) && (uip_len == 0)) {
-        nbr->nscount++;
-        PRINTF("NBR_INCOMPLETE: NS %u\n", nbr->nscount);
-        uip_nd6_ns_output(NULL, NULL, &nbr->ipaddr);
-        stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
-      }
-      break;
-    case NBR_DELAY:
-      if(stimer_expired(&nbr->reachable)) {
-        nbr->state = NBR_PROBE;
-        nbr->nscount = 0;
-        PRINTF("DELAY: moving to PROBE\n");
-        stimer_set(&nbr->sendns, 0);
-      }
-      break;
-    case NBR_PROBE:
-      if(nbr->nscount >= UIP_ND6_MAX_UNICAST_SOLICIT) {
-        uip_ds6_defrt_t *locdefrt;
-        PRINTF("PROBE END\n");
-        if((locdefrt = uip_ds6_defrt_lookup(&nbr->ipaddr)) != NULL) {
-          if (!locdefrt->isinfinite) {
-            uip_ds6_defrt_rm(locdefrt);
-          }
+#else /* UIP_CONF_IPV6_RPL */
+      PRINTF("REACHABLE: moving to STALE (");
+      PRINT6ADDR(&nbr->ipaddr);
+      PRINTF(")\n");
+      nbr->state = NBR_STALE;
+#endif /* UIP_CONF_IPV6_RPL */
+    }
+    break;
+  case NBR_INCOMPLETE:
+    if(nbr->nscount >= UIP_ND6_MAX_MULTICAST_SOLICIT) {
+      uip_ds6_nbr_rm(nbr);
+      return;
+    } else if(stimer_expired(&nbr->sendns) && (uip_len == 0)) {
+      nbr->nscount++;
+      PRINTF("NBR_INCOMPLETE: NS %u\n", nbr->nscount);
+      uip_nd6_ns_output(NULL, NULL, &nbr->ipaddr);
+      stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
+    }
+    break;
+  case NBR_DELAY:
+    if(stimer_expired(&nbr->reachable)) {
+      nbr->state = NBR_PROBE;
+      nbr->nscount = 0;
+      PRINTF("DELAY: moving to PROBE\n");
+      stimer_set(&nbr->sendns, 0);
+    }
+    break;
+  case NBR_PROBE:
+    if(nbr->nscount >= UIP_ND6_MAX_UNICAST_SOLICIT) {
+      uip_ds6_defrt_t *locdefrt;
+      PRINTF("PROBE END\n");
+      if((locdefrt = uip_ds6_defrt_lookup(&nbr->ipaddr)) != NULL) {
+        if (!locdefrt->isinfinite) {
+          uip_ds6_defrt_rm(locdefrt);
         }
-        uip_ds6_nbr_rm(nbr);
-      } else if(stimer_expired(&nbr->sendns) && (uip_len == 0)) {
-        nbr->nscount++;
-        PRINTF("PROBE: NS %u\n", nbr->nscount);
-        uip_nd6_ns_output(NULL, &nbr->ipaddr, &nbr->ipaddr);
-        stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
       }
-      break;
-    default:
-      break;
+      uip_ds6_nbr_rm(nbr);
+      return;
+    } else if(stimer_expired(&nbr->sendns) && (uip_len == 0)) {
+      nbr->nscount++;
+      PRINTF("PROBE: NS %u\n", nbr->nscount);
+      uip_nd6_ns_output(NULL, &nbr->ipaddr, &nbr->ipaddr);
+      stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
     }
-    nbr = nbr_table_next(ds6_neighbors, nbr);
+    break;
+  default:
+    break;
+  }
+  uip_ds6_nbr_schedule(nbr);
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_nbr_schedule(uip_ds6_nbr_t *nbr)
+{
+  switch(nbr->state) {
+  case NBR_REACHABLE:
+  case NBR_DELAY:
+    timer_wheel_set(&uip_ds6_timer_wheel, &nbr->expiry,
+                    stimer_left(&nbr->reachable), nbr_expired, nbr);
+    break;
+  case NBR_INCOMPLETE:
+  case NBR_PROBE:
+    timer_wheel_set(&uip_ds6_timer_wheel, &nbr->expiry,
+                    stimer_left(&nbr->sendns), nbr_expired, nbr);
+    break;
+  default:
+    /* STALE neighbors have nothing to wait for */
+    timer_wheel_stop(&nbr->expiry);
+    break;
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -335,6 +382,7 @@ uip_ds6_nbr_refresh_reachable_state(const uip_ipaddr_t *ipaddr)
     nbr->state = NBR_REACHABLE;
     nbr->nscount = 0;
     stimer_set(&nbr->reachable, UIP_ND6_REACHABLE_TIME / 1000);
+    uip_ds6_nbr_schedule(nbr);
   }
 }
 /*---------------------------------------------------------------------------*/
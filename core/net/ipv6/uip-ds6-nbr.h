@@ -49,6 +49,7 @@
 #include "net/ip/uip.h"
 #include "net/nbr-table.h"
 #include "sys/stimer.h"
+#include "sys/timer-wheel.h"
 #include "net/ipv6/uip-ds6.h"
 #if UIP_CONF_IPV6_QUEUE_PKT
 #include "net/ip/uip-packetqueue.h"
@@ -72,6 +73,7 @@ typedef struct uip_ds6_nbr {
 #if UIP_ND6_SEND_NS || UIP_ND6_SEND_RA
   struct stimer reachable;
   struct stimer sendns;
+  struct timer_wheel_entry expiry;
   uint8_t nscount;
 #endif /* UIP_ND6_SEND_NS || UIP_ND6_SEND_RA */
 #if UIP_CONF_IPV6_QUEUE_PKT
@@ -95,10 +97,17 @@ uip_ds6_nbr_t *uip_ds6_nbr_ll_lookup(const uip_lladdr_t *lladdr);
 uip_ipaddr_t *uip_ds6_nbr_ipaddr_from_lladdr(const uip_lladdr_t *lladdr);
 const uip_lladdr_t *uip_ds6_nbr_lladdr_from_ipaddr(const uip_ipaddr_t *ipaddr);
 void uip_ds6_link_neighbor_callback(int status, int numtx);
-void uip_ds6_neighbor_periodic(void);
 int uip_ds6_nbr_num(void);
 
 #if UIP_ND6_SEND_NS
+/**
+ * \brief Schedule the next state machine step of a neighbor. This
+ * function must be called whenever the state or the reachable/sendns
+ * timers of a neighbor are changed, except when it moves to STALE.
+ * \param nbr the neighbor
+ */
+void uip_ds6_nbr_schedule(uip_ds6_nbr_t *nbr);
+
 /**
  * \brief Refresh the reachable state of a neighbor. This function
  * may be called when a node receives an IPv6 message that confirms the
@@ -107,6 +116,8 @@ int uip_ds6_nbr_num(void);
  * should be refreshed.
  */
 void uip_ds6_nbr_refresh_reachable_state(const uip_ipaddr_t *ipaddr);
+#else /* UIP_ND6_SEND_NS */
+#define uip_ds6_nbr_schedule(nbr)
 #endif /* UIP_ND6_SEND_NS */
 
 /**
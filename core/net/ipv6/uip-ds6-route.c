@@ -64,17 +64,24 @@ void NETSTACK_CONF_ROUTING_NEIGHBOR_REMOVED_CALLBACK(const linkaddr_t *addr);
    so that it will be maintained along with the rest of the neighbor
    tables in the system. */
 NBR_TABLE_GLOBAL(struct uip_ds6_route_neighbor_routes, nbr_routes);
-MEMB(neighborroutememb, struct uip_ds6_route_neighbor_route, UIP_DS6_ROUTE_NB);
+MEMB_FREELIST(neighborroutememb, struct uip_ds6_route_neighbor_route, UIP_DS6_ROUTE_NB);
 
 /* Each route is repressented by a uip_ds6_route_t structure and
    memory for each route is allocated from the routememb memory
    block. These routes are maintained on the routelist. */
 LIST(routelist);
-MEMB(routememb, uip_ds6_route_t, UIP_DS6_ROUTE_NB);
+MEMB_FREELIST(routememb, uip_ds6_route_t, UIP_DS6_ROUTE_NB);
 
 static int num_routes = 0;
 static void rm_routelist_callback(nbr_table_item_t *ptr);
 
+#ifdef UIP_CONF_DS6_ROUTE_EXPIRED_CALLBACK
+#define ROUTE_EXPIRED_CALLBACK(route) UIP_CONF_DS6_ROUTE_EXPIRED_CALLBACK(route)
+void ROUTE_EXPIRED_CALLBACK(uip_ds6_route_t *route);
+#else
+#define ROUTE_EXPIRED_CALLBACK(route) uip_ds6_route_rm(route)
+#endif /* UIP_CONF_DS6_ROUTE_EXPIRED_CALLBACK */
+
 #endif /* (UIP_CONF_MAX_ROUTES != 0) */
 
 /* Default routes are held on the defaultrouterlist and their
@@ -409,6 +416,8 @@ uip_ds6_route_add(uip_ipaddr_t *ipaddr, uint8_t length,
       return NULL;
     }
 
+    timer_wheel_entry_init(&r->expiry);
+
     /* add new routes first - assuming that there is a reason to add this
        and that there is a packet coming soon. */
     list_push(routelist, r);
@@ -436,6 +445,7 @@ uip_ds6_route_add(uip_ipaddr_t *ipaddr, uint8_t length,
 
   uip_ipaddr_copy(&(r->ipaddr), ipaddr);
   r->length = length;
+  UIP_DS6_NEXTHOP_CHANGED();
 
 #ifdef UIP_DS6_ROUTE_STATE_TYPE
   memset(&r->state, 0, sizeof(UIP_DS6_ROUTE_STATE_TYPE));
@@ -507,6 +517,8 @@ uip_ds6_route_rm(uip_ds6_route_t *route)
           (const linkaddr_t *)nbr_table_get_lladdr(nbr_routes, route->neighbor_routes->route_list));
 #endif
     }
+    timer_wheel_stop(&route->expiry);
+    UIP_DS6_NEXTHOP_CHANGED();
     memb_free(&routememb, route);
     memb_free(&neighborroutememb, neighbor_route);
 
@@ -530,6 +542,43 @@ uip_ds6_route_rm(uip_ds6_route_t *route)
 #if (UIP_CONF_MAX_ROUTES != 0)
 /*---------------------------------------------------------------------------*/
 static void
+route_expired(void *ptr)
+{
+  uip_ds6_route_t *route = ptr;
+
+  PRINTF("uip_ds6_route: lifetime of route to ");
+  PRINT6ADDR(&route->ipaddr);
+  PRINTF(" expired\n");
+  ROUTE_EXPIRED_CALLBACK(route);
+}
+#endif /* (UIP_CONF_MAX_ROUTES != 0) */
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_route_set_lifetime(uip_ds6_route_t *route, uint32_t lifetime)
+{
+#if (UIP_CONF_MAX_ROUTES != 0)
+  if(lifetime == UIP_DS6_ROUTE_INFINITE_LIFETIME) {
+    timer_wheel_stop(&route->expiry);
+  } else {
+    timer_wheel_set(&uip_ds6_timer_wheel, &route->expiry, lifetime,
+                    route_expired, route);
+  }
+#endif /* (UIP_CONF_MAX_ROUTES != 0) */
+}
+/*---------------------------------------------------------------------------*/
+uint32_t
+uip_ds6_route_get_lifetime(uip_ds6_route_t *route)
+{
+#if (UIP_CONF_MAX_ROUTES != 0)
+  if(timer_wheel_pending(&route->expiry)) {
+    return timer_wheel_remaining(&route->expiry);
+  }
+#endif /* (UIP_CONF_MAX_ROUTES != 0) */
+  return UIP_DS6_ROUTE_INFINITE_LIFETIME;
+}
+#if (UIP_CONF_MAX_ROUTES != 0)
+/*---------------------------------------------------------------------------*/
+static void
 rm_routelist(struct uip_ds6_route_neighbor_routes *routes)
 {
 #if DEBUG != DEBUG_NONE
@@ -602,16 +651,14 @@ uip_ds6_defrt_add(uip_ipaddr_t *ipaddr, unsigned long interval)
       PRINTF("\n");
     }
 
+    timer_wheel_entry_init(&d->expiry);
     list_push(defaultrouterlist, d);
+    UIP_DS6_NEXTHOP_CHANGED();
   }
 
   uip_ipaddr_copy(&d->ipaddr, ipaddr);
-  if(interval != 0) {
-    stimer_set(&d->lifetime, interval);
-    d->isinfinite = 0;
-  } else {
-    d->isinfinite = 1;
-  }
+  d->isinfinite = interval == 0;
+  uip_ds6_defrt_set_lifetime(d, interval);
 
   ANNOTATE("#L %u 1\n", ipaddr->u8[sizeof(uip_ipaddr_t) - 1]);
 
@@ -642,6 +689,8 @@ uip_ds6_defrt_rm(uip_ds6_defrt_t *defrt)
     if(d == defrt) {
       PRINTF("Removing default route\n");
       list_remove(defaultrouterlist, defrt);
+      timer_wheel_stop(&defrt->expiry);
+      UIP_DS6_NEXTHOP_CHANGED();
       memb_free(&defaultroutermemb, defrt);
       ANNOTATE("#L %u 0\n", defrt->ipaddr.u8[sizeof(uip_ipaddr_t) - 1]);
 #if UIP_DS6_NOTIFICATIONS
@@ -701,20 +750,27 @@ uip_ds6_defrt_choose(void)
   return addr;
 }
 /*---------------------------------------------------------------------------*/
+static void
+defrt_expired(void *ptr)
+{
+  uip_ds6_defrt_t *d = ptr;
+
+  /* The router may have been made infinite after it was scheduled */
+  if(!d->isinfinite && stimer_expired(&d->lifetime)) {
+    PRINTF("defrt_expired: defrt lifetime expired\n");
+    uip_ds6_defrt_rm(d);
+  }
+}
+/*---------------------------------------------------------------------------*/
 void
-uip_ds6_defrt_periodic(void)
+uip_ds6_defrt_set_lifetime(uip_ds6_defrt_t *defrt, unsigned long interval)
 {
-  uip_ds6_defrt_t *d;
-  d = list_head(defaultrouterlist);
-  while(d != NULL) {
-    if(!d->isinfinite &&
-       stimer_expired(&d->lifetime)) {
-      PRINTF("uip_ds6_defrt_periodic: defrt lifetime expired\n");
-      uip_ds6_defrt_rm(d);
-      d = list_head(defaultrouterlist);
-    } else {
-      d = list_item_next(d);
-    }
+  stimer_set(&defrt->lifetime, interval);
+  if(defrt->isinfinite) {
+    timer_wheel_stop(&defrt->expiry);
+  } else {
+    timer_wheel_set(&uip_ds6_timer_wheel, &defrt->expiry, interval,
+                    defrt_expired, defrt);
   }
 }
 /*---------------------------------------------------------------------------*/
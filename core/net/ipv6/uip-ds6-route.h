@@ -43,6 +43,7 @@
 #include "net/ip/uip.h"
 #include "net/nbr-table.h"
 #include "sys/stimer.h"
+#include "sys/timer-wheel.h"
 #include "lib/list.h"
 
 NBR_TABLE_DECLARE(nbr_routes);
@@ -88,6 +89,9 @@ void uip_ds6_notification_rm(struct uip_ds6_notification *n);
 #define UIP_DS6_ROUTE_NB 4
 #endif /* UIP_CONF_MAX_ROUTES */
 
+/** \brief Route lifetime value that never expires */
+#define UIP_DS6_ROUTE_INFINITE_LIFETIME 0xFFFFFFFF
+
 /** \brief define some additional RPL related route state and
  *  neighbor callback for RPL - if not a DS6_ROUTE_STATE is already set */
 #ifndef UIP_DS6_ROUTE_STATE_TYPE
@@ -130,7 +134,6 @@ void uip_ds6_notification_rm(struct uip_ds6_notification *n);
 
 struct rpl_dag;
 typedef struct rpl_route_entry {
-  uint32_t lifetime;
   struct rpl_dag *dag;
   uint8_t dao_seqno_out;
   uint8_t dao_seqno_in;
@@ -154,6 +157,9 @@ typedef struct uip_ds6_route {
      uses. */
   struct uip_ds6_route_neighbor_routes *neighbor_routes;
   uip_ipaddr_t ipaddr;
+  /* Lifetime of the route, kept on the ds6 timer wheel so that expiry
+     does not require a walk over the routing table. */
+  struct timer_wheel_entry expiry;
 #ifdef UIP_DS6_ROUTE_STATE_TYPE
   UIP_DS6_ROUTE_STATE_TYPE state;
 #endif
@@ -172,6 +178,7 @@ typedef struct uip_ds6_defrt {
   struct uip_ds6_defrt *next;
   uip_ipaddr_t ipaddr;
   struct stimer lifetime;
+  struct timer_wheel_entry expiry;
   uint8_t isinfinite;
 } uip_ds6_defrt_t;
 
@@ -183,8 +190,8 @@ uip_ds6_defrt_t *uip_ds6_defrt_add(uip_ipaddr_t *ipaddr,
 void uip_ds6_defrt_rm(uip_ds6_defrt_t *defrt);
 uip_ds6_defrt_t *uip_ds6_defrt_lookup(uip_ipaddr_t *ipaddr);
 uip_ipaddr_t *uip_ds6_defrt_choose(void);
-
-void uip_ds6_defrt_periodic(void);
+void uip_ds6_defrt_set_lifetime(uip_ds6_defrt_t *defrt,
+                                unsigned long interval);
 /** @} */
 
 
@@ -201,6 +208,26 @@ int uip_ds6_route_num_routes(void);
 uip_ds6_route_t *uip_ds6_route_head(void);
 uip_ds6_route_t *uip_ds6_route_next(uip_ds6_route_t *);
 int uip_ds6_route_is_nexthop(const uip_ipaddr_t *ipaddr);
+
+/**
+ * \brief Set the lifetime of a route
+ * \param route The route
+ * \param lifetime Seconds until the route expires, or
+ *        UIP_DS6_ROUTE_INFINITE_LIFETIME. Routes have an infinite
+ *        lifetime when they are added.
+ *
+ * When the lifetime runs out, UIP_CONF_DS6_ROUTE_EXPIRED_CALLBACK is
+ * called with the route if defined; otherwise the route is removed.
+ */
+void uip_ds6_route_set_lifetime(uip_ds6_route_t *route, uint32_t lifetime);
+
+/**
+ * \brief Get the remaining lifetime of a route
+ * \param route The route
+ * \return Seconds until the route expires, or
+ *         UIP_DS6_ROUTE_INFINITE_LIFETIME
+ */
+uint32_t uip_ds6_route_get_lifetime(uip_ds6_route_t *route);
 /** @} */
 
 #endif /* UIP_DS6_ROUTE_H */
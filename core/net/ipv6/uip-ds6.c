@@ -55,6 +55,8 @@
 #include "net/ip/uip-debug.h"
 
 struct etimer uip_ds6_timer_periodic;                           /**< Timer for maintenance of data structures */
+struct timer_wheel uip_ds6_timer_wheel;                         /**< Expiry of routes, neighbors, default routers and prefixes */
+uint16_t uip_ds6_nexthop_generation;                            /**< Bumped on changes that may affect next-hop selection */
 
 #if UIP_CONF_ROUTER
 struct stimer uip_ds6_timer_ra;                                 /**< RA timer, to schedule RA sending */
@@ -94,6 +96,7 @@ void
 uip_ds6_init(void)
 {
 
+  timer_wheel_init(&uip_ds6_timer_wheel);
   uip_ds6_neighbors_init();
   uip_ds6_route_init();
 
@@ -165,31 +168,9 @@ uip_ds6_periodic(void)
     }
   }
 
-  /* Periodic processing on default routers */
-  uip_ds6_defrt_periodic();
-  /*  for(locdefrt = uip_ds6_defrt_list;
-      locdefrt < uip_ds6_defrt_list + UIP_DS6_DEFRT_NB; locdefrt++) {
-    if((locdefrt->isused) && (!locdefrt->isinfinite) &&
-       (stimer_expired(&(locdefrt->lifetime)))) {
-      uip_ds6_defrt_rm(locdefrt);
-    }
-    }*/
-
-#if !UIP_CONF_ROUTER
-  /* Periodic processing on prefixes */
-  for(locprefix = uip_ds6_prefix_list;
-      locprefix < uip_ds6_prefix_list + UIP_DS6_PREFIX_NB;
-      locprefix++) {
-    if(locprefix->isused && !locprefix->isinfinite
-       && stimer_expired(&(locprefix->vlifetime))) {
-      uip_ds6_prefix_rm(locprefix);
-    }
-  }
-#endif /* !UIP_CONF_ROUTER */
-
-#if UIP_ND6_SEND_NS
-  uip_ds6_neighbor_periodic();
-#endif /* UIP_ND6_SEND_NS */
+  /* Expire neighbors, default routers, prefixes and routes whose timers
+     have run out. This only touches the entries that actually expire. */
+  timer_wheel_run(&uip_ds6_timer_wheel);
 
 #if UIP_CONF_ROUTER && UIP_ND6_SEND_RA
   /* Periodic RA sending */
@@ -247,6 +228,7 @@ uip_ds6_prefix_add(uip_ipaddr_t *ipaddr, uint8_t ipaddrlen,
     locprefix->l_a_reserved = flags;
     locprefix->vlifetime = vtime;
     locprefix->plifetime = ptime;
+    UIP_DS6_NEXTHOP_CHANGED();
     PRINTF("Adding prefix ");
     PRINT6ADDR(&locprefix->ipaddr);
     PRINTF("length %u, flags %x, Valid lifetime %lx, Preffered lifetime %lx\n",
@@ -271,12 +253,10 @@ uip_ds6_prefix_add(uip_ipaddr_t *ipaddr, uint8_t ipaddrlen,
     locprefix->isused = 1;
     uip_ipaddr_copy(&locprefix->ipaddr, ipaddr);
     locprefix->length = ipaddrlen;
-    if(interval != 0) {
-      stimer_set(&(locprefix->vlifetime), interval);
-      locprefix->isinfinite = 0;
-    } else {
-      locprefix->isinfinite = 1;
-    }
+    timer_wheel_entry_init(&locprefix->expiry);
+    locprefix->isinfinite = interval == 0;
+    uip_ds6_prefix_set_lifetime(locprefix, interval);
+    UIP_DS6_NEXTHOP_CHANGED();
     PRINTF("Adding prefix ");
     PRINT6ADDR(&locprefix->ipaddr);
     PRINTF("length %u, vlifetime %lu\n", ipaddrlen, interval);
@@ -284,6 +264,30 @@ uip_ds6_prefix_add(uip_ipaddr_t *ipaddr, uint8_t ipaddrlen,
   }
   return NULL;
 }
+/*---------------------------------------------------------------------------*/
+static void
+prefix_expired(void *ptr)
+{
+  uip_ds6_prefix_t *prefix = ptr;
+
+  /* The prefix may have been made infinite after it was scheduled */
+  if(prefix->isused && !prefix->isinfinite
+     && stimer_expired(&prefix->vlifetime)) {
+    uip_ds6_prefix_rm(prefix);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_prefix_set_lifetime(uip_ds6_prefix_t *prefix, unsigned long interval)
+{
+  stimer_set(&prefix->vlifetime, interval);
+  if(prefix->isinfinite) {
+    timer_wheel_stop(&prefix->expiry);
+  } else {
+    timer_wheel_set(&uip_ds6_timer_wheel, &prefix->expiry, interval,
+                    prefix_expired, prefix);
+  }
+}
 #endif /* UIP_CONF_ROUTER */
 
 /*---------------------------------------------------------------------------*/
@@ -291,7 +295,11 @@ void
 uip_ds6_prefix_rm(uip_ds6_prefix_t *prefix)
 {
   if(prefix != NULL) {
+#if !UIP_CONF_ROUTER
+    timer_wheel_stop(&prefix->expiry);
+#endif /* !UIP_CONF_ROUTER */
     prefix->isused = 0;
+    UIP_DS6_NEXTHOP_CHANGED();
   }
   return;
 }
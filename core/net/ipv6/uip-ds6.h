@@ -44,6 +44,7 @@
 
 #include "net/ip/uip.h"
 #include "sys/stimer.h"
+#include "sys/timer-wheel.h"
 /* The size of uip_ds6_addr_t depends on UIP_ND6_DEF_MAXDADNS. Include uip-nd6.h to define it. */
 #include "net/ipv6/uip-nd6.h"
 #include "net/ipv6/uip-ds6-route.h"
@@ -196,6 +197,7 @@ typedef struct uip_ds6_prefix {
   uip_ipaddr_t ipaddr;
   uint8_t length;
   struct stimer vlifetime;
+  struct timer_wheel_entry expiry;
   uint8_t isinfinite;
 } uip_ds6_prefix_t;
 #endif /*UIP_CONF_ROUTER */
@@ -239,6 +241,12 @@ typedef struct uip_ds6_maddr {
 #endif /* UIP_CONF_DS6_NEIGHBOR_STATE_CHANGED */
 #endif /* UIP_CONF_IPV6_RPL */
 
+#if UIP_CONF_IPV6_RPL
+#ifndef UIP_CONF_DS6_ROUTE_EXPIRED_CALLBACK
+#define UIP_CONF_DS6_ROUTE_EXPIRED_CALLBACK rpl_route_expired_callback
+#endif /* UIP_CONF_DS6_ROUTE_EXPIRED_CALLBACK */
+#endif /* UIP_CONF_IPV6_RPL */
+
 
 /** \brief  Interface structure (contains all the interface variables) */
 typedef struct uip_ds6_netif {
@@ -269,6 +277,14 @@ typedef struct uip_ds6_element {
 /*---------------------------------------------------------------------------*/
 extern uip_ds6_netif_t uip_ds6_if;
 extern struct etimer uip_ds6_timer_periodic;
+extern struct timer_wheel uip_ds6_timer_wheel;
+extern uint16_t uip_ds6_nexthop_generation;
+
+/** \brief Mark that the next-hop of some destination may have changed.
+    Called whenever a route, default router, prefix or neighbor cache
+    entry is added or removed, so that cached next-hop decisions (see
+    tcpip_ipv6_output()) can be validated by a single comparison. */
+#define UIP_DS6_NEXTHOP_CHANGED() (uip_ds6_nexthop_generation++)
 
 #if UIP_CONF_ROUTER
 extern uip_ds6_prefix_t uip_ds6_prefix_list[UIP_DS6_PREFIX_NB];
@@ -304,6 +320,8 @@ uip_ds6_prefix_t *uip_ds6_prefix_add(uip_ipaddr_t *ipaddr, uint8_t length,
 #else /* UIP_CONF_ROUTER */
 uip_ds6_prefix_t *uip_ds6_prefix_add(uip_ipaddr_t *ipaddr, uint8_t length,
                                      unsigned long interval);
+void uip_ds6_prefix_set_lifetime(uip_ds6_prefix_t *prefix,
+                                 unsigned long interval);
 #endif /* UIP_CONF_ROUTER */
 void uip_ds6_prefix_rm(uip_ds6_prefix_t *prefix);
 uip_ds6_prefix_t *uip_ds6_prefix_lookup(uip_ipaddr_t *ipaddr,
@@ -73,6 +73,7 @@
 #include "net/ipv6/uip-nd6.h"
 #include "net/ipv6/uip-ds6.h"
 #include "net/ip/uip-nameserver.h"
+#include "net/ipv6/sicslowpan.h"
 #include "lib/random.h"
 
 /*------------------------------------------------------------------*/
@@ -114,6 +115,7 @@ void uip_log(char *msg);
 #define UIP_ND6_OPT_PREFIX_BUF ((uip_nd6_opt_prefix_info *)&uip_buf[uip_l2_l3_icmp_hdr_len + nd6_opt_offset])
 #define UIP_ND6_OPT_MTU_BUF ((uip_nd6_opt_mtu *)&uip_buf[uip_l2_l3_icmp_hdr_len + nd6_opt_offset])
 #define UIP_ND6_OPT_RDNSS_BUF ((uip_nd6_opt_dns *)&uip_buf[uip_l2_l3_icmp_hdr_len + nd6_opt_offset])
+#define UIP_ND6_OPT_6CO_BUF ((uip_nd6_opt_6co *)&uip_buf[uip_l2_l3_icmp_hdr_len + nd6_opt_offset])
 /** @} */
 
 #if UIP_ND6_SEND_NS || UIP_ND6_SEND_NA || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER
@@ -596,10 +598,7 @@ na_input(void)
     nbr->queue_buf_len = 0;
     return;
     }*/
-  if(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
-    uip_len = uip_packetqueue_buflen(&nbr->packethandle);
-    memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
-    uip_packetqueue_free(&nbr->packethandle);
+  if(uip_packetqueue_to_uipbuf(&nbr->packethandle)) {
     return;
   }
 
@@ -981,9 +980,9 @@ ra_input(void)
               PRINTF("Updating timer of prefix ");
               PRINT6ADDR(&prefix->ipaddr);
               PRINTF(" new value %lu\n", uip_ntohl(nd6_opt_prefix_info->validlt));
-              stimer_set(&prefix->vlifetime,
-                         uip_ntohl(nd6_opt_prefix_info->validlt));
               prefix->isinfinite = 0;
+              uip_ds6_prefix_set_lifetime(prefix,
+                                          uip_ntohl(nd6_opt_prefix_info->validlt));
               break;
             }
           }
@@ -1049,6 +1048,24 @@ ra_input(void)
       }
       break;
 #endif /* UIP_ND6_RA_RDNSS */
+    case UIP_ND6_OPT_6CO:
+      PRINTF("Processing 6CO option in RA\n");
+      /*
+       * Lifetime is not tracked: a context stays until an RA removes
+       * it. Contexts longer than 64 bits are not supported.
+       */
+      if(UIP_ND6_OPT_6CO_BUF->lifetime == 0) {
+        sicslowpan_context_remove(UIP_ND6_OPT_6CO_BUF->flags_cid &
+                                  UIP_ND6_6CO_CID_MASK);
+      } else if(UIP_ND6_OPT_6CO_BUF->context_len <= 64) {
+        sicslowpan_context_set(UIP_ND6_OPT_6CO_BUF->flags_cid &
+                               UIP_ND6_6CO_CID_MASK,
+                               (uip_ipaddr_t *)UIP_ND6_OPT_6CO_BUF->prefix,
+                               UIP_ND6_OPT_6CO_BUF->context_len,
+                               UIP_ND6_OPT_6CO_BUF->flags_cid &
+                               UIP_ND6_6CO_FLAG_C);
+      }
+      break;
     default:
       PRINTF("ND option not supported in RA");
       break;
@@ -1066,8 +1083,8 @@ ra_input(void)
                         (unsigned
                          long)(uip_ntohs(UIP_ND6_RA_BUF->router_lifetime)));
     } else {
-      stimer_set(&(defrt->lifetime),
-                 (unsigned long)(uip_ntohs(UIP_ND6_RA_BUF->router_lifetime)));
+      uip_ds6_defrt_set_lifetime(defrt,
+                                 (unsigned long)(uip_ntohs(UIP_ND6_RA_BUF->router_lifetime)));
     }
   } else {
     if(defrt != NULL) {
@@ -1084,10 +1101,7 @@ ra_input(void)
     nbr->queue_buf_len = 0;
     return;
     }*/
-  if(nbr != NULL && uip_packetqueue_buflen(&nbr->packethandle) != 0) {
-    uip_len = uip_packetqueue_buflen(&nbr->packethandle);
-    memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
-    uip_packetqueue_free(&nbr->packethandle);
+  if(nbr != NULL && uip_packetqueue_to_uipbuf(&nbr->packethandle)) {
     return;
   }
 
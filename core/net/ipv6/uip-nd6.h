@@ -189,6 +189,7 @@
 #define UIP_ND6_OPT_MTU                 5
 #define UIP_ND6_OPT_RDNSS               25
 #define UIP_ND6_OPT_DNSSL               31
+#define UIP_ND6_OPT_6CO                 34
 /** @} */
 
 /** \name ND6 option types */
@@ -344,6 +345,23 @@ typedef struct uip_nd6_opt_dns {
   uip_ipaddr_t ip;
 } uip_nd6_opt_dns;
 
+/** \brief ND option 6LoWPAN Context (RFC 6775) */
+typedef struct uip_nd6_opt_6co {
+  uint8_t type;
+  uint8_t len;
+  uint8_t context_len;
+  uint8_t flags_cid; /* 3 bits reserved, C flag, 4 bits context id */
+  uint16_t reserved;
+  uint16_t lifetime; /* in units of 60 seconds */
+  uint8_t prefix[16];
+} uip_nd6_opt_6co;
+
+/** \name 6LoWPAN Context option flags masks */
+/** @{ */
+#define UIP_ND6_6CO_FLAG_C              0x10
+#define UIP_ND6_6CO_CID_MASK            0x0f
+/** @} */
+
 /** \struct Redirected header option */
 typedef struct uip_nd6_opt_redirected_hdr {
   uint8_t type;
@@ -43,6 +43,7 @@
 
 #include "sys/ctimer.h"
 #include "sys/clock.h"
+#include "sys/trace.h"
 
 #include "lib/random.h"
 
@@ -98,15 +99,20 @@ struct qbuf_metadata {
   mac_callback_t sent;
   void *cptr;
   uint8_t max_transmissions;
+  uint8_t priority;
 };
 
 /* Every neighbor has its own packet queue */
 struct neighbor_queue {
   struct neighbor_queue *next;
+  struct neighbor_queue *hash_next;
   linkaddr_t addr;
   struct ctimer transmit_timer;
   uint8_t transmissions;
   uint8_t collisions;
+  uint8_t ready;
+  uint8_t weight;
+  uint8_t deficit;
   LIST_STRUCT(queued_packet_list);
 };
 
@@ -125,27 +131,126 @@ struct neighbor_queue {
 #endif /* CSMA_CONF_MAX_PACKET_PER_NEIGHBOR */
 
 #define MAX_QUEUED_PACKETS QUEUEBUF_NUM
+
+/* The number of queued packets that are kept for packets in the
+   priority lane (packets with PACKETBUF_ATTR_MAC_PRIORITY set, such as
+   RPL control messages). Other packets may not use these. */
+#ifdef CSMA_CONF_PRIORITY_RESERVE
+#define CSMA_PRIORITY_RESERVE CSMA_CONF_PRIORITY_RESERVE
+#else
+#define CSMA_PRIORITY_RESERVE (MAX_QUEUED_PACKETS > 2 ? 1 : 0)
+#endif /* CSMA_CONF_PRIORITY_RESERVE */
+
+/* The maximum number of priority packets queued for one neighbor.
+   Priority packets do not count against CSMA_MAX_PACKET_PER_NEIGHBOR,
+   but a neighbor may not hold more than this many of them. */
+#ifdef CSMA_CONF_MAX_PRIORITY_PER_NEIGHBOR
+#define CSMA_MAX_PRIORITY_PER_NEIGHBOR CSMA_CONF_MAX_PRIORITY_PER_NEIGHBOR
+#else
+#define CSMA_MAX_PRIORITY_PER_NEIGHBOR 2
+#endif /* CSMA_CONF_MAX_PRIORITY_PER_NEIGHBOR */
+
+/* The number of packets a neighbor queue may send per round of the
+   deficit round-robin scheduler. Can be set to a function of the
+   neighbor's link-layer address to favor some neighbors over others. */
+#ifdef CSMA_CONF_NEIGHBOR_WEIGHT
+#define CSMA_NEIGHBOR_WEIGHT(addr) CSMA_CONF_NEIGHBOR_WEIGHT(addr)
+#else
+#define CSMA_NEIGHBOR_WEIGHT(addr) 1
+#endif /* CSMA_CONF_NEIGHBOR_WEIGHT */
+
+/* Neighbor queues are found through a hash table, sized as the
+   smallest power of two that is not below the number of queues */
+#define NEIGHBOR_HASH_SIZE (CSMA_MAX_NEIGHBOR_QUEUES <= 2 ? 2 : \
+                            CSMA_MAX_NEIGHBOR_QUEUES <= 4 ? 4 : \
+                            CSMA_MAX_NEIGHBOR_QUEUES <= 8 ? 8 : \
+                            CSMA_MAX_NEIGHBOR_QUEUES <= 16 ? 16 : 32)
+
 MEMB(neighbor_memb, struct neighbor_queue, CSMA_MAX_NEIGHBOR_QUEUES);
 MEMB(packet_memb, struct rdc_buf_list, MAX_QUEUED_PACKETS);
 MEMB(metadata_memb, struct qbuf_metadata, MAX_QUEUED_PACKETS);
 LIST(neighbor_list);
 
+static struct neighbor_queue *neighbor_hash[NEIGHBOR_HASH_SIZE];
+
+/* The queue that has a packet list handed to the RDC layer, if any.
+   Only one queue is handed to the RDC layer at a time; queues whose
+   backoff has expired wait in turn for the scheduler. A queue whose
+   transmission the RDC layer deferred is not in flight: its packet
+   stays at the head of its queue until the RDC layer reports the
+   outcome, which is matched to the packet by sequence number. */
+static struct neighbor_queue *in_flight;
+/* The queue at which the round-robin scheduler resumes */
+static struct neighbor_queue *rr_next;
+
 static void packet_sent(void *ptr, int status, int num_transmissions);
 static void transmit_packet_list(void *ptr);
 /*---------------------------------------------------------------------------*/
+static int
+neighbor_hash_index(const linkaddr_t *addr)
+{
+  int i;
+  uint8_t h = 0;
+
+  for(i = 0; i < LINKADDR_SIZE; ++i) {
+    h = (h << 1) + h + addr->u8[i];
+  }
+  return h & (NEIGHBOR_HASH_SIZE - 1);
+}
+/*---------------------------------------------------------------------------*/
 static struct neighbor_queue *
 neighbor_queue_from_addr(const linkaddr_t *addr)
 {
-  struct neighbor_queue *n = list_head(neighbor_list);
+  struct neighbor_queue *n = neighbor_hash[neighbor_hash_index(addr)];
   while(n != NULL) {
     if(linkaddr_cmp(&n->addr, addr)) {
       return n;
     }
-    n = list_item_next(n);
+    n = n->hash_next;
   }
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+static void
+neighbor_queue_free(struct neighbor_queue *n)
+{
+  struct neighbor_queue **np;
+
+  for(np = &neighbor_hash[neighbor_hash_index(&n->addr)];
+      *np != NULL; np = &(*np)->hash_next) {
+    if(*np == n) {
+      *np = n->hash_next;
+      break;
+    }
+  }
+  if(rr_next == n) {
+    rr_next = list_item_next(n);
+  }
+  ctimer_stop(&n->transmit_timer);
+  list_remove(neighbor_list, n);
+  memb_free(&neighbor_memb, n);
+}
+/*---------------------------------------------------------------------------*/
+static int
+is_priority(struct rdc_buf_list *q)
+{
+  return q != NULL && ((struct qbuf_metadata *)q->ptr)->priority;
+}
+/*---------------------------------------------------------------------------*/
+static int
+priority_packets(struct neighbor_queue *n)
+{
+  struct rdc_buf_list *q;
+  int count = 0;
+
+  for(q = list_head(n->queued_packet_list); q != NULL; q = list_item_next(q)) {
+    if(is_priority(q)) {
+      count++;
+    }
+  }
+  return count;
+}
+/*---------------------------------------------------------------------------*/
 static clock_time_t
 backoff_period(void)
 {
@@ -163,19 +268,79 @@ backoff_period(void)
   return time;
 }
 /*---------------------------------------------------------------------------*/
+/* Pick the next queue to hand to the RDC layer among the queues whose
+   backoff has expired. Queues with a priority packet at their head are
+   served first; the others are served by deficit round-robin so that a
+   neighbor with a long queue does not starve the others. */
+static struct neighbor_queue *
+select_queue(void)
+{
+  struct neighbor_queue *n;
+  int i;
+
+  for(n = list_head(neighbor_list); n != NULL; n = list_item_next(n)) {
+    if(n->ready && is_priority(list_head(n->queued_packet_list))) {
+      return n;
+    }
+  }
+
+  n = rr_next;
+  for(i = 0; i < CSMA_MAX_NEIGHBOR_QUEUES; i++) {
+    if(n == NULL) {
+      n = list_head(neighbor_list);
+      if(n == NULL) {
+        break;
+      }
+    }
+    if(n->ready) {
+      if(n->deficit == 0) {
+        n->deficit = n->weight;
+      }
+      n->deficit--;
+      rr_next = n->deficit > 0 ? n : list_item_next(n);
+      return n;
+    }
+    /* A queue that is not ready gives up the rest of its turn */
+    n->deficit = 0;
+    n = list_item_next(n);
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
 static void
-transmit_packet_list(void *ptr)
+run_scheduler(void)
 {
-  struct neighbor_queue *n = ptr;
-  if(n) {
-    struct rdc_buf_list *q = list_head(n->queued_packet_list);
+  static uint8_t running;
+  struct neighbor_queue *n;
+  struct rdc_buf_list *q;
+
+  /* The RDC layer may call packet_sent() from within send_list() */
+  if(running) {
+    return;
+  }
+  running = 1;
+  while(in_flight == NULL && (n = select_queue()) != NULL) {
+    n->ready = 0;
+    q = list_head(n->queued_packet_list);
     if(q != NULL) {
       PRINTF("csma: preparing number %d %p, queue len %d\n", n->transmissions, q,
           list_length(n->queued_packet_list));
+      in_flight = n;
       /* Send packets in the neighbor's list */
       NETSTACK_RDC.send_list(packet_sent, n, q);
     }
   }
+  running = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+transmit_packet_list(void *ptr)
+{
+  struct neighbor_queue *n = ptr;
+  if(n) {
+    n->ready = 1;
+    run_scheduler();
+  }
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -195,6 +360,7 @@ schedule_transmission(struct neighbor_queue *n)
 
   PRINTF("csma: scheduling transmission in %u ticks, NB=%u, BE=%u\n",
       (unsigned)delay, n->collisions, backoff_exponent);
+  n->ready = 0;
   ctimer_set(&n->transmit_timer, delay, transmit_packet_list, n);
 }
 /*---------------------------------------------------------------------------*/
@@ -218,9 +384,7 @@ free_packet(struct neighbor_queue *n, struct rdc_buf_list *p, int status)
       schedule_transmission(n);
     } else {
       /* This was the last packet in the queue, we free the neighbor */
-      ctimer_stop(&n->transmit_timer);
-      list_remove(neighbor_list, n);
-      memb_free(&neighbor_memb, n);
+      neighbor_queue_free(n);
     }
   }
 }
@@ -326,6 +490,14 @@ packet_sent(void *ptr, int status, int num_transmissions)
     return;
   }
 
+  if(n == in_flight) {
+    /* Also on MAC_TX_DEFERRED: the RDC layer holds on to the packet
+       and calls back later, and the other queues must not wait for
+       it meanwhile. n is not ready, so it is not selected again before
+       the outcome is known. */
+    in_flight = NULL;
+  }
+
   /* Find out what packet this callback refers to */
   for(q = list_head(n->queued_packet_list);
       q != NULL; q = list_item_next(q)) {
@@ -338,9 +510,11 @@ packet_sent(void *ptr, int status, int num_transmissions)
   if(q == NULL) {
     PRINTF("csma: seqno %d not found\n",
            packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO));
+    run_scheduler();
     return;
   } else if(q->ptr == NULL) {
     PRINTF("csma: no metadata\n");
+    run_scheduler();
     return;
   }
 
@@ -360,6 +534,7 @@ packet_sent(void *ptr, int status, int num_transmissions)
     tx_done(status, q, n);
     break;
   }
+  run_scheduler();
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -370,6 +545,9 @@ send_packet(mac_callback_t sent, void *ptr)
   static uint8_t initialized = 0;
   static uint16_t seqno;
   const linkaddr_t *addr = packetbuf_addr(PACKETBUF_ADDR_RECEIVER);
+  uint8_t priority = packetbuf_attr(PACKETBUF_ATTR_MAC_PRIORITY) != 0;
+
+  TRACE(TRACE_MAC_OUTPUT, packetbuf_totlen(), 0, 0);
 
   if(!initialized) {
     initialized = 1;
@@ -394,16 +572,27 @@ send_packet(mac_callback_t sent, void *ptr)
       linkaddr_copy(&n->addr, addr);
       n->transmissions = 0;
       n->collisions = CSMA_MIN_BE;
+      n->ready = 0;
+      n->weight = CSMA_NEIGHBOR_WEIGHT(addr);
+      n->deficit = 0;
       /* Init packet list for this neighbor */
       LIST_STRUCT_INIT(n, queued_packet_list);
-      /* Add neighbor to the list */
+      /* Add neighbor to the list and to the hash table */
       list_add(neighbor_list, n);
+      n->hash_next = neighbor_hash[neighbor_hash_index(addr)];
+      neighbor_hash[neighbor_hash_index(addr)] = n;
     }
   }
 
   if(n != NULL) {
-    /* Add packet to the neighbor's queue */
-    if(list_length(n->queued_packet_list) < CSMA_MAX_PACKET_PER_NEIGHBOR) {
+    /* Add packet to the neighbor's queue. Priority packets are not
+       subject to the per-neighbor limit and may use the reserved
+       packets, but have a limit of their own. */
+    if((priority &&
+        priority_packets(n) < CSMA_MAX_PRIORITY_PER_NEIGHBOR) ||
+       (!priority &&
+        list_length(n->queued_packet_list) < CSMA_MAX_PACKET_PER_NEIGHBOR &&
+        memb_numfree(&packet_memb) > CSMA_PRIORITY_RESERVE)) {
       q = memb_alloc(&packet_memb);
       if(q != NULL) {
         q->ptr = memb_alloc(&metadata_memb);
@@ -421,13 +610,22 @@ send_packet(mac_callback_t sent, void *ptr)
             }
             metadata->sent = sent;
             metadata->cptr = ptr;
+            metadata->priority = priority;
 #if PACKETBUF_WITH_PACKET_TYPE
             if(packetbuf_attr(PACKETBUF_ATTR_PACKET_TYPE) ==
                PACKETBUF_ATTR_PACKET_TYPE_ACK) {
               list_push(n->queued_packet_list, q);
             } else
 #endif
-            {
+            if(priority && list_head(n->queued_packet_list) != NULL) {
+              /* Queue behind the packet being transmitted and the other
+                 priority packets, but ahead of all other packets */
+              struct rdc_buf_list *prev = list_head(n->queued_packet_list);
+              while(is_priority(list_item_next(prev))) {
+                prev = list_item_next(prev);
+              }
+              list_insert(n->queued_packet_list, prev, q);
+            } else {
               list_add(n->queued_packet_list, q);
             }
 
@@ -447,8 +645,7 @@ send_packet(mac_callback_t sent, void *ptr)
       }
       /* The packet allocation failed. Remove and free neighbor entry if empty. */
       if(list_length(n->queued_packet_list) == 0) {
-        list_remove(neighbor_list, n);
-        memb_free(&neighbor_memb, n);
+        neighbor_queue_free(n);
       }
     } else {
       PRINTF("csma: Neighbor queue full\n");
@@ -463,6 +660,7 @@ send_packet(mac_callback_t sent, void *ptr)
 static void
 input_packet(void)
 {
+  TRACE(TRACE_MAC_INPUT, packetbuf_datalen(), 0, 0);
   NETSTACK_LLSEC.input();
 }
 /*---------------------------------------------------------------------------*/
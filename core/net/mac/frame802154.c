@@ -464,6 +464,68 @@ frame802154_create(frame802154_t *p, uint8_t *buf)
 
   return (int)pos;
 }
+/*----------------------------------------------------------------------------*/
+/**
+ *   \brief Creates a frame header template.  The header is built once, as
+ *   by frame802154_create(), and the positions of the fields that change
+ *   from one frame to the next are recorded.
+ *
+ *   \param p Pointer to frame802154_t struct, which specifies the
+ *   frames to send.
+ *
+ *   \param t The template to fill in.
+ *
+ *   \return The length of the frame header
+ */
+int
+frame802154_template_create(frame802154_t *p, frame802154_template_t *t)
+{
+  field_length_t flen;
+
+  t->hdr_len = frame802154_create(p, t->hdr);
+  field_len(p, &flen);
+  t->seq_pos = flen.seqno_len ? 2 : 0;
+  t->frame_counter_pos = 0;
+#if LLSEC802154_USES_AUX_HEADER
+  if(flen.aux_sec_len
+     && p->aux_hdr.security_control.frame_counter_suppression == 0) {
+    /* The frame counter follows the security control byte */
+    t->frame_counter_pos = 2 + flen.seqno_len + flen.dest_pid_len + flen.dest_addr_len +
+      flen.src_pid_len + flen.src_addr_len + 1;
+  }
+#endif /* LLSEC802154_USES_AUX_HEADER */
+  return t->hdr_len;
+}
+/*----------------------------------------------------------------------------*/
+/**
+ *   \brief Writes the header of a template to a buffer, with the given
+ *   sequence number and frame counter.
+ *
+ *   \param t The template, set up with frame802154_template_create().
+ *
+ *   \param buf Pointer to the buffer to use for the frame.
+ *
+ *   \param seq The sequence number, ignored if the template has none.
+ *
+ *   \param frame_counter The frame counter, ignored if NULL or if the
+ *   template has none.
+ *
+ *   \return The length of the frame header
+ */
+int
+frame802154_template_apply(const frame802154_template_t *t, uint8_t *buf,
+                           uint8_t seq, const frame802154_frame_counter_t *frame_counter)
+{
+  memcpy(buf, t->hdr, t->hdr_len);
+  if(t->seq_pos) {
+    buf[t->seq_pos] = seq;
+  }
+  if(t->frame_counter_pos && frame_counter != NULL) {
+    /* We support only 4-byte counters */
+    memcpy(buf + t->frame_counter_pos, frame_counter->u8, 4);
+  }
+  return t->hdr_len;
+}
 
 void
 frame802154_parse_fcf(uint8_t *data, frame802154_fcf_t *pfcf)
@@ -634,4 +696,68 @@ frame802154_parse(uint8_t *data, int len, frame802154_t *pf)
   /* return header length if successful */
   return c > len ? 0 : c;
 }
+/*----------------------------------------------------------------------------*/
+/**
+ *   \brief Checks an input frame before parsing it.  Only the FCF and the
+ *   destination fields are looked at, so frames that are bound to be
+ *   dropped are rejected at little cost.
+ *
+ *   \param data The input data from the radio chip.
+ *   \param len The size of the input data
+ *   \param own_addr Our link-layer address, or NULL to accept unicast
+ *   frames to any destination.
+ *
+ *   \return 0 if the frame is too short for its destination fields, is
+ *   for another PAN, or (if own_addr is set) is a unicast frame for
+ *   another node; 1 otherwise.
+ */
+int
+frame802154_prefilter(const uint8_t *data, int len, const linkaddr_t *own_addr)
+{
+  frame802154_fcf_t fcf;
+  int has_dest_panid;
+  int dest_addr_len;
+  int pos;
+  int c;
+
+  if(len < 2) {
+    return 0;
+  }
+  frame802154_parse_fcf((uint8_t *)data, &fcf);
+  dest_addr_len = addr_len(fcf.dest_addr_mode);
+  if(dest_addr_len == 0) {
+    /* No destination address, nothing to check */
+    return 1;
+  }
+  frame802154_has_panid(&fcf, NULL, &has_dest_panid);
+
+  pos = fcf.sequence_number_suppression ? 2 : 3;
+  if(len < pos + (has_dest_panid ? 2 : 0) + dest_addr_len) {
+    return 0;
+  }
+
+  if(has_dest_panid) {
+    uint16_t dest_pid = data[pos] + (data[pos + 1] << 8);
+    if(dest_pid != mac_pan_id && dest_pid != FRAME802154_BROADCASTPANDID) {
+      /* Frame for another PAN */
+      return 0;
+    }
+    pos += 2;
+  }
+
+  if(own_addr == NULL
+     || frame802154_is_broadcast_addr(fcf.dest_addr_mode, (uint8_t *)data + pos)) {
+    return 1;
+  }
+  if(dest_addr_len != LINKADDR_SIZE) {
+    return 0;
+  }
+  /* Addresses are sent in reverse byte order */
+  for(c = 0; c < dest_addr_len; c++) {
+    if(data[pos + dest_addr_len - 1 - c] != own_addr->u8[c]) {
+      return 0;
+    }
+  }
+  return 1;
+}
 /** \}   */
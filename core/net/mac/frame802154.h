@@ -88,6 +88,11 @@
 
 /* Macros & Defines */
 
+/** \brief Largest header frame802154_create() can produce: FCF, seqno,
+ *  two PAN IDs, two long addresses and an aux security header with a
+ *  5-byte frame counter and a 9-byte key identifier */
+#define FRAME802154_MAX_HDR_LEN     38
+
 /** \brief These are some definitions of values used in the FCF.  See the 802.15.4 spec for details.
  *  \name FCF element values definitions
  *  @{
@@ -204,6 +209,18 @@ typedef struct {
   int payload_len;                /**< Length of payload field */
 } frame802154_t;
 
+/** \brief A frame header built once by frame802154_template_create() and
+ *  reused for every following frame with the same parameters. Only the
+ *  sequence number and the frame counter change from frame to frame; they
+ *  are patched in by frame802154_template_apply().
+ */
+typedef struct {
+  uint8_t hdr[FRAME802154_MAX_HDR_LEN]; /**< Header bytes */
+  uint8_t hdr_len;                      /**< Header length */
+  uint8_t seq_pos;                      /**< Offset of the sequence number, 0 if suppressed */
+  uint8_t frame_counter_pos;            /**< Offset of the frame counter, 0 if none */
+} frame802154_template_t;
+
 /* Prototypes */
 
 int frame802154_hdrlen(frame802154_t *p);
@@ -211,6 +228,10 @@ void frame802154_create_fcf(frame802154_fcf_t *fcf, uint8_t *buf);
 int frame802154_create(frame802154_t *p, uint8_t *buf);
 int frame802154_parse(uint8_t *data, int length, frame802154_t *pf);
 void frame802154_parse_fcf(uint8_t *data, frame802154_fcf_t *pfcf);
+int frame802154_template_create(frame802154_t *p, frame802154_template_t *t);
+int frame802154_template_apply(const frame802154_template_t *t, uint8_t *buf,
+                               uint8_t seq, const frame802154_frame_counter_t *frame_counter);
+int frame802154_prefilter(const uint8_t *data, int len, const linkaddr_t *own_addr);
 
 /* Get current PAN ID */
 uint16_t frame802154_get_pan_id(void);
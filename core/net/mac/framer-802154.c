@@ -62,34 +62,99 @@ static uint8_t mac_dsn;
 
 static uint8_t initialized = 0;
 
+/* Number of frame header templates kept. Frames that go to the same
+ * destination with the same security parameters reuse the header built
+ * for the first of them. */
+#ifdef FRAMER_802154_CONF_TEMPLATES
+#define FRAMER_802154_TEMPLATES FRAMER_802154_CONF_TEMPLATES
+#else /* FRAMER_802154_CONF_TEMPLATES */
+#define FRAMER_802154_TEMPLATES 4
+#endif /* FRAMER_802154_CONF_TEMPLATES */
+
+/* Everything a header depends on, except the sequence number and
+ * the frame counter */
+struct template_key {
+  linkaddr_t dest;
+  linkaddr_t src;
+  uint16_t pan_id;
+  uint8_t frame_type;
+  uint8_t pending;
+  uint8_t ack_required;
+#if LLSEC802154_USES_AUX_HEADER
+  uint8_t security_level;
+#if LLSEC802154_USES_EXPLICIT_KEYS
+  uint8_t key_id_mode;
+  uint8_t key_index;
+  uint16_t key_source;
+#endif /* LLSEC802154_USES_EXPLICIT_KEYS */
+#endif /* LLSEC802154_USES_AUX_HEADER */
+};
+
+struct template {
+  struct template_key key;
+  frame802154_template_t t;
+  uint8_t used;
+};
+
+static struct template templates[FRAMER_802154_TEMPLATES];
+static uint8_t next_template;
+
 /*---------------------------------------------------------------------------*/
-static int
-create_frame(int type, int do_create)
+static void
+get_key(struct template_key *key)
 {
-  frame802154_t params;
-  int hdr_len;
-
-  if(frame802154_get_pan_id() == 0xffff) {
-    return -1;
+  /* Cleared as a whole, so that keys can be compared with memcmp */
+  memset(key, 0, sizeof(struct template_key));
+  if(!packetbuf_holds_broadcast()) {
+    linkaddr_copy(&key->dest, packetbuf_addr(PACKETBUF_ADDR_RECEIVER));
+    key->ack_required = packetbuf_attr(PACKETBUF_ATTR_MAC_ACK);
+  }
+  linkaddr_copy(&key->src, packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  key->pan_id = frame802154_get_pan_id();
+  key->frame_type = packetbuf_attr(PACKETBUF_ATTR_FRAME_TYPE);
+  key->pending = packetbuf_attr(PACKETBUF_ATTR_PENDING);
+#if LLSEC802154_USES_AUX_HEADER
+  key->security_level = packetbuf_attr(PACKETBUF_ATTR_SECURITY_LEVEL);
+#if LLSEC802154_USES_EXPLICIT_KEYS
+  key->key_id_mode = packetbuf_attr(PACKETBUF_ATTR_KEY_ID_MODE);
+  key->key_index = packetbuf_attr(PACKETBUF_ATTR_KEY_INDEX);
+  key->key_source = packetbuf_attr(PACKETBUF_ATTR_KEY_SOURCE_BYTES_0_1);
+#endif /* LLSEC802154_USES_EXPLICIT_KEYS */
+#endif /* LLSEC802154_USES_AUX_HEADER */
+}
+/*---------------------------------------------------------------------------*/
+static struct template *
+lookup_template(const struct template_key *key)
+{
+  int i;
+  for(i = 0; i < FRAMER_802154_TEMPLATES; i++) {
+    if(templates[i].used
+       && memcmp(&templates[i].key, key, sizeof(struct template_key)) == 0) {
+      return &templates[i];
+    }
   }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Builds a new template from the packetbuf, replacing the oldest one */
+static struct template *
+new_template(const struct template_key *key)
+{
+  frame802154_t params;
+  struct template *tp;
 
   /* init to zeros */
   memset(&params, 0, sizeof(params));
 
-  if(!initialized) {
-    initialized = 1;
-    mac_dsn = random_rand() & 0xff;
-  }
-
   /* Build the FCF. */
-  params.fcf.frame_type = packetbuf_attr(PACKETBUF_ATTR_FRAME_TYPE);
-  params.fcf.frame_pending = packetbuf_attr(PACKETBUF_ATTR_PENDING);
+  params.fcf.frame_type = key->frame_type;
+  params.fcf.frame_pending = key->pending;
   if(packetbuf_holds_broadcast()) {
     params.fcf.ack_required = 0;
     /* Suppress seqno on broadcast if supported (frame v2 or more) */
     params.fcf.sequence_number_suppression = FRAME802154_VERSION >= FRAME802154_IEEE802154E_2012;
   } else {
-    params.fcf.ack_required = packetbuf_attr(PACKETBUF_ATTR_MAC_ACK);
+    params.fcf.ack_required = key->ack_required;
     params.fcf.sequence_number_suppression = FRAME802154_SUPPR_SEQNO;
   }
   /* We do not compress PAN ID in outgoing frames, i.e. include one PAN ID (dest by default)
@@ -99,44 +164,24 @@ create_frame(int type, int do_create)
 
   /* Insert IEEE 802.15.4 version bits. */
   params.fcf.frame_version = FRAME802154_VERSION;
-  
+
 #if LLSEC802154_USES_AUX_HEADER
-  if(packetbuf_attr(PACKETBUF_ATTR_SECURITY_LEVEL)) {
+  if(key->security_level) {
     params.fcf.security_enabled = 1;
   }
   /* Setting security-related attributes */
-  params.aux_hdr.security_control.security_level = packetbuf_attr(PACKETBUF_ATTR_SECURITY_LEVEL);
-#if LLSEC802154_USES_FRAME_COUNTER
-  params.aux_hdr.frame_counter.u16[0] = packetbuf_attr(PACKETBUF_ATTR_FRAME_COUNTER_BYTES_0_1);
-  params.aux_hdr.frame_counter.u16[1] = packetbuf_attr(PACKETBUF_ATTR_FRAME_COUNTER_BYTES_2_3);
-#else /* LLSEC802154_USES_FRAME_COUNTER */
+  params.aux_hdr.security_control.security_level = key->security_level;
+#if !LLSEC802154_USES_FRAME_COUNTER
   params.aux_hdr.security_control.frame_counter_suppression = 1;
   params.aux_hdr.security_control.frame_counter_size = 1;
-#endif /* LLSEC802154_USES_FRAME_COUNTER */
+#endif /* !LLSEC802154_USES_FRAME_COUNTER */
 #if LLSEC802154_USES_EXPLICIT_KEYS
-  params.aux_hdr.security_control.key_id_mode = packetbuf_attr(PACKETBUF_ATTR_KEY_ID_MODE);
-  params.aux_hdr.key_index = packetbuf_attr(PACKETBUF_ATTR_KEY_INDEX);
-  params.aux_hdr.key_source.u16[0] = packetbuf_attr(PACKETBUF_ATTR_KEY_SOURCE_BYTES_0_1);
+  params.aux_hdr.security_control.key_id_mode = key->key_id_mode;
+  params.aux_hdr.key_index = key->key_index;
+  params.aux_hdr.key_source.u16[0] = key->key_source;
 #endif /* LLSEC802154_USES_EXPLICIT_KEYS */
 #endif /* LLSEC802154_USES_AUX_HEADER */
 
-  /* Increment and set the data sequence number. */
-  if(!do_create) {
-    /* Only length calculation - no sequence number is needed and
-       should not be consumed. */
-
-  } else if(packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO)) {
-    params.seq = packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO);
-
-  } else {
-    /* Ensure that the sequence number 0 is not used as it would bypass the above check. */
-    if(mac_dsn == 0) {
-      mac_dsn++;
-    }
-    params.seq = mac_dsn++;
-    packetbuf_set_attr(PACKETBUF_ATTR_MAC_SEQNO, params.seq);
-  }
-
   /* Complete the addressing fields. */
   /**
      \todo For phase 1 the addresses are all long. We'll need a mechanism
@@ -148,7 +193,7 @@ create_frame(int type, int do_create)
   } else {
     params.fcf.src_addr_mode = FRAME802154_LONGADDRMODE;
   }
-  params.dest_pid = frame802154_get_pan_id();
+  params.dest_pid = key->pan_id;
 
   if(packetbuf_holds_broadcast()) {
     /* Broadcast requires short address mode. */
@@ -156,8 +201,7 @@ create_frame(int type, int do_create)
     params.dest_addr[0] = 0xFF;
     params.dest_addr[1] = 0xFF;
   } else {
-    linkaddr_copy((linkaddr_t *)&params.dest_addr,
-                  packetbuf_addr(PACKETBUF_ADDR_RECEIVER));
+    linkaddr_copy((linkaddr_t *)&params.dest_addr, &key->dest);
     /* Use short address mode if linkaddr size is small */
     if(LINKADDR_SIZE == 2) {
       params.fcf.dest_addr_mode = FRAME802154_SHORTADDRMODE;
@@ -167,26 +211,78 @@ create_frame(int type, int do_create)
   }
 
   /* Set the source PAN ID to the global variable. */
-  params.src_pid = frame802154_get_pan_id();
+  params.src_pid = key->pan_id;
 
   /*
    * Set up the source address using only the long address mode for
    * phase 1.
    */
-  linkaddr_copy((linkaddr_t *)&params.src_addr,
-                packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  linkaddr_copy((linkaddr_t *)&params.src_addr, &key->src);
+
+  tp = &templates[next_template];
+  next_template = (next_template + 1) % FRAMER_802154_TEMPLATES;
+  memcpy(&tp->key, key, sizeof(struct template_key));
+  frame802154_template_create(&params, &tp->t);
+  tp->used = 1;
+  return tp;
+}
+/*---------------------------------------------------------------------------*/
+static int
+create_frame(int type, int do_create)
+{
+  struct template_key key;
+  struct template *tp;
+  uint8_t seq = 0;
+  int hdr_len;
+#if LLSEC802154_USES_FRAME_COUNTER
+  frame802154_frame_counter_t frame_counter;
+#endif /* LLSEC802154_USES_FRAME_COUNTER */
+
+  if(frame802154_get_pan_id() == 0xffff) {
+    return -1;
+  }
+
+  if(!initialized) {
+    initialized = 1;
+    mac_dsn = random_rand() & 0xff;
+  }
+
+  get_key(&key);
+  tp = lookup_template(&key);
+  if(tp == NULL) {
+    tp = new_template(&key);
+  }
+  hdr_len = tp->t.hdr_len;
 
-  params.payload = packetbuf_dataptr();
-  params.payload_len = packetbuf_datalen();
-  hdr_len = frame802154_hdrlen(&params);
+  /* Increment and set the data sequence number. */
   if(!do_create) {
-    /* Only calculate header length */
+    /* Only length calculation - no sequence number is needed and
+       should not be consumed. */
     return hdr_len;
-  } else if(packetbuf_hdralloc(hdr_len)) {
-    frame802154_create(&params, packetbuf_hdrptr());
 
-    PRINTF("15.4-OUT: %2X", params.fcf.frame_type);
-    PRINTADDR(params.dest_addr);
+  } else if(packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO)) {
+    seq = packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO);
+
+  } else {
+    /* Ensure that the sequence number 0 is not used as it would bypass the above check. */
+    if(mac_dsn == 0) {
+      mac_dsn++;
+    }
+    seq = mac_dsn++;
+    packetbuf_set_attr(PACKETBUF_ATTR_MAC_SEQNO, seq);
+  }
+
+  if(packetbuf_hdralloc(hdr_len)) {
+#if LLSEC802154_USES_FRAME_COUNTER
+    frame_counter.u16[0] = packetbuf_attr(PACKETBUF_ATTR_FRAME_COUNTER_BYTES_0_1);
+    frame_counter.u16[1] = packetbuf_attr(PACKETBUF_ATTR_FRAME_COUNTER_BYTES_2_3);
+    frame802154_template_apply(&tp->t, packetbuf_hdrptr(), seq, &frame_counter);
+#else /* LLSEC802154_USES_FRAME_COUNTER */
+    frame802154_template_apply(&tp->t, packetbuf_hdrptr(), seq, NULL);
+#endif /* LLSEC802154_USES_FRAME_COUNTER */
+
+    PRINTF("15.4-OUT: %2X", key.frame_type);
+    PRINTADDR(&key.dest);
     PRINTF("%d %u (%u)\n", hdr_len, packetbuf_datalen(), packetbuf_totlen());
 
     return hdr_len;
@@ -214,6 +310,12 @@ parse(void)
   frame802154_t frame;
   int hdr_len;
 
+  /* Drop frames for another PAN before parsing them in full */
+  if(!frame802154_prefilter(packetbuf_dataptr(), packetbuf_datalen(), NULL)) {
+    PRINTF("15.4: early reject\n");
+    return FRAMER_FAILED;
+  }
+
   hdr_len = frame802154_parse(packetbuf_dataptr(), packetbuf_datalen(), &frame);
 
   if(hdr_len && packetbuf_hdrreduce(hdr_len)) {
@@ -42,17 +42,19 @@
  *         Benoît Thébaudeau <benoit.thebaudeau@advansee.com>
  */
 
-#include <string.h>
-
 #include "contiki-net.h"
 #include "net/mac/mac-sequence.h"
+#include "net/nbr-table.h"
 #include "net/packetbuf.h"
 #include "net/rime/rime.h"
 
 struct seqno {
   linkaddr_t sender;
   clock_time_t timestamp;
+  /* Highest sequence number received from the sender */
   uint8_t seqno;
+  /* Bit i is set if sequence number (seqno - 1 - i) was received */
+  uint8_t window;
 };
 
 #ifdef NETSTACK_CONF_MAC_SEQNO_MAX_AGE
@@ -61,39 +63,113 @@ struct seqno {
 #define SEQNO_MAX_AGE (20 * CLOCK_SECOND)
 #endif /* NETSTACK_CONF_MAC_SEQNO_MAX_AGE */
 
+/* Number of senders tracked. By default, at least one per neighbor */
 #ifdef NETSTACK_CONF_MAC_SEQNO_HISTORY
 #define MAX_SEQNOS NETSTACK_CONF_MAC_SEQNO_HISTORY
+#elif NBR_TABLE_MAX_NEIGHBORS > 16
+#define MAX_SEQNOS NBR_TABLE_MAX_NEIGHBORS
 #else /* NETSTACK_CONF_MAC_SEQNO_HISTORY */
 #define MAX_SEQNOS 16
 #endif /* NETSTACK_CONF_MAC_SEQNO_HISTORY */
+
+/* Number of sequence numbers below the highest one that are remembered
+ * per sender (at most 8) */
+#ifdef NETSTACK_CONF_MAC_SEQNO_WINDOW
+#define SEQNO_WINDOW NETSTACK_CONF_MAC_SEQNO_WINDOW
+#else /* NETSTACK_CONF_MAC_SEQNO_WINDOW */
+#define SEQNO_WINDOW 4
+#endif /* NETSTACK_CONF_MAC_SEQNO_WINDOW */
+
+#if SEQNO_WINDOW > 8
+#error NETSTACK_CONF_MAC_SEQNO_WINDOW must be at most 8, the width of the window bitmap
+#endif
+
+/* Senders are hashed into the table; this many consecutive slots are
+ * tried before the oldest of them is recycled */
+#define SEQNO_PROBES (MAX_SEQNOS < 4 ? MAX_SEQNOS : 4)
+
 static struct seqno received_seqnos[MAX_SEQNOS];
 
 /*---------------------------------------------------------------------------*/
-int
-mac_sequence_is_duplicate(void)
+static int
+sender_hash(const linkaddr_t *addr)
 {
   int i;
+  uint16_t h = 0;
+
+  for(i = 0; i < LINKADDR_SIZE; ++i) {
+    h = (h << 3) + h + addr->u8[i];
+  }
+  return h % MAX_SEQNOS;
+}
+/*---------------------------------------------------------------------------*/
+static struct seqno *
+lookup(const linkaddr_t *addr)
+{
+  int i, index;
+
+  index = sender_hash(addr);
+  for(i = 0; i < SEQNO_PROBES; ++i) {
+    if(linkaddr_cmp(addr, &received_seqnos[index].sender)) {
+      return &received_seqnos[index];
+    }
+    index = (index + 1) % MAX_SEQNOS;
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct seqno *
+allocate(const linkaddr_t *addr)
+{
+  int i, index;
+  struct seqno *oldest = NULL;
   clock_time_t now = clock_time();
 
+  index = sender_hash(addr);
+  for(i = 0; i < SEQNO_PROBES; ++i) {
+    struct seqno *s = &received_seqnos[index];
+    if(linkaddr_cmp(&s->sender, &linkaddr_null)) {
+      oldest = s;
+      break;
+    }
+    if(oldest == NULL || now - s->timestamp > now - oldest->timestamp) {
+      oldest = s;
+    }
+    index = (index + 1) % MAX_SEQNOS;
+  }
+  linkaddr_copy(&oldest->sender, addr);
+  return oldest;
+}
+/*---------------------------------------------------------------------------*/
+int
+mac_sequence_is_duplicate(void)
+{
+  struct seqno *s;
+  uint8_t seqno;
+  uint8_t distance;
+
   /*
    * Check for duplicate packet by comparing the sequence number of the incoming
-   * packet with the last few ones we saw.
+   * packet with the last few ones we saw from the same sender.
    */
-  for(i = 0; i < MAX_SEQNOS; ++i) {
-    if(linkaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_SENDER),
-                    &received_seqnos[i].sender)) {
-      if(packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO) == received_seqnos[i].seqno) {
+  s = lookup(packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  if(s == NULL) {
+    return 0;
+  }
 #if SEQNO_MAX_AGE > 0
-        if(now - received_seqnos[i].timestamp <= SEQNO_MAX_AGE) {
-          /* Duplicate packet. */
-          return 1;
-        }
-#else /* SEQNO_MAX_AGE > 0 */
-        return 1;
+  if(clock_time() - s->timestamp > SEQNO_MAX_AGE) {
+    return 0;
+  }
 #endif /* SEQNO_MAX_AGE > 0 */
-      }
-      break;
-    }
+
+  seqno = packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO);
+  distance = s->seqno - seqno;
+  if(distance == 0) {
+    /* Duplicate packet. */
+    return 1;
+  }
+  if(distance <= SEQNO_WINDOW) {
+    return (s->window >> (distance - 1)) & 1;
   }
   return 0;
 }
@@ -101,24 +177,41 @@ mac_sequence_is_duplicate(void)
 void
 mac_sequence_register_seqno(void)
 {
-  int i, j;
+  struct seqno *s;
+  uint8_t seqno;
+  uint8_t ahead;
+  clock_time_t now = clock_time();
 
-  /* Locate possible previous sequence number for this address. */
-  for(i = 0; i < MAX_SEQNOS; ++i) {
-    if(linkaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_SENDER),
-                    &received_seqnos[i].sender)) {
-      i++;
-      break;
+  seqno = packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO);
+  s = lookup(packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  if(s == NULL
+#if SEQNO_MAX_AGE > 0
+     || now - s->timestamp > SEQNO_MAX_AGE
+#endif /* SEQNO_MAX_AGE > 0 */
+     ) {
+    if(s == NULL) {
+      s = allocate(packetbuf_addr(PACKETBUF_ADDR_SENDER));
+    }
+    s->seqno = seqno;
+    s->window = 0;
+  } else {
+    ahead = seqno - s->seqno;
+    if(ahead == 0) {
+      /* Same sequence number, nothing to record */
+    } else if(ahead < 128) {
+      /* Newer sequence number: slide the window */
+      s->window = ahead <= SEQNO_WINDOW ?
+        (s->window << ahead) | (1 << (ahead - 1)) : 0;
+      s->seqno = seqno;
+    } else if((uint8_t)-ahead <= SEQNO_WINDOW) {
+      /* Late packet within the window */
+      s->window |= 1 << ((uint8_t)-ahead - 1);
+    } else {
+      /* Far behind, the sender has probably restarted */
+      s->seqno = seqno;
+      s->window = 0;
     }
   }
-
-  /* Keep the last sequence number for each address as per 802.15.4e. */
-  for(j = i - 1; j > 0; --j) {
-    memcpy(&received_seqnos[j], &received_seqnos[j - 1], sizeof(struct seqno));
-  }
-  received_seqnos[0].seqno = packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO);
-  received_seqnos[0].timestamp = clock_time();
-  linkaddr_copy(&received_seqnos[0].sender,
-                packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  s->timestamp = now;
 }
 /*---------------------------------------------------------------------------*/
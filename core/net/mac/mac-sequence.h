@@ -51,7 +51,9 @@
  *
  *             This function is used to check for duplicate packet by comparing
  *             the sequence number of the incoming packet with the last few ones
- *             we saw, filtering with the Rime address.
+ *             we saw from the same sender. Senders are kept in a small hash
+ *             table, each with a window of NETSTACK_CONF_MAC_SEQNO_WINDOW
+ *             recent sequence numbers.
  */
 int mac_sequence_is_duplicate(void);
 
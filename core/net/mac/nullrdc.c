@@ -107,14 +107,22 @@
 #include "net/mac/frame802154.h"
 #endif /* NULLRDC_SEND_802154_ACK */
 
+/* Back-to-back mode: the packets of a list are transmitted one right after
+ * the other, with the frame pending bit set on all but the last one, and
+ * the upper layer is told about the results only once the list is done. */
+#ifdef NULLRDC_CONF_BURST
+#define NULLRDC_BURST NULLRDC_CONF_BURST
+#else /* NULLRDC_CONF_BURST */
+#define NULLRDC_BURST 0
+#endif /* NULLRDC_CONF_BURST */
+
 #define ACK_LEN 3
 
 /*---------------------------------------------------------------------------*/
 static int
-send_one_packet(mac_callback_t sent, void *ptr)
+transmit_one_packet(void)
 {
   int ret;
-  int last_sent_ok = 0;
 
   packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &linkaddr_node_addr);
 #if NULLRDC_802154_AUTOACK || NULLRDC_802154_AUTOACK_HW
@@ -227,11 +235,17 @@ send_one_packet(mac_callback_t sent, void *ptr)
 
 #endif /* ! NULLRDC_802154_AUTOACK */
   }
-  if(ret == MAC_TX_OK) {
-    last_sent_ok = 1;
-  }
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
+static int
+send_one_packet(mac_callback_t sent, void *ptr)
+{
+  int ret;
+
+  ret = transmit_one_packet();
   mac_call_sent_callback(sent, ptr, ret, 1);
-  return last_sent_ok;
+  return ret == MAC_TX_OK;
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -243,6 +257,28 @@ send_packet(mac_callback_t sent, void *ptr)
 static void
 send_list(mac_callback_t sent, void *ptr, struct rdc_buf_list *buf_list)
 {
+#if NULLRDC_BURST
+  struct rdc_buf_list *b;
+  int count = 0;
+  int ret = MAC_TX_OK;
+
+  /* Transmit until the list is done or a packet fails */
+  for(b = buf_list; b != NULL && ret == MAC_TX_OK; b = b->next) {
+    queuebuf_to_packetbuf(b->buf);
+    packetbuf_set_attr(PACKETBUF_ATTR_PENDING, b->next != NULL);
+    ret = transmit_one_packet();
+    count++;
+  }
+
+  /* Report every transmitted packet, in order. We backup the next pointer,
+   * as it may be nullified by mac_call_sent_callback() */
+  for(b = buf_list; count > 0; count--) {
+    struct rdc_buf_list *next = b->next;
+    queuebuf_to_packetbuf(b->buf);
+    mac_call_sent_callback(sent, ptr, count == 1 ? ret : MAC_TX_OK, 1);
+    b = next;
+  }
+#else /* NULLRDC_BURST */
   while(buf_list != NULL) {
     /* We backup the next pointer, as it may be nullified by
      * mac_call_sent_callback() */
@@ -260,6 +296,7 @@ send_list(mac_callback_t sent, void *ptr, struct rdc_buf_list *buf_list)
     }
     buf_list = next;
   }
+#endif /* NULLRDC_BURST */
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -42,6 +42,7 @@
 #include "net/mac/tsch/tsch-conf.h"
 #include "net/mac/tsch/tsch-adaptive-timesync.h"
 #include "net/mac/tsch/tsch-log.h"
+#include "net/mac/tsch/tsch-slot-stats.h"
 #include <stdio.h>
 
 #if TSCH_ADAPTIVE_TIMESYNC
@@ -98,16 +99,18 @@ timesync_learn_drift_ticks(uint32_t time_delta_asn, int32_t drift_ticks)
   int32_t last_drift_ppm = (int32_t)((int64_t)real_drift_ticks * TSCH_DRIFT_UNIT / time_delta_ticks);
 
   drift_ppm = timesync_entry_add(last_drift_ppm, time_delta_ticks);
+  TSCH_SLOT_STATS_DRIFT_PPM(drift_ppm / 256);
 
   TSCH_LOG_ADD(tsch_log_message,
       snprintf(log->message, sizeof(log->message),
-          "drift %ld", drift_ppm / 256));
+          "drift %ld", (long)(drift_ppm / 256)));
 }
 /*---------------------------------------------------------------------------*/
 /* Either reset or update the neighbor's drift */
 void
 tsch_timesync_update(struct tsch_neighbor *n, uint16_t time_delta_asn, int32_t drift_correction)
 {
+  TSCH_SLOT_STATS_DRIFT_TICKS(drift_correction);
   /* Account the drift if either this is a new timesource,
    * or the timedelta is not too small, as smaller timedelta
    * means proportionally larger measurement error. */
@@ -147,7 +150,7 @@ compensate_internal(uint32_t time_delta_usec, int32_t drift_ppm, int32_t *remain
   if(ABS(amount_ticks) > RTIMER_ARCH_SECOND / 128) {
     TSCH_LOG_ADD(tsch_log_message,
         snprintf(log->message, sizeof(log->message),
-            "!too big compensation %ld delta %ld", amount_ticks, time_delta_usec));
+            "!too big comp %ld delta %ld", (long)amount_ticks, (long)time_delta_usec));
     amount_ticks = (amount_ticks > 0 ? RTIMER_ARCH_SECOND : -RTIMER_ARCH_SECOND) / 128;
   }
 
@@ -185,6 +188,7 @@ tsch_timesync_adaptive_compensate(rtimer_clock_t time_delta_ticks)
 void
 tsch_timesync_update(struct tsch_neighbor *n, uint16_t time_delta_asn, int32_t drift_correction)
 {
+  TSCH_SLOT_STATS_DRIFT_TICKS(drift_correction);
 }
 /*---------------------------------------------------------------------------*/
 int32_t
@@ -198,4 +198,14 @@
 #define TSCH_CHANNEL_SCAN_DURATION CLOCK_SECOND
 #endif
 
+/* Max number of frames sent back-to-back to a neighbor. When there are
+ * more frames queued for it, the sender sets the frame pending bit and both
+ * nodes repeat the link in the very next timeslot, taking precedence over
+ * whatever the schedule has there. 0 disables bursts. */
+#ifdef TSCH_CONF_BURST_MAX_LEN
+#define TSCH_BURST_MAX_LEN TSCH_CONF_BURST_MAX_LEN
+#else
+#define TSCH_BURST_MAX_LEN 0
+#endif
+
 #endif /* __TSCH_CONF_H__ */
@@ -247,6 +247,9 @@ tsch_queue_add_packet(const linkaddr_t *addr, mac_callback_t sent, void *ptr)
 #endif
           p->qb = queuebuf_new_from_packetbuf();
           if(p->qb != NULL) {
+            /* The slot operation writes to the frame in place (frame
+               pending bit, EB sync IE, MIC), so it must not be shared */
+            queuebuf_unshare(p->qb);
             p->sent = sent;
             p->ptr = ptr;
             p->ret = MAC_TX_DEFERRED;
@@ -68,6 +68,62 @@ MEMB(link_memb, struct tsch_link, TSCH_SCHEDULE_MAX_LINKS);
 MEMB(slotframe_memb, struct tsch_slotframe, TSCH_SCHEDULE_MAX_SLOTFRAMES);
 /* List of slotframes (each slotframe holds its own list of links) */
 LIST(slotframe_list);
+/* Schedule index: all links, grouped by slotframe and sorted by timeslot
+ * within each slotframe. Rebuilt whenever links are added or removed, so
+ * that the next link of a slotframe is found with a binary search */
+static struct tsch_link *link_index[TSCH_SCHEDULE_MAX_LINKS];
+
+/*---------------------------------------------------------------------------*/
+/* Rebuilds the schedule index. Call with the TSCH lock held */
+static void
+schedule_index_rebuild(void)
+{
+  uint16_t pos = 0;
+  struct tsch_slotframe *sf = list_head(slotframe_list);
+  while(sf != NULL) {
+    struct tsch_link *l = list_head(sf->links_list);
+    sf->index_start = pos;
+    while(l != NULL) {
+      /* Insertion sort by timeslot */
+      uint16_t i = pos;
+      while(i > sf->index_start && link_index[i - 1]->timeslot > l->timeslot) {
+        link_index[i] = link_index[i - 1];
+        i--;
+      }
+      link_index[i] = l;
+      pos++;
+      l = list_item_next(l);
+    }
+    sf->index_len = pos - sf->index_start;
+    sf = list_item_next(sf);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the first link of a slotframe strictly after a timeslot, wrapping
+ * around to the slotframe's first link (NULL if the slotframe is empty) */
+static struct tsch_link *
+next_link_in_slotframe(const struct tsch_slotframe *sf, uint16_t timeslot)
+{
+  uint16_t low = sf->index_start;
+  uint16_t high = sf->index_start + sf->index_len;
+
+  if(sf->index_len == 0) {
+    return NULL;
+  }
+  while(low < high) {
+    uint16_t mid = low + (high - low) / 2;
+    if(link_index[mid]->timeslot > timeslot) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+  if(low == sf->index_start + sf->index_len) {
+    low = sf->index_start;
+  }
+  return link_index[low];
+}
+/*---------------------------------------------------------------------------*/
 
 /* Adds and returns a slotframe (NULL if failure) */
 struct tsch_slotframe *
@@ -89,6 +145,8 @@ tsch_schedule_add_slotframe(uint16_t handle, uint16_t size)
       sf->handle = handle;
       TSCH_ASN_DIVISOR_INIT(sf->size, size);
       LIST_STRUCT_INIT(sf, links_list);
+      sf->index_start = 0;
+      sf->index_len = 0;
       /* Add the slotframe to the global list */
       list_add(slotframe_list, sf);
     }
@@ -129,6 +187,7 @@ tsch_schedule_remove_slotframe(struct tsch_slotframe *slotframe)
       PRINTF("TSCH-schedule: remove slotframe %u %u\n", slotframe->handle, slotframe->size.val);
       memb_free(&slotframe_memb, slotframe);
       list_remove(slotframe_list, slotframe);
+      schedule_index_rebuild();
       tsch_release_lock();
       return 1;
     }
@@ -209,6 +268,7 @@ tsch_schedule_add_link(struct tsch_slotframe *slotframe,
           address = &linkaddr_null;
         }
         linkaddr_copy(&l->addr, address);
+        schedule_index_rebuild();
 
         PRINTF("TSCH-schedule: add_link %u %u %u %u %u %u\n",
                slotframe->handle, link_options, link_type, timeslot, channel_offset, TSCH_LOG_ID_FROM_LINKADDR(address));
@@ -257,6 +317,7 @@ tsch_schedule_remove_link(struct tsch_slotframe *slotframe, struct tsch_link *l)
 
       list_remove(slotframe->links_list, l);
       memb_free(&link_memb, l);
+      schedule_index_rebuild();
 
       /* Release the lock before we update the neighbor (will take the lock) */
       tsch_release_lock();
@@ -325,8 +386,10 @@ tsch_schedule_get_next_active_link(struct tsch_asn_t *asn, uint16_t *time_offset
     while(sf != NULL) {
       /* Get timeslot from ASN, given the slotframe length */
       uint16_t timeslot = TSCH_ASN_MOD(*asn, sf->size);
-      struct tsch_link *l = list_head(sf->links_list);
-      while(l != NULL) {
+      /* There is at most one link per timeslot in a slotframe, so only the
+       * slotframe's next link can be the earliest one */
+      struct tsch_link *l = next_link_in_slotframe(sf, timeslot);
+      if(l != NULL) {
         uint16_t time_to_timeslot =
           l->timeslot > timeslot ?
           l->timeslot - timeslot :
@@ -368,8 +431,6 @@ tsch_schedule_get_next_active_link(struct tsch_asn_t *asn, uint16_t *time_offset
             curr_best = new_best;
           }
         }
-
-        l = list_item_next(l);
       }
       sf = list_item_next(sf);
     }
@@ -122,6 +122,10 @@ struct tsch_slotframe {
   struct tsch_asn_divisor_t size;
   /* List of links belonging to this slotframe */
   LIST_STRUCT(links_list);
+  /* Range of the schedule index holding this slotframe's links
+   * sorted by timeslot (see tsch-schedule.c) */
+  uint16_t index_start;
+  uint16_t index_len;
 };
 
 /********** Functions *********/
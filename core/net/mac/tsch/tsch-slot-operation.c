@@ -54,6 +54,7 @@
 #include "net/mac/tsch/tsch-packet.h"
 #include "net/mac/tsch/tsch-security.h"
 #include "net/mac/tsch/tsch-adaptive-timesync.h"
+#include "net/mac/tsch/tsch-slot-stats.h"
 #if CONTIKI_TARGET_COOJA || CONTIKI_TARGET_COOJA_IP64
 #include "lib/simEnvChange.h"
 #include "sys/cooja_mt.h"
@@ -133,6 +134,7 @@ enum tsch_radio_state_off_cmd {
  * Will be processed layer by tsch_tx_process_pending */
 struct ringbufindex dequeued_ringbuf;
 struct tsch_packet *dequeued_array[TSCH_DEQUEUED_ARRAY_SIZE];
+struct tsch_asn_t dequeued_asn[TSCH_DEQUEUED_ARRAY_SIZE];
 /* A ringbuf storing incoming packets.
  * Will be processed layer by tsch_rx_process_pending */
 struct ringbufindex input_ringbuf;
@@ -174,6 +176,18 @@ static struct tsch_link *backup_link = NULL;
 static struct tsch_packet *current_packet = NULL;
 static struct tsch_neighbor *current_neighbor = NULL;
 
+#if TSCH_BURST_MAX_LEN > 0
+/* Set when the frame of the current slot had the frame pending bit and was
+ * acknowledged: the current link is then repeated in the next timeslot */
+static uint8_t burst_link_scheduled = 0;
+/* Are we the sender of the ongoing burst? */
+static uint8_t burst_link_tx;
+/* The neighbor at the other end of the ongoing burst */
+static linkaddr_t burst_addr;
+/* Number of slots the ongoing burst has used so far, 0 if none */
+static uint8_t burst_count = 0;
+#endif /* TSCH_BURST_MAX_LEN > 0 */
+
 /* Protothread for association */
 PT_THREAD(tsch_scan(struct pt *pt));
 /* Protothread for slot operation, called from rtimer interrupt
@@ -297,10 +311,12 @@ tsch_schedule_slot_operation(struct rtimer *tm, rtimer_clock_t ref_time, rtimer_
                     "!dl-miss %s %d %d",
                         str, (int)(now-ref_time), (int)offset);
     );
+    TSCH_SLOT_STATS_DEADLINE(str, 1, 0);
 
     return 0;
   }
   ref_time += offset;
+  TSCH_SLOT_STATS_DEADLINE(str, 0, ref_time - now);
   r = rtimer_set(tm, ref_time, 1, (void (*)(struct rtimer *, void *))tsch_slot_operation, NULL);
   if(r != RTIMER_OK) {
     return 0;
@@ -480,6 +496,10 @@ PT_THREAD(tsch_tx_slot(struct pt *pt, struct rtimer *t))
   uint8_t in_queue;
   static int dequeued_index;
   static int packet_ready = 1;
+#if TSCH_BURST_MAX_LEN > 0
+  /* did we set the frame pending bit? */
+  static uint8_t burst_link_requested;
+#endif /* TSCH_BURST_MAX_LEN > 0 */
 
   PT_BEGIN(pt);
 
@@ -524,6 +544,20 @@ PT_THREAD(tsch_tx_slot(struct pt *pt, struct rtimer *t))
         packet_ready = 1;
       }
 
+#if TSCH_BURST_MAX_LEN > 0
+      /* Ask the receiver to stay for the next frame if there is one, and the
+       * burst has room for it. The bit is set (or cleared) before securing
+       * the frame, as it is covered by the MIC. */
+      burst_link_requested = !is_broadcast
+        && burst_count + 1 < TSCH_BURST_MAX_LEN
+        && tsch_queue_packet_count(&current_neighbor->addr) > 1;
+      if(burst_link_requested) {
+        ((uint8_t *)packet)[0] |= 1 << 4;
+      } else {
+        ((uint8_t *)packet)[0] &= ~(1 << 4);
+      }
+#endif /* TSCH_BURST_MAX_LEN > 0 */
+
 #if LLSEC802154_ENABLED
       if(tsch_is_pan_secured) {
         /* If we are going to encrypt, we need to generate the output in a separate buffer and keep
@@ -680,6 +714,15 @@ PT_THREAD(tsch_tx_slot(struct pt *pt, struct rtimer *t))
 
     tsch_radio_off(TSCH_RADIO_CMD_OFF_END_OF_TIMESLOT);
 
+#if TSCH_BURST_MAX_LEN > 0
+    if(mac_tx_status == MAC_TX_OK && burst_link_requested) {
+      /* The receiver saw the frame pending bit: send the next frame in the next slot */
+      burst_link_scheduled = 1;
+      burst_link_tx = 1;
+      linkaddr_copy(&burst_addr, &current_neighbor->addr);
+    }
+#endif /* TSCH_BURST_MAX_LEN > 0 */
+
     current_packet->transmissions++;
     current_packet->ret = mac_tx_status;
 
@@ -689,6 +732,7 @@ PT_THREAD(tsch_tx_slot(struct pt *pt, struct rtimer *t))
     /* The packet was dequeued, add it to dequeued_ringbuf for later processing */
     if(in_queue == 0) {
       dequeued_array[dequeued_index] = current_packet;
+      dequeued_asn[dequeued_index] = tsch_current_asn;
       ringbufindex_put(&dequeued_ringbuf);
     }
 
@@ -786,6 +830,7 @@ PT_THREAD(tsch_rx_slot(struct pt *pt, struct rtimer *t))
 
       if(NETSTACK_RADIO.pending_packet()) {
         static int frame_valid;
+        static int frame_filtered;
         static int header_len;
         static frame802154_t frame;
         radio_value_t radio_last_rssi;
@@ -796,10 +841,17 @@ PT_THREAD(tsch_rx_slot(struct pt *pt, struct rtimer *t))
         current_input->rx_asn = tsch_current_asn;
         current_input->rssi = (signed)radio_last_rssi;
         current_input->channel = current_channel;
-        header_len = frame802154_parse((uint8_t *)current_input->payload, current_input->len, &frame);
-        frame_valid = header_len > 0 &&
-          frame802154_check_dest_panid(&frame) &&
-          frame802154_extract_linkaddr(&frame, &source_address, &destination_address);
+        /* Frames for another PAN or another node are dropped before they
+         * are parsed and authenticated */
+        frame_filtered = !frame802154_prefilter((uint8_t *)current_input->payload,
+            current_input->len, &linkaddr_node_addr);
+        frame_valid = 0;
+        if(!frame_filtered) {
+          header_len = frame802154_parse((uint8_t *)current_input->payload, current_input->len, &frame);
+          frame_valid = header_len > 0 &&
+            frame802154_check_dest_panid(&frame) &&
+            frame802154_extract_linkaddr(&frame, &source_address, &destination_address);
+        }
 
 #if TSCH_RESYNC_WITH_SFD_TIMESTAMPS
         /* At the end of the reception, get an more accurate estimate of SFD arrival time */
@@ -821,11 +873,12 @@ PT_THREAD(tsch_rx_slot(struct pt *pt, struct rtimer *t))
                 "!failed to authenticate frame %u", current_input->len));
             frame_valid = 0;
           }
-        } else {
+        } else if(!frame_filtered) {
+          /* Frames dropped by the prefilter were not meant for us and
+             are not worth a log entry */
           TSCH_LOG_ADD(tsch_log_message,
               snprintf(log->message, sizeof(log->message),
               "!failed to parse frame %u %u", header_len, current_input->len));
-          frame_valid = 0;
         }
 #endif /* LLSEC802154_ENABLED */
 
@@ -878,6 +931,16 @@ PT_THREAD(tsch_rx_slot(struct pt *pt, struct rtimer *t))
                 TSCH_DEBUG_RX_EVENT();
                 NETSTACK_RADIO.transmit(ack_len);
                 tsch_radio_off(TSCH_RADIO_CMD_OFF_WITHIN_TIMESLOT);
+
+#if TSCH_BURST_MAX_LEN > 0
+                if(frame.fcf.frame_pending && !do_nack
+                   && burst_count + 1 < TSCH_BURST_MAX_LEN) {
+                  /* The sender has more for us: listen in the next slot */
+                  burst_link_scheduled = 1;
+                  burst_link_tx = 0;
+                  linkaddr_copy(&burst_addr, &source_address);
+                }
+#endif /* TSCH_BURST_MAX_LEN > 0 */
               }
             }
 
@@ -937,6 +1000,10 @@ PT_THREAD(tsch_rx_slot(struct pt *pt, struct rtimer *t))
 static
 PT_THREAD(tsch_slot_operation(struct rtimer *t, void *ptr))
 {
+#if TSCH_SLOT_STATS
+  /* Start of the phase being measured; static as it spans yields */
+  static rtimer_clock_t phase_start;
+#endif /* TSCH_SLOT_STATS */
   TSCH_DEBUG_INTERRUPT();
   PT_BEGIN(&slot_operation_pt);
 
@@ -957,19 +1024,38 @@ PT_THREAD(tsch_slot_operation(struct rtimer *t, void *ptr))
     } else {
       int is_active_slot;
       TSCH_DEBUG_SLOT_START();
+      TSCH_SLOT_STATS_PHASE(tsch_slot_phase_wakeup, current_slot_start);
       tsch_in_slot_operation = 1;
       /* Reset drift correction */
       drift_correction = 0;
       is_drift_correction_used = 0;
-      /* Get a packet ready to be sent */
-      current_packet = get_packet_and_neighbor_for_link(current_link, &current_neighbor);
-      /* There is no packet to send, and this link does not have Rx flag. Instead of doing
-       * nothing, switch to the backup link (has Rx flag) if any. */
-      if(current_packet == NULL && !(current_link->link_options & LINK_OPTION_RX) && backup_link != NULL) {
-        current_link = backup_link;
+#if TSCH_BURST_MAX_LEN > 0
+      burst_link_scheduled = 0;
+      if(burst_count > 0) {
+        /* A burst slot: only the two nodes of the burst take part, each in
+         * the same role as in the previous slot */
+        current_packet = NULL;
+        current_neighbor = NULL;
+        if(burst_link_tx) {
+          current_neighbor = tsch_queue_get_nbr(&burst_addr);
+          if(current_neighbor != NULL) {
+            current_packet = tsch_queue_get_packet_for_nbr(current_neighbor, current_link);
+          }
+        }
+        is_active_slot = current_packet != NULL || !burst_link_tx;
+      } else
+#endif /* TSCH_BURST_MAX_LEN > 0 */
+      {
+        /* Get a packet ready to be sent */
         current_packet = get_packet_and_neighbor_for_link(current_link, &current_neighbor);
+        /* There is no packet to send, and this link does not have Rx flag. Instead of doing
+         * nothing, switch to the backup link (has Rx flag) if any. */
+        if(current_packet == NULL && !(current_link->link_options & LINK_OPTION_RX) && backup_link != NULL) {
+          current_link = backup_link;
+          current_packet = get_packet_and_neighbor_for_link(current_link, &current_neighbor);
+        }
+        is_active_slot = current_packet != NULL || (current_link->link_options & LINK_OPTION_RX);
       }
-      is_active_slot = current_packet != NULL || (current_link->link_options & LINK_OPTION_RX);
       if(is_active_slot) {
         /* Hop channel */
         current_channel = tsch_calculate_channel(&tsch_current_asn, current_link->channel_offset);
@@ -985,12 +1071,21 @@ PT_THREAD(tsch_slot_operation(struct rtimer *t, void *ptr))
            * 3. post tx callback
            **/
           static struct pt slot_tx_pt;
+#if TSCH_SLOT_STATS
+          phase_start = RTIMER_NOW();
+#endif /* TSCH_SLOT_STATS */
           PT_SPAWN(&slot_operation_pt, &slot_tx_pt, tsch_tx_slot(&slot_tx_pt, t));
+          TSCH_SLOT_STATS_PHASE(tsch_slot_phase_tx, phase_start);
         } else {
           /* Listen */
           static struct pt slot_rx_pt;
+#if TSCH_SLOT_STATS
+          phase_start = RTIMER_NOW();
+#endif /* TSCH_SLOT_STATS */
           PT_SPAWN(&slot_operation_pt, &slot_rx_pt, tsch_rx_slot(&slot_rx_pt, t));
+          TSCH_SLOT_STATS_PHASE(tsch_slot_phase_rx, phase_start);
         }
+        TSCH_SLOT_STATS_USAGE(current_slot_start, tsch_timing[tsch_ts_timeslot_length]);
       }
       TSCH_DEBUG_SLOT_END();
     }
@@ -1014,6 +1109,9 @@ PT_THREAD(tsch_slot_operation(struct rtimer *t, void *ptr))
       rtimer_clock_t prev_slot_start;
       /* Time to next wake up */
       rtimer_clock_t time_to_next_active_slot;
+#if TSCH_SLOT_STATS
+      phase_start = RTIMER_NOW();
+#endif /* TSCH_SLOT_STATS */
       /* Schedule next wakeup skipping slots if missed deadline */
       do {
         if(current_link != NULL
@@ -1024,12 +1122,28 @@ PT_THREAD(tsch_slot_operation(struct rtimer *t, void *ptr))
           tsch_queue_update_all_backoff_windows(&current_link->addr);
         }
 
-        /* Get next active link */
-        current_link = tsch_schedule_get_next_active_link(&tsch_current_asn, &timeslot_diff, &backup_link);
-        if(current_link == NULL) {
-          /* There is no next link. Fall back to default
-           * behavior: wake up at the next slot. */
+#if TSCH_BURST_MAX_LEN > 0
+        if(burst_link_scheduled && current_link != NULL) {
+          /* Repeat the current link in the next timeslot */
           timeslot_diff = 1;
+          backup_link = NULL;
+          burst_count++;
+          /* Fall back to the schedule if this slot is missed */
+          burst_link_scheduled = 0;
+        } else
+#endif /* TSCH_BURST_MAX_LEN > 0 */
+        {
+          /* Get next active link */
+          current_link = tsch_schedule_get_next_active_link(&tsch_current_asn, &timeslot_diff, &backup_link);
+          if(current_link == NULL) {
+            /* There is no next link. Fall back to default
+             * behavior: wake up at the next slot. */
+            timeslot_diff = 1;
+          }
+#if TSCH_BURST_MAX_LEN > 0
+          burst_link_scheduled = 0;
+          burst_count = 0;
+#endif /* TSCH_BURST_MAX_LEN > 0 */
         }
         /* Update ASN */
         TSCH_ASN_INC(tsch_current_asn, timeslot_diff);
@@ -1042,6 +1156,7 @@ PT_THREAD(tsch_slot_operation(struct rtimer *t, void *ptr))
         current_slot_start += time_to_next_active_slot;
         current_slot_start += tsch_timesync_adaptive_compensate(time_to_next_active_slot);
       } while(!tsch_schedule_slot_operation(t, prev_slot_start, time_to_next_active_slot, "main"));
+      TSCH_SLOT_STATS_PHASE(tsch_slot_phase_schedule, phase_start);
     }
 
     tsch_in_slot_operation = 0;
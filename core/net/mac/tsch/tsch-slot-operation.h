@@ -99,6 +99,8 @@ struct input_packet {
  * Will be processed layer by tsch_tx_process_pending */
 extern struct ringbufindex dequeued_ringbuf;
 extern struct tsch_packet *dequeued_array[TSCH_DEQUEUED_ARRAY_SIZE];
+/* ASN of the slot in which each dequeued packet was last transmitted */
+extern struct tsch_asn_t dequeued_asn[TSCH_DEQUEUED_ARRAY_SIZE];
 /* A ringbuf storing incoming packets.
  * Will be processed layer by tsch_rx_process_pending */
 extern struct ringbufindex input_ringbuf;
@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         TSCH slot timing statistics: per-phase durations, slot usage,
+ *         deadline misses and time synchronization drift, recorded from
+ *         the slot operation interrupt for later dump.
+ */
+
+#include "contiki.h"
+#include "net/mac/tsch/tsch-slot-stats.h"
+#include <stdio.h>
+#include <string.h>
+
+#if TSCH_SLOT_STATS
+
+struct tsch_slot_stats tsch_slot_stats;
+
+static const char *phase_names[tsch_slot_phase_count] = {
+  "wakeup", "tx", "rx", "schedule"
+};
+
+/*---------------------------------------------------------------------------*/
+/* Time elapsed since start; zero if start is still ahead, as a slot
+ * start that includes drift compensation may be */
+static rtimer_clock_t
+elapsed_since(rtimer_clock_t start)
+{
+  rtimer_clock_t now = RTIMER_NOW();
+
+  return RTIMER_CLOCK_LT(now, start) ? 0 : now - start;
+}
+/*---------------------------------------------------------------------------*/
+void
+tsch_slot_stats_phase(enum tsch_slot_phase phase, rtimer_clock_t start)
+{
+  struct tsch_slot_phase_stats *s = &tsch_slot_stats.phases[phase];
+  rtimer_clock_t duration = elapsed_since(start);
+
+  s->count++;
+  s->total += duration;
+  if(duration > s->max) {
+    s->max = duration;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+tsch_slot_stats_usage(rtimer_clock_t slot_start, rtimer_clock_t slot_length)
+{
+  rtimer_clock_t used = elapsed_since(slot_start);
+  int bucket = TSCH_SLOT_STATS_USAGE_BUCKETS;
+
+  if(used < slot_length) {
+    bucket = (uint32_t)used * TSCH_SLOT_STATS_USAGE_BUCKETS / slot_length;
+  }
+  tsch_slot_stats.usage[bucket]++;
+}
+/*---------------------------------------------------------------------------*/
+void
+tsch_slot_stats_deadline(const char *label, int missed, rtimer_clock_t slack)
+{
+  struct tsch_slot_deadline_stats *d;
+  int i;
+
+  for(i = 0; i < TSCH_SLOT_STATS_MAX_DEADLINES; i++) {
+    d = &tsch_slot_stats.deadlines[i];
+    if(d->label == NULL) {
+      d->label = label;
+      d->min_slack = (rtimer_clock_t)~0;
+    }
+    if(d->label == label) {
+      d->scheduled++;
+      if(missed) {
+        d->missed++;
+      } else if(slack < d->min_slack) {
+        d->min_slack = slack;
+      }
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Zero has the middle bucket; magnitudes are log2-bucketed on each side */
+static int
+drift_bucket(int32_t value)
+{
+  uint32_t magnitude;
+  int b = 0;
+
+  if(value == 0) {
+    return TSCH_SLOT_STATS_DRIFT_LOG2_BUCKETS;
+  }
+  magnitude = value < 0 ? -(uint32_t)value : (uint32_t)value;
+  while(magnitude > 1 && b < TSCH_SLOT_STATS_DRIFT_LOG2_BUCKETS - 1) {
+    magnitude >>= 1;
+    b++;
+  }
+  if(value < 0) {
+    return TSCH_SLOT_STATS_DRIFT_LOG2_BUCKETS - 1 - b;
+  }
+  return TSCH_SLOT_STATS_DRIFT_LOG2_BUCKETS + 1 + b;
+}
+/*---------------------------------------------------------------------------*/
+void
+tsch_slot_stats_drift_ticks(int32_t ticks)
+{
+  tsch_slot_stats.drift_ticks[drift_bucket(ticks)]++;
+}
+/*---------------------------------------------------------------------------*/
+void
+tsch_slot_stats_drift_ppm(int32_t ppm)
+{
+  tsch_slot_stats.drift_ppm[drift_bucket(ppm)]++;
+}
+/*---------------------------------------------------------------------------*/
+void
+tsch_slot_stats_reset(void)
+{
+  memset(&tsch_slot_stats, 0, sizeof(tsch_slot_stats));
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_drift(const char *name, const uint32_t *buckets)
+{
+  int i;
+
+  printf("TSCH stats: %s", name);
+  for(i = 0; i < TSCH_SLOT_STATS_DRIFT_BUCKETS; i++) {
+    printf(" %lu", (unsigned long)buckets[i]);
+  }
+  printf("\n");
+}
+/*---------------------------------------------------------------------------*/
+void
+tsch_slot_stats_print(void)
+{
+  int i;
+
+  for(i = 0; i < tsch_slot_phase_count; i++) {
+    struct tsch_slot_phase_stats *s = &tsch_slot_stats.phases[i];
+    printf("TSCH stats: phase %s count %lu avg %lu max %lu ticks\n",
+           phase_names[i], (unsigned long)s->count,
+           (unsigned long)(s->count ? s->total / s->count : 0),
+           (unsigned long)s->max);
+  }
+  printf("TSCH stats: usage");
+  for(i = 0; i <= TSCH_SLOT_STATS_USAGE_BUCKETS; i++) {
+    printf(" %lu", (unsigned long)tsch_slot_stats.usage[i]);
+  }
+  printf("\n");
+  for(i = 0; i < TSCH_SLOT_STATS_MAX_DEADLINES; i++) {
+    struct tsch_slot_deadline_stats *d = &tsch_slot_stats.deadlines[i];
+    if(d->label != NULL) {
+      printf("TSCH stats: deadline %s scheduled %lu missed %lu min slack %lu ticks\n",
+             d->label, (unsigned long)d->scheduled, (unsigned long)d->missed,
+             (unsigned long)d->min_slack);
+    }
+  }
+  print_drift("drift ticks", tsch_slot_stats.drift_ticks);
+  print_drift("drift ppm", tsch_slot_stats.drift_ppm);
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+put_u8(uint8_t *p, const uint8_t *end, uint8_t v)
+{
+  if(p == NULL || p + 1 > end) {
+    return NULL;
+  }
+  *p++ = v;
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+put_u32(uint8_t *p, const uint8_t *end, uint32_t v)
+{
+  int i;
+
+  if(p == NULL || p + 4 > end) {
+    return NULL;
+  }
+  for(i = 0; i < 4; i++) {
+    *p++ = v >> (8 * i);
+  }
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+put_u32_array(uint8_t *p, const uint8_t *end, const uint32_t *v, int n)
+{
+  int i;
+
+  for(i = 0; i < n; i++) {
+    p = put_u32(p, end, v[i]);
+  }
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+int
+tsch_slot_stats_dump(uint8_t *buf, int len)
+{
+  const uint8_t *end = buf + len;
+  uint8_t *p = buf;
+  uint8_t num_deadlines = 0;
+  int i;
+
+  while(num_deadlines < TSCH_SLOT_STATS_MAX_DEADLINES &&
+        tsch_slot_stats.deadlines[num_deadlines].label != NULL) {
+    num_deadlines++;
+  }
+
+  p = put_u8(p, end, TSCH_SLOT_STATS_DUMP_VERSION);
+  p = put_u8(p, end, sizeof(rtimer_clock_t));
+  p = put_u32(p, end, RTIMER_SECOND);
+  p = put_u8(p, end, tsch_slot_phase_count);
+  p = put_u8(p, end, TSCH_SLOT_STATS_USAGE_BUCKETS + 1);
+  p = put_u8(p, end, num_deadlines);
+  p = put_u8(p, end, TSCH_SLOT_STATS_DRIFT_BUCKETS);
+
+  for(i = 0; i < tsch_slot_phase_count; i++) {
+    p = put_u32(p, end, tsch_slot_stats.phases[i].count);
+    p = put_u32(p, end, tsch_slot_stats.phases[i].total);
+    p = put_u32(p, end, tsch_slot_stats.phases[i].max);
+  }
+  p = put_u32_array(p, end, tsch_slot_stats.usage,
+                    TSCH_SLOT_STATS_USAGE_BUCKETS + 1);
+  for(i = 0; i < num_deadlines; i++) {
+    const struct tsch_slot_deadline_stats *d = &tsch_slot_stats.deadlines[i];
+    uint8_t label_len = strlen(d->label);
+    p = put_u8(p, end, label_len);
+    if(p != NULL && p + label_len <= end) {
+      memcpy(p, d->label, label_len);
+      p += label_len;
+    } else {
+      p = NULL;
+    }
+    p = put_u32(p, end, d->scheduled);
+    p = put_u32(p, end, d->missed);
+    p = put_u32(p, end, d->min_slack);
+  }
+  p = put_u32_array(p, end, tsch_slot_stats.drift_ticks,
+                    TSCH_SLOT_STATS_DRIFT_BUCKETS);
+  p = put_u32_array(p, end, tsch_slot_stats.drift_ppm,
+                    TSCH_SLOT_STATS_DRIFT_BUCKETS);
+
+  return p == NULL ? 0 : p - buf;
+}
+/*---------------------------------------------------------------------------*/
+#endif /* TSCH_SLOT_STATS */
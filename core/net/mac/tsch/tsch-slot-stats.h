@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         TSCH slot timing statistics: per-phase durations, slot usage,
+ *         deadline misses and time synchronization drift, recorded from
+ *         the slot operation interrupt for later dump.
+ */
+
+#ifndef __TSCH_SLOT_STATS_H__
+#define __TSCH_SLOT_STATS_H__
+
+/********** Includes **********/
+
+#include "contiki.h"
+#include "sys/rtimer.h"
+
+/******** Configuration *******/
+
+/* Enable slot timing statistics */
+#ifdef TSCH_CONF_SLOT_STATS
+#define TSCH_SLOT_STATS TSCH_CONF_SLOT_STATS
+#else /* TSCH_CONF_SLOT_STATS */
+#define TSCH_SLOT_STATS 0
+#endif /* TSCH_CONF_SLOT_STATS */
+
+/* The maximum number of distinct deadlines tracked (one per call site
+ * of tsch_schedule_slot_operation, identified by its label) */
+#ifdef TSCH_SLOT_STATS_CONF_MAX_DEADLINES
+#define TSCH_SLOT_STATS_MAX_DEADLINES TSCH_SLOT_STATS_CONF_MAX_DEADLINES
+#else /* TSCH_SLOT_STATS_CONF_MAX_DEADLINES */
+#define TSCH_SLOT_STATS_MAX_DEADLINES 8
+#endif /* TSCH_SLOT_STATS_CONF_MAX_DEADLINES */
+
+/* Slot usage is histogrammed in this many buckets, each covering an
+ * equal share of the timeslot length; one more bucket counts overruns */
+#define TSCH_SLOT_STATS_USAGE_BUCKETS 8
+
+/* Drift histograms have a bucket for zero and, for each sign, buckets
+ * for magnitudes 1, 2-3, 4-7, ... up to 2^(N-1) and above */
+#define TSCH_SLOT_STATS_DRIFT_LOG2_BUCKETS 7
+#define TSCH_SLOT_STATS_DRIFT_BUCKETS (2 * TSCH_SLOT_STATS_DRIFT_LOG2_BUCKETS + 1)
+
+/* Version of the binary dump format */
+#define TSCH_SLOT_STATS_DUMP_VERSION 1
+
+/************ Types ***********/
+
+/* Phases of a slot whose duration is measured */
+enum tsch_slot_phase {
+  tsch_slot_phase_wakeup,   /* From slot start to the slot operation running */
+  tsch_slot_phase_tx,       /* Tx slot, from its start to its end */
+  tsch_slot_phase_rx,       /* Rx slot, from its start to its end */
+  tsch_slot_phase_schedule, /* Looking up and scheduling the next active slot */
+  tsch_slot_phase_count
+};
+
+struct tsch_slot_phase_stats {
+  uint32_t count;
+  uint32_t total;           /* rtimer ticks */
+  rtimer_clock_t max;       /* rtimer ticks */
+};
+
+struct tsch_slot_deadline_stats {
+  const char *label;
+  uint32_t scheduled;
+  uint32_t missed;
+  /* Smallest margin seen between scheduling and a met deadline, in ticks */
+  rtimer_clock_t min_slack;
+};
+
+struct tsch_slot_stats {
+  struct tsch_slot_phase_stats phases[tsch_slot_phase_count];
+  uint32_t usage[TSCH_SLOT_STATS_USAGE_BUCKETS + 1];
+  struct tsch_slot_deadline_stats deadlines[TSCH_SLOT_STATS_MAX_DEADLINES];
+  /* Drift corrections applied at each time synchronization, in ticks */
+  uint32_t drift_ticks[TSCH_SLOT_STATS_DRIFT_BUCKETS];
+  /* Drift learned by adaptive time synchronization, in ppm */
+  uint32_t drift_ppm[TSCH_SLOT_STATS_DRIFT_BUCKETS];
+};
+
+/********** Functions *********/
+
+#if TSCH_SLOT_STATS
+
+extern struct tsch_slot_stats tsch_slot_stats;
+
+/* Record the duration of a slot phase that began at start */
+void tsch_slot_stats_phase(enum tsch_slot_phase phase, rtimer_clock_t start);
+/* Record how much of the slot that began at slot_start was used */
+void tsch_slot_stats_usage(rtimer_clock_t slot_start, rtimer_clock_t slot_length);
+/* Record a deadline: met with a slack, or missed */
+void tsch_slot_stats_deadline(const char *label, int missed, rtimer_clock_t slack);
+/* Record a drift correction (ticks) or a learned drift (ppm) */
+void tsch_slot_stats_drift_ticks(int32_t ticks);
+void tsch_slot_stats_drift_ppm(int32_t ppm);
+
+/* Clear all statistics */
+void tsch_slot_stats_reset(void);
+/* Print statistics */
+void tsch_slot_stats_print(void);
+/* Write statistics to buf in a compact binary format. Returns the
+ * number of bytes written, or 0 if len is too small.
+ * All integers are little-endian. The format is:
+ * - u8 version, u8 rtimer_clock_t size in bytes, u32 RTIMER_SECOND,
+ *   u8 number of phases, u8 number of usage buckets (overrun bucket
+ *   included), u8 number of deadlines, u8 number of drift buckets
+ * - per phase: u32 count, u32 total ticks, u32 max ticks
+ * - per usage bucket: u32 count
+ * - per deadline: u8 label length, label, u32 scheduled, u32 missed,
+ *   u32 minimum slack
+ * - per drift bucket: u32 count of drift corrections (ticks)
+ * - per drift bucket: u32 count of learned drifts (ppm) */
+int tsch_slot_stats_dump(uint8_t *buf, int len);
+
+#define TSCH_SLOT_STATS_PHASE(phase, start) \
+  tsch_slot_stats_phase((phase), (start))
+#define TSCH_SLOT_STATS_USAGE(slot_start, slot_length) \
+  tsch_slot_stats_usage((slot_start), (slot_length))
+#define TSCH_SLOT_STATS_DEADLINE(label, missed, slack) \
+  tsch_slot_stats_deadline((label), (missed), (slack))
+#define TSCH_SLOT_STATS_DRIFT_TICKS(ticks) tsch_slot_stats_drift_ticks(ticks)
+#define TSCH_SLOT_STATS_DRIFT_PPM(ppm) tsch_slot_stats_drift_ppm(ppm)
+
+#else /* TSCH_SLOT_STATS */
+
+#define tsch_slot_stats_reset()
+#define tsch_slot_stats_print()
+#define tsch_slot_stats_dump(buf, len) 0
+
+#define TSCH_SLOT_STATS_PHASE(phase, start)
+#define TSCH_SLOT_STATS_USAGE(slot_start, slot_length)
+#define TSCH_SLOT_STATS_DEADLINE(label, missed, slack)
+#define TSCH_SLOT_STATS_DRIFT_TICKS(ticks)
+#define TSCH_SLOT_STATS_DRIFT_PPM(ppm)
+
+#endif /* TSCH_SLOT_STATS */
+
+#endif /* __TSCH_SLOT_STATS_H__ */
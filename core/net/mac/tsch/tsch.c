@@ -313,7 +313,7 @@ eb_input(struct input_packet *current_input)
       int32_t asn_diff = TSCH_ASN_DIFF(current_input->rx_asn, eb_ies.ie_asn);
       if(asn_diff != 0) {
         /* We disagree with our time source's ASN -- leave the network */
-        PRINTF("TSCH:! ASN drifted by %ld, leaving the network\n", asn_diff);
+        PRINTF("TSCH:! ASN drifted by %ld, leaving the network\n", (long)asn_diff);
         tsch_disassociate();
       }
 
@@ -352,6 +352,17 @@ tsch_rx_process_pending()
       && frame.fcf.frame_version == FRAME802154_IEEE802154E_2012
       && frame.fcf.frame_type == FRAME802154_BEACONFRAME;
 
+#ifdef TSCH_CALLBACK_LINK_ACKED
+    if(is_data && frame.fcf.ack_required) {
+      /* Only unicast frames to us were queued with ack_required set,
+         and the slot operation ACKed them */
+      linkaddr_t src, dest;
+      if(frame802154_extract_linkaddr(&frame, &src, &dest)) {
+        TSCH_CALLBACK_LINK_ACKED(&src, 0, &current_input->rx_asn);
+      }
+    }
+#endif
+
     if(is_data) {
       /* Skip EBs and other control messages */
       /* Copy to packetbuf for processing */
@@ -383,6 +394,12 @@ tsch_tx_process_pending()
     struct tsch_packet *p = dequeued_array[dequeued_index];
     /* Put packet into packetbuf for packet_sent callback */
     queuebuf_to_packetbuf(p->qb);
+#ifdef TSCH_CALLBACK_LINK_ACKED
+    if(p->ret == MAC_TX_OK && !packetbuf_holds_broadcast()) {
+      TSCH_CALLBACK_LINK_ACKED(packetbuf_addr(PACKETBUF_ADDR_RECEIVER), 1,
+                               &dequeued_asn[dequeued_index]);
+    }
+#endif
     /* Call packet_sent callback */
     mac_call_sent_callback(p->sent, p->ptr, p->ret, p->transmissions);
     /* Free packet queuebuf */
@@ -410,7 +427,7 @@ tsch_start_coordinator(void)
   tsch_join_priority = 0;
 
   PRINTF("TSCH: starting as coordinator, PAN ID %x, asn-%x.%lx\n",
-      frame802154_get_pan_id(), tsch_current_asn.ms1b, tsch_current_asn.ls4b);
+      frame802154_get_pan_id(), tsch_current_asn.ms1b, (unsigned long)tsch_current_asn.ls4b);
 
   /* Start slot operation */
   tsch_slot_operation_sync(RTIMER_NOW(), &tsch_current_asn);
@@ -512,7 +529,7 @@ tsch_associate(const struct input_packet *input_eb, rtimer_clock_t timestamp)
   int32_t asn_diff = (int32_t)tsch_current_asn.ls4b - expected_asn;
   if(asn_diff > asn_threshold) {
     PRINTF("TSCH:! EB ASN rejected %lx %lx %ld\n",
-           tsch_current_asn.ls4b, expected_asn, asn_diff);
+           (unsigned long)tsch_current_asn.ls4b, (unsigned long)expected_asn, (long)asn_diff);
     return 0;
   }
 #endif
@@ -578,7 +595,7 @@ tsch_associate(const struct input_packet *input_eb, rtimer_clock_t timestamp)
       PRINTF("TSCH: association done, sec %u, PAN ID %x, asn-%x.%lx, jp %u, timeslot id %u, hopping id %u, slotframe len %u with %u links, from ",
              tsch_is_pan_secured,
              frame.src_pid,
-             tsch_current_asn.ms1b, tsch_current_asn.ls4b, tsch_join_priority,
+             tsch_current_asn.ms1b, (unsigned long)tsch_current_asn.ls4b, tsch_join_priority,
              ies.ie_tsch_timeslot_id,
              ies.ie_channel_hopping_sequence_id,
              ies.ie_tsch_slotframe_and_link.slotframe_size,
@@ -37,6 +37,7 @@
 
 #include "contiki.h"
 #include "net/mac/mac.h"
+#include "net/mac/tsch/tsch-asn.h"
 #include "net/mac/tsch/tsch-security.h"
 
 /******** Configuration *******/
@@ -157,6 +158,15 @@ void TSCH_CALLBACK_JOINING_NETWORK();
 void TSCH_CALLBACK_LEAVING_NETWORK();
 #endif
 
+/* Called by TSCH for every acknowledged unicast frame: frames we sent
+ * that got an ACK (is_tx set, addr is the receiver), and frames we
+ * received and ACKed, duplicates included (addr is the sender). asn is
+ * the ASN of the slot the ACK was exchanged in. Runs in process
+ * context, shortly after that slot. */
+#ifdef TSCH_CALLBACK_LINK_ACKED
+void TSCH_CALLBACK_LINK_ACKED(const linkaddr_t *addr, int is_tx, const struct tsch_asn_t *asn);
+#endif
+
 /***** External Variables *****/
 
 /* Are we coordinator of the TSCH network? */
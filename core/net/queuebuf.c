@@ -67,19 +67,49 @@ struct queuebuf {
 #if WITH_SWAP
     int swap_id;
   };
-#endif
+#else /* WITH_SWAP */
+  /* Without swapping, the frame is reference counted and may be
+     shared between queuebufs, while attributes are per queuebuf */
+  struct packetbuf_attr attrs[PACKETBUF_NUM_ATTRS];
+  struct packetbuf_addr addrs[PACKETBUF_NUM_ADDRS];
+#endif /* WITH_SWAP */
 };
 
 /* The actual queuebuf data */
 struct queuebuf_data {
   uint8_t data[PACKETBUF_SIZE];
   uint16_t len;
+#if WITH_SWAP
   struct packetbuf_attr attrs[PACKETBUF_NUM_ATTRS];
   struct packetbuf_addr addrs[PACKETBUF_NUM_ADDRS];
+#else /* WITH_SWAP */
+  uint8_t refcount;
+#endif /* WITH_SWAP */
 };
 
-MEMB(bufmem, struct queuebuf, QUEUEBUF_NUM);
-MEMB(buframmem, struct queuebuf_data, QUEUEBUFRAM_NUM);
+/*---------------------------------------------------------------------------*/
+static struct packetbuf_attr *
+qbuf_attrs(struct queuebuf *b, struct queuebuf_data *d)
+{
+#if WITH_SWAP
+  return d->attrs;
+#else /* WITH_SWAP */
+  return b->attrs;
+#endif /* WITH_SWAP */
+}
+/*---------------------------------------------------------------------------*/
+static struct packetbuf_addr *
+qbuf_addrs(struct queuebuf *b, struct queuebuf_data *d)
+{
+#if WITH_SWAP
+  return d->addrs;
+#else /* WITH_SWAP */
+  return b->addrs;
+#endif /* WITH_SWAP */
+}
+
+MEMB_FREELIST(bufmem, struct queuebuf, QUEUEBUF_NUM);
+MEMB_FREELIST(buframmem, struct queuebuf_data, QUEUEBUFRAM_NUM);
 
 #if WITH_SWAP
 
@@ -269,11 +299,50 @@ queuebuf_load_to_ram(struct queuebuf *b)
 }
 #else /* WITH_SWAP */
 /*---------------------------------------------------------------------------*/
+/* The most recently stored frame. A frame that is queued again before
+   packetbuf is changed, such as a 6LoWPAN fragment that is first saved
+   by sicslowpan and then queued by the MAC layer, is shared instead of
+   copied. */
+static struct queuebuf_data *last_data;
+/*---------------------------------------------------------------------------*/
 static struct queuebuf_data *
 queuebuf_load_to_ram(struct queuebuf *b)
 {
   return b->ram_ptr;
 }
+/*---------------------------------------------------------------------------*/
+static struct queuebuf_data *
+data_from_packetbuf(void)
+{
+  struct queuebuf_data *d = last_data;
+
+  if(d != NULL && d->len == packetbuf_totlen() &&
+     memcmp(d->data, packetbuf_hdrptr(), packetbuf_hdrlen()) == 0 &&
+     memcmp(d->data + packetbuf_hdrlen(), packetbuf_dataptr(),
+            packetbuf_datalen()) == 0) {
+    d->refcount++;
+    return d;
+  }
+
+  d = memb_alloc(&buframmem);
+  if(d != NULL) {
+    d->len = packetbuf_copyto(d->data);
+    d->refcount = 1;
+    last_data = d;
+  }
+  return d;
+}
+/*---------------------------------------------------------------------------*/
+static void
+data_release(struct queuebuf_data *d)
+{
+  if(--d->refcount == 0) {
+    if(d == last_data) {
+      last_data = NULL;
+    }
+    memb_free(&buframmem, d);
+  }
+}
 #endif /* WITH_SWAP */
 /*---------------------------------------------------------------------------*/
 void
@@ -288,6 +357,9 @@ queuebuf_init(void)
 #endif
   memb_init(&buframmem);
   memb_init(&bufmem);
+#if !WITH_SWAP
+  last_data = NULL;
+#endif /* !WITH_SWAP */
 #if QUEUEBUF_STATS
   queuebuf_max_len = 0;
 #endif /* QUEUEBUF_STATS */
@@ -309,7 +381,6 @@ queuebuf_new_from_packetbuf(void)
 {
   struct queuebuf *buf;
 
-  struct queuebuf_data *buframptr;
   buf = memb_alloc(&bufmem);
   if(buf != NULL) {
 #if QUEUEBUF_DEBUG
@@ -318,8 +389,10 @@ queuebuf_new_from_packetbuf(void)
     buf->line = line;
     buf->time = clock_time();
 #endif /* QUEUEBUF_DEBUG */
-    buf->ram_ptr = memb_alloc(&buframmem);
 #if WITH_SWAP
+    struct queuebuf_data *buframptr;
+
+    buf->ram_ptr = memb_alloc(&buframmem);
     /* If the allocation failed, store the qbuf in swap files */
     if(buf->ram_ptr != NULL) {
       buf->location = IN_RAM;
@@ -330,19 +403,10 @@ queuebuf_new_from_packetbuf(void)
       tmpdata_qbuf = buf;
       buframptr = &tmpdata;
     }
-#else
-    if(buf->ram_ptr == NULL) {
-      PRINTF("queuebuf_new_from_packetbuf: could not queuebuf data\n");
-      memb_free(&bufmem, buf);
-      return NULL;
-    }
-    buframptr = buf->ram_ptr;
-#endif
 
     buframptr->len = packetbuf_copyto(buframptr->data);
     packetbuf_attr_copyto(buframptr->attrs, buframptr->addrs);
 
-#if WITH_SWAP
     if(buf->location == IN_CFS) {
       if(queuebuf_flush_tmpdata() == -1) {
         /* We were unable to write the data in the swap */
@@ -350,7 +414,15 @@ queuebuf_new_from_packetbuf(void)
         return NULL;
       }
     }
-#endif
+#else /* WITH_SWAP */
+    buf->ram_ptr = data_from_packetbuf();
+    if(buf->ram_ptr == NULL) {
+      PRINTF("queuebuf_new_from_packetbuf: could not queuebuf data\n");
+      memb_free(&bufmem, buf);
+      return NULL;
+    }
+    packetbuf_attr_copyto(buf->attrs, buf->addrs);
+#endif /* WITH_SWAP */
 
 #if QUEUEBUF_STATS
     ++queuebuf_len;
@@ -370,7 +442,7 @@ void
 queuebuf_update_attr_from_packetbuf(struct queuebuf *buf)
 {
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(buf);
-  packetbuf_attr_copyto(buframptr->attrs, buframptr->addrs);
+  packetbuf_attr_copyto(qbuf_attrs(buf, buframptr), qbuf_addrs(buf, buframptr));
 #if WITH_SWAP
   if(buf->location == IN_CFS) {
     queuebuf_flush_tmpdata();
@@ -379,10 +451,34 @@ queuebuf_update_attr_from_packetbuf(struct queuebuf *buf)
 }
 /*---------------------------------------------------------------------------*/
 void
+queuebuf_unshare(struct queuebuf *buf)
+{
+#if !WITH_SWAP
+  struct queuebuf_data *d = buf->ram_ptr;
+
+  if(d->refcount > 1) {
+    /* The frame is shared: give this queuebuf its own copy. There are
+       fewer frames than queuebufs in use, so this cannot fail. */
+    d->refcount--;
+    buf->ram_ptr = memb_alloc(&buframmem);
+    memcpy(buf->ram_ptr->data, d->data, d->len);
+    buf->ram_ptr->len = d->len;
+    buf->ram_ptr->refcount = 1;
+  } else if(d == last_data) {
+    /* Do not let a frame queued later share this one */
+    last_data = NULL;
+  }
+#endif /* !WITH_SWAP */
+}
+/*---------------------------------------------------------------------------*/
+void
 queuebuf_update_from_packetbuf(struct queuebuf *buf)
 {
-  struct queuebuf_data *buframptr = queuebuf_load_to_ram(buf);
-  packetbuf_attr_copyto(buframptr->attrs, buframptr->addrs);
+  struct queuebuf_data *buframptr;
+
+  queuebuf_unshare(buf);
+  buframptr = queuebuf_load_to_ram(buf);
+  packetbuf_attr_copyto(qbuf_attrs(buf, buframptr), qbuf_addrs(buf, buframptr));
   buframptr->len = packetbuf_copyto(buframptr->data);
 #if WITH_SWAP
   if(buf->location == IN_CFS) {
@@ -402,7 +498,7 @@ queuebuf_free(struct queuebuf *buf)
       queuebuf_remove_from_file(buf->swap_id);
     }
 #else
-    memb_free(&buframmem, buf->ram_ptr);
+    data_release(buf->ram_ptr);
 #endif
     memb_free(&bufmem, buf);
 #if QUEUEBUF_STATS
@@ -421,7 +517,7 @@ queuebuf_to_packetbuf(struct queuebuf *b)
   if(memb_inmemb(&bufmem, b)) {
     struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
     packetbuf_copyfrom(buframptr->data, buframptr->len);
-    packetbuf_attr_copyfrom(buframptr->attrs, buframptr->addrs);
+    packetbuf_attr_copyfrom(qbuf_attrs(b, buframptr), qbuf_addrs(b, buframptr));
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -446,14 +542,14 @@ linkaddr_t *
 queuebuf_addr(struct queuebuf *b, uint8_t type)
 {
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
-  return &buframptr->addrs[type - PACKETBUF_ADDR_FIRST].addr;
+  return &qbuf_addrs(b, buframptr)[type - PACKETBUF_ADDR_FIRST].addr;
 }
 /*---------------------------------------------------------------------------*/
 packetbuf_attr_t
 queuebuf_attr(struct queuebuf *b, uint8_t type)
 {
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
-  return buframptr->attrs[type].val;
+  return qbuf_attrs(b, buframptr)[type].val;
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -48,6 +48,17 @@
  *
  * The queuebuf module handles buffers that are queued.
  *
+ * Unless queuebufs are swapped to CFS, a frame that is queued several
+ * times without packetbuf being modified in between (for instance a
+ * 6LoWPAN fragment that is saved by sicslowpan and then queued by the
+ * MAC layer) is stored once and shared by the queuebufs, which keep
+ * their own packet attributes. queuebuf_update_from_packetbuf() gives
+ * a queuebuf its own copy before modifying the frame. The frame
+ * returned by queuebuf_dataptr() may only be written to after
+ * queuebuf_unshare() has been called on the queuebuf, which also keeps
+ * frames queued later from sharing it. Call it from the context that
+ * allocates queuebufs, not from interrupt context.
+ *
  */
 
 #ifndef QUEUEBUF_H_
@@ -97,6 +108,7 @@ struct queuebuf *queuebuf_new_from_packetbuf(void);
 #endif /* QUEUEBUF_DEBUG */
 void queuebuf_update_attr_from_packetbuf(struct queuebuf *b);
 void queuebuf_update_from_packetbuf(struct queuebuf *b);
+void queuebuf_unshare(struct queuebuf *b);
 
 void queuebuf_to_packetbuf(struct queuebuf *b);
 void queuebuf_free(struct queuebuf *b);
@@ -777,7 +777,7 @@ dao_input_storing(void)
       PRINT6ADDR(&prefix);
       PRINTF("\n");
       RPL_ROUTE_SET_NOPATH_RECEIVED(rep);
-      rep->state.lifetime = RPL_NOPATH_REMOVAL_DELAY;
+      uip_ds6_route_set_lifetime(rep, RPL_NOPATH_REMOVAL_DELAY);
 
       /* We forward the incoming No-Path DAO to our parent, if we have
          one. */
@@ -839,7 +839,7 @@ dao_input_storing(void)
   }
 
   /* set lifetime and clear NOPATH bit */
-  rep->state.lifetime = RPL_LIFETIME(instance, lifetime);
+  uip_ds6_route_set_lifetime(rep, RPL_LIFETIME(instance, lifetime));
   RPL_ROUTE_CLEAR_NOPATH_RECEIVED(rep);
 
 #if RPL_WITH_MULTICAST
@@ -61,7 +61,7 @@ static int num_nodes;
 
 /* Every known node in the network */
 LIST(nodelist);
-MEMB(nodememb, rpl_ns_node_t, RPL_NS_LINK_NUM);
+MEMB_FREELIST(nodememb, rpl_ns_node_t, RPL_NS_LINK_NUM);
 
 /*---------------------------------------------------------------------------*/
 int
@@ -148,7 +148,7 @@
 /* Special value indicating infinite lifetime. */
 #define RPL_INFINITE_LIFETIME           0xFF
 
-#define RPL_ROUTE_INFINITE_LIFETIME           0xFFFFFFFF
+#define RPL_ROUTE_INFINITE_LIFETIME           UIP_DS6_ROUTE_INFINITE_LIFETIME
 
 #define RPL_LIFETIME(instance, lifetime) \
           (((lifetime) == RPL_INFINITE_LIFETIME) ? RPL_ROUTE_INFINITE_LIFETIME : (unsigned long)(instance)->lifetime_unit * (lifetime))
@@ -385,6 +385,7 @@ void rpl_remove_routes_by_nexthop(uip_ipaddr_t *nexthop, rpl_dag_t *dag);
 uip_ds6_route_t *rpl_add_route(rpl_dag_t *dag, uip_ipaddr_t *prefix,
                                int prefix_len, uip_ipaddr_t *next_hop);
 void rpl_purge_routes(void);
+void rpl_route_expired_callback(uip_ds6_route_t *route);
 
 /* Objective function. */
 rpl_of_t *rpl_find_of(rpl_ocp_t);
@@ -111,55 +111,11 @@ rpl_set_mode(enum rpl_mode m)
 void
 rpl_purge_routes(void)
 {
-  uip_ds6_route_t *r;
-  uip_ipaddr_t prefix;
-  rpl_dag_t *dag;
 #if RPL_WITH_MULTICAST
   uip_mcast6_route_t *mcast_route;
-#endif
-
-  /* First pass, decrement lifetime */
-  r = uip_ds6_route_head();
-
-  while(r != NULL) {
-    if(r->state.lifetime >= 1 && r->state.lifetime != RPL_ROUTE_INFINITE_LIFETIME) {
-      /*
-       * If a route is at lifetime == 1, set it to 0, scheduling it for
-       * immediate removal below. This achieves the same as the original code,
-       * which would delete lifetime <= 1
-       */
-      r->state.lifetime--;
-    }
-    r = uip_ds6_route_next(r);
-  }
-
-  /* Second pass, remove dead routes */
-  r = uip_ds6_route_head();
-
-  while(r != NULL) {
-    if(r->state.lifetime < 1) {
-      /* Routes with lifetime == 1 have only just been decremented from 2 to 1,
-       * thus we want to keep them. Hence < and not <= */
-      uip_ipaddr_copy(&prefix, &r->ipaddr);
-      uip_ds6_route_rm(r);
-      r = uip_ds6_route_head();
-      PRINTF("RPL: No more routes to ");
-      PRINT6ADDR(&prefix);
-      dag = default_instance->current_dag;
-      /* Propagate this information with a No-Path DAO to preferred parent if we are not a RPL Root */
-      if(dag->rank != ROOT_RANK(default_instance)) {
-        PRINTF(" -> generate No-Path DAO\n");
-        dao_output_target(dag->preferred_parent, &prefix, RPL_ZERO_LIFETIME);
-        /* Don't schedule more than 1 No-Path DAO, let next iteration handle that */
-        return;
-      }
-      PRINTF("\n");
-    } else {
-      r = uip_ds6_route_next(r);
-    }
-  }
 
-#if RPL_WITH_MULTICAST
+  /* Unicast routes are expired from the ds6 timer wheel, see
+     rpl_route_expired_callback(). */
   mcast_route = uip_mcast6_route_list_head();
 
   while(mcast_route != NULL) {
@@ -175,6 +131,36 @@ rpl_purge_routes(void)
 }
 /*---------------------------------------------------------------------------*/
 void
+rpl_route_expired_callback(uip_ds6_route_t *r)
+{
+  static unsigned long nopath_sent;
+  uip_ipaddr_t prefix;
+  rpl_dag_t *dag;
+
+  dag = default_instance != NULL ? default_instance->current_dag : NULL;
+  if(dag != NULL && dag->rank != ROOT_RANK(default_instance) &&
+     nopath_sent == clock_seconds()) {
+    /* Don't send more than 1 No-Path DAO per second, expire this route
+       on the next round */
+    uip_ds6_route_set_lifetime(r, 1);
+    return;
+  }
+
+  uip_ipaddr_copy(&prefix, &r->ipaddr);
+  uip_ds6_route_rm(r);
+  PRINTF("RPL: No more routes to ");
+  PRINT6ADDR(&prefix);
+  /* Propagate this information with a No-Path DAO to preferred parent if we are not a RPL Root */
+  if(dag != NULL && dag->rank != ROOT_RANK(default_instance)) {
+    PRINTF(" -> generate No-Path DAO\n");
+    dao_output_target(dag->preferred_parent, &prefix, RPL_ZERO_LIFETIME);
+    nopath_sent = clock_seconds();
+    return;
+  }
+  PRINTF("\n");
+}
+/*---------------------------------------------------------------------------*/
+void
 rpl_remove_routes(rpl_dag_t *dag)
 {
   uip_ds6_route_t *r;
@@ -217,7 +203,7 @@ rpl_remove_routes_by_nexthop(uip_ipaddr_t *nexthop, rpl_dag_t *dag)
   while(r != NULL) {
     if(uip_ipaddr_cmp(uip_ds6_route_nexthop(r), nexthop) &&
         r->state.dag == dag) {
-      r->state.lifetime = 0;
+      uip_ds6_route_set_lifetime(r, 0);
     }
     r = uip_ds6_route_next(r);
   }
@@ -236,7 +222,7 @@ rpl_add_route(rpl_dag_t *dag, uip_ipaddr_t *prefix, int prefix_len,
   }
 
   rep->state.dag = dag;
-  rep->state.lifetime = RPL_LIFETIME(dag->instance, dag->instance->default_lifetime);
+  uip_ds6_route_set_lifetime(rep, RPL_LIFETIME(dag->instance, dag->instance->default_lifetime));
   /* always clear state flags for the no-path received when adding/refreshing */
   RPL_ROUTE_CLEAR_NOPATH_RECEIVED(rep);
 
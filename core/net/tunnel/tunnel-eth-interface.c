@@ -36,6 +36,7 @@
 
 #include "net/ip/uip.h"
 #include "net/ipv6/uip-ds6.h"
+#include "net/ip/uip-pktbuf.h"
 #include "dev/slip.h"
 
 #include "tunnel.h"
@@ -49,6 +50,41 @@
 #define DEBUG DEBUG_NONE
 #include "net/ip/uip-debug.h"
 #define printf(...)
+
+/* The IPv6 packet waiting for an ARP reply. It is kept in the packet
+   pool since uip_buf is reused before the reply comes in. */
+static struct uip_pktbuf *arp_pending;
+/*---------------------------------------------------------------------------*/
+/*
+ * Encapsulate an IPv6 packet into tunnel_packet_buffer and send it if
+ * the next hop is in the ARP cache. Returns 1 if the packet was sent
+ * or dropped, and 0 if the address is still unresolved; the IPv4
+ * packet is then left in tunnel_packet_buffer.
+ */
+static int
+encap_and_send(const uint8_t *ipv6packet, uint16_t ipv6len)
+{
+  int len, ret;
+
+  len = tunnel_encap(ipv6packet, ipv6len,
+		  &tunnel_packet_buffer[sizeof(struct tunnel_eth_hdr)]);
+
+  printf("tunnel-interface: output len %d\n", len);
+  if(len <= 0) {
+    return 1;
+  }
+  if(!tunnel_arp_check_cache(&tunnel_packet_buffer[sizeof(struct tunnel_eth_hdr)])) {
+    return 0;
+  }
+  printf("Create header\n");
+  ret = tunnel_arp_create_ethhdr(tunnel_packet_buffer,
+			       &tunnel_packet_buffer[sizeof(struct tunnel_eth_hdr)]);
+  if(ret > 0) {
+    len += ret;
+    TUNNEL_ETH_DRIVER.output(tunnel_packet_buffer, len);
+  }
+  return 1;
+}
 /*---------------------------------------------------------------------------*/
 void
 tunnel_eth_interface_input(uint8_t *packet, uint16_t len)
@@ -62,6 +98,15 @@ tunnel_eth_interface_input(uint8_t *packet, uint16_t len)
     if(len > 0) {
       TUNNEL_ETH_DRIVER.output(packet, len);
     }
+
+    /* The ARP packet is done with; send the pending packet if its next
+       hop has just been resolved. */
+    if(arp_pending != NULL &&
+       encap_and_send(uip_pktbuf_dataptr(arp_pending),
+		      uip_pktbuf_datalen(arp_pending))) {
+      uip_pktbuf_free(arp_pending);
+      arp_pending = NULL;
+    }
   } else if(ethhdr->type == UIP_HTONS(TUNNEL_ETH_TYPE_IP) &&
 	    len > sizeof(struct tunnel_eth_hdr)) {
     printf("-------------->\n");
@@ -92,7 +137,7 @@ init(void)
 static int
 output(void)
 {
-  int len, ret;
+  int len;
 
   printf("tunnel-interface: output source ");
   PRINT6ADDR(&UIP_IP_BUF->srcipaddr);
@@ -101,28 +146,20 @@ output(void)
   PRINTF("\n");
 
   printf("<--------------\n");
-  len = tunnel_encap(&uip_buf[UIP_LLH_LEN], uip_len,
-		  &tunnel_packet_buffer[sizeof(struct tunnel_eth_hdr)]);
-
-  printf("tunnel-interface: output len %d\n", len);
-  if(len > 0) {
-    if(tunnel_arp_check_cache(&tunnel_packet_buffer[sizeof(struct tunnel_eth_hdr)])) {
-      printf("Create header\n");
-      ret = tunnel_arp_create_ethhdr(tunnel_packet_buffer,
-				   &tunnel_packet_buffer[sizeof(struct tunnel_eth_hdr)]);
-      if(ret > 0) {
-	len += ret;
-	TUNNEL_ETH_DRIVER.output(tunnel_packet_buffer, len);
-      }
-    } else {
-      printf("Create request\n");
-      len = tunnel_arp_create_arp_request(tunnel_packet_buffer,
-					&tunnel_packet_buffer[sizeof(struct tunnel_eth_hdr)]);
-      return TUNNEL_ETH_DRIVER.output(tunnel_packet_buffer, len);
-    }
+  if(encap_and_send(&uip_buf[UIP_LLH_LEN], uip_len)) {
+    return 0;
   }
 
-  return 0;
+  /* Hold on to the packet until the ARP reply comes in. Only the most
+     recent one is kept, like the uIP ARP code does. */
+  printf("Create request\n");
+  if(arp_pending != NULL) {
+    uip_pktbuf_free(arp_pending);
+  }
+  arp_pending = uip_pktbuf_new_from_uipbuf();
+  len = tunnel_arp_create_arp_request(tunnel_packet_buffer,
+				    &tunnel_packet_buffer[sizeof(struct tunnel_eth_hdr)]);
+  return TUNNEL_ETH_DRIVER.output(tunnel_packet_buffer, len);
 }
 /*---------------------------------------------------------------------------*/
 const struct uip_fallback_interface tunnel_eth_interface = {
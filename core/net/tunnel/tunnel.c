@@ -64,6 +64,7 @@
 #include "net/ipv6/uip-ds6.h"
 #include "tunnel-ipv4-dhcp.h"
 #include "contiki-net.h"
+#include "sys/trace.h"
 
 #include "net/ip/uip-debug.h"
 
@@ -552,6 +553,8 @@ tunnel_encap(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
   struct udp_hdr *udphdr;
   uint16_t ipv6len, ipv4len;
 
+  TRACE(TRACE_TUNNEL_ENCAP, ipv6packet_len, 0, 0);
+
   udphdr = (struct udp_hdr *)&ipv6packet[IPV6_HDRLEN];
 
   /* handle packets in ephemeral port range locally (i.e. DHCP packet) */
@@ -814,6 +817,8 @@ tunnel_decap(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
   struct icmpv6_hdr *icmpv6hdr;
   uint16_t ipv4len, ipv6len, ipv6_packet_len;
 
+  TRACE(TRACE_TUNNEL_DECAP, ipv4packet_len, 0, 0);
+
   v6hdr = (struct ipv6_hdr *)resultpacket;
   v4hdr = (struct ipv4_hdr *)ipv4packet;
 
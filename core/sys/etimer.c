@@ -49,38 +49,177 @@
 #include "sys/etimer.h"
 #include "sys/process.h"
 
+/*
+ * Pending timers are kept in a pairing heap ordered by expiration
+ * time, soonest at the root. Each timer's next and prev pointers link
+ * it to its siblings, prev pointing to the parent for a first child,
+ * and child points to its first child. Setting a timer is O(1),
+ * stopping one and taking the root are O(log n) amortized, so the
+ * poll handler spends O(k log n) on k expired timers out of n, and the
+ * next expiration is read from the root.
+ */
 static struct etimer *timerlist;
 static clock_time_t next_expiration;
 
 PROCESS(etimer_process, "Event timer");
 /*---------------------------------------------------------------------------*/
+/* Time left until t expires, zero if it already has. Comparing
+   remaining times instead of absolute expiration times keeps the
+   ordering correct across clock wraps, and the order of two timers
+   does not change as time passes. */
+static clock_time_t
+remaining(struct etimer *t, clock_time_t now)
+{
+  clock_time_t elapsed = now - t->timer.start;
+
+  if(elapsed >= t->timer.interval) {
+    return 0;
+  }
+  return t->timer.interval - elapsed;
+}
+/*---------------------------------------------------------------------------*/
 static void
 update_time(void)
 {
-  clock_time_t tdist;
-  clock_time_t now;
+  if(timerlist == NULL) {
+    next_expiration = 0;
+  } else {
+    next_expiration = timerlist->timer.start + timerlist->timer.interval;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Join two heaps whose roots have no siblings. Returns the new root. */
+static struct etimer *
+meld(struct etimer *a, struct etimer *b, clock_time_t now)
+{
   struct etimer *t;
 
-  if (timerlist == NULL) {
-    next_expiration = 0;
+  if(a == NULL) {
+    return b;
+  }
+  if(b == NULL) {
+    return a;
+  }
+  if(remaining(b, now) < remaining(a, now)) {
+    t = a;
+    a = b;
+    b = t;
+  }
+  b->prev = a;
+  b->next = a->child;
+  if(a->child != NULL) {
+    a->child->prev = b;
+  }
+  a->child = b;
+  return a;
+}
+/*---------------------------------------------------------------------------*/
+/* Join a list of siblings into one heap: meld them pairwise from the
+   left, then meld the pairs from the right. Returns the new root. */
+static struct etimer *
+merge_siblings(struct etimer *first, clock_time_t now)
+{
+  struct etimer *a, *b;
+  struct etimer *pairs;
+  struct etimer *root;
+
+  pairs = NULL;
+  while(first != NULL) {
+    a = first;
+    b = a->next;
+    first = b != NULL ? b->next : NULL;
+    a->next = a->prev = NULL;
+    if(b != NULL) {
+      b->next = b->prev = NULL;
+    }
+    a = meld(a, b, now);
+    a->next = pairs;
+    pairs = a;
+  }
+
+  root = NULL;
+  while(pairs != NULL) {
+    a = pairs;
+    pairs = a->next;
+    a->next = NULL;
+    root = meld(root, a, now);
+  }
+  return root;
+}
+/*---------------------------------------------------------------------------*/
+static void
+insert_timer(struct etimer *et)
+{
+  et->next = et->prev = et->child = NULL;
+  timerlist = meld(timerlist, et, clock_time());
+  et->pending = 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_timer(struct etimer *et)
+{
+  clock_time_t now = clock_time();
+
+  if(et == timerlist) {
+    timerlist = merge_siblings(et->child, now);
   } else {
-    now = clock_time();
-    t = timerlist;
-    /* Must calculate distance to next time into account due to wraps */
-    tdist = t->timer.start + t->timer.interval - now;
-    for(t = t->next; t != NULL; t = t->next) {
-      if(t->timer.start + t->timer.interval - now < tdist) {
-	tdist = t->timer.start + t->timer.interval - now;
-      }
+    if(et->prev->child == et) {
+      et->prev->child = et->next;
+    } else {
+      et->prev->next = et->next;
+    }
+    if(et->next != NULL) {
+      et->next->prev = et->prev;
+    }
+    timerlist = meld(timerlist, merge_siblings(et->child, now), now);
+  }
+  et->next = et->prev = et->child = NULL;
+  et->pending = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Take all timers of an exited process out of the heap. This visits
+   every timer, which is fine for an event this rare. */
+static void
+remove_process_timers(struct process *p)
+{
+  struct etimer *todo;
+  struct etimer *t;
+  clock_time_t now;
+
+  if(timerlist == NULL) {
+    return;
+  }
+
+  now = clock_time();
+  todo = timerlist;
+  timerlist = NULL;
+  /* Walk the old heap with prev as the stack link, and meld the
+     timers to keep into a new heap. */
+  todo->prev = NULL;
+  while(todo != NULL) {
+    t = todo;
+    todo = t->prev;
+    if(t->child != NULL) {
+      t->child->prev = todo;
+      todo = t->child;
+    }
+    if(t->next != NULL) {
+      t->next->prev = todo;
+      todo = t->next;
+    }
+    t->next = t->prev = t->child = NULL;
+    if(t->p == p) {
+      t->pending = 0;
+    } else {
+      timerlist = meld(timerlist, t, now);
     }
-    next_expiration = now + tdist;
   }
 }
 /*---------------------------------------------------------------------------*/
 PROCESS_THREAD(etimer_process, ev, data)
 {
-  struct etimer *t, *u;
-	
+  struct etimer *t;
+
   PROCESS_BEGIN();
 
   timerlist = NULL;
@@ -89,53 +228,29 @@ PROCESS_THREAD(etimer_process, ev, data)
     PROCESS_YIELD();
 
     if(ev == PROCESS_EVENT_EXITED) {
-      struct process *p = data;
-
-      while(timerlist != NULL && timerlist->p == p) {
-	timerlist = timerlist->next;
-      }
-
-      if(timerlist != NULL) {
-	t = timerlist;
-	while(t->next != NULL) {
-	  if(t->next->p == p) {
-	    t->next = t->next->next;
-	  } else
-	    t = t->next;
-	}
-      }
+      remove_process_timers(data);
+      update_time();
       continue;
     } else if(ev != PROCESS_EVENT_POLL) {
       continue;
     }
 
-  again:
-    
-    u = NULL;
-    
-    for(t = timerlist; t != NULL; t = t->next) {
-      if(timer_expired(&t->timer)) {
-	if(process_post(t->p, PROCESS_EVENT_TIMER, t) == PROCESS_ERR_OK) {
-	  
-	  /* Reset the process ID of the event timer, to signal that the
-	     etimer has expired. This is later checked in the
-	     etimer_expired() function. */
-	  t->p = PROCESS_NONE;
-	  if(u != NULL) {
-	    u->next = t->next;
-	  } else {
-	    timerlist = t->next;
-	  }
-	  t->next = NULL;
-	  update_time();
-	  goto again;
-	} else {
-	  etimer_request_poll();
-	}
+    /* Expired timers are taken from the root of the heap. */
+    while(timerlist != NULL && timer_expired(&timerlist->timer)) {
+      t = timerlist;
+      if(process_post(t->p, PROCESS_EVENT_TIMER, t) != PROCESS_ERR_OK) {
+        /* The event queue is full; try again on the next poll. */
+        etimer_request_poll();
+        break;
       }
-      u = t;
+
+      /* Reset the process ID of the event timer, to signal that the
+         etimer has expired. This is later checked in the
+         etimer_expired() function. */
+      t->p = PROCESS_NONE;
+      remove_timer(t);
     }
-    
+    update_time();
   }
   
   PROCESS_END();
@@ -150,25 +265,14 @@ etimer_request_poll(void)
 static void
 add_timer(struct etimer *timer)
 {
-  struct etimer *t;
-
   etimer_request_poll();
 
-  if(timer->p != PROCESS_NONE) {
-    for(t = timerlist; t != NULL; t = t->next) {
-      if(t == timer) {
-	/* Timer already on list, bail out. */
-        timer->p = PROCESS_CURRENT();
-	update_time();
-	return;
-      }
-    }
+  if(timer->pending) {
+    remove_timer(timer);
   }
 
-  /* Timer not on list. */
   timer->p = PROCESS_CURRENT();
-  timer->next = timerlist;
-  timerlist = timer;
+  insert_timer(timer);
 
   update_time();
 }
@@ -206,7 +310,11 @@ void
 etimer_adjust(struct etimer *et, int timediff)
 {
   et->timer.start += timediff;
-  update_time();
+  if(et->pending) {
+    remove_timer(et);
+    insert_timer(et);
+    update_time();
+  }
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -242,29 +350,11 @@ etimer_next_expiration_time(void)
 void
 etimer_stop(struct etimer *et)
 {
-  struct etimer *t;
-
-  /* First check if et is the first event timer on the list. */
-  if(et == timerlist) {
-    timerlist = timerlist->next;
+  if(et->pending) {
+    remove_timer(et);
     update_time();
-  } else {
-    /* Else walk through the list and try to find the item before the
-       et timer. */
-    for(t = timerlist; t != NULL && t->next != et; t = t->next);
-
-    if(t != NULL) {
-      /* We've found the item before the event timer that we are about
-	 to remove. We point the items next pointer to the event after
-	 the removed item. */
-      t->next = et->next;
-
-      update_time();
-    }
   }
 
-  /* Remove the next pointer from the item to be removed. */
-  et->next = NULL;
   /* Set the timer as expired */
   et->p = PROCESS_NONE;
 }
@@ -75,8 +75,13 @@
  */
 struct etimer {
   struct timer timer;
+  /* Links in the pairing heap of pending timers, see etimer.c */
   struct etimer *next;
+  struct etimer *prev;
+  struct etimer *child;
   struct process *p;
+  /* Non-zero while the timer is in the heap */
+  uint8_t pending;
 };
 
 /**
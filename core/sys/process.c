@@ -47,6 +47,15 @@
 
 #include "sys/process.h"
 #include "sys/arg.h"
+#include "sys/trace.h"
+
+#if PROCESS_CONF_GROW_EVENTS
+#include <stdlib.h>
+#endif /* PROCESS_CONF_GROW_EVENTS */
+
+#if PROCESS_CONF_PROFILE
+#include "sys/rtimer.h"
+#endif /* PROCESS_CONF_PROFILE */
 
 /*
  * Pointer to the currently running process structure.
@@ -66,13 +75,38 @@ struct event_data {
 };
 
 static process_num_events_t nevents, fevent;
+#if PROCESS_CONF_GROW_EVENTS
+static struct event_data initial_events[PROCESS_CONF_NUMEVENTS];
+static struct event_data *events = initial_events;
+static process_num_events_t events_size = PROCESS_CONF_NUMEVENTS;
+#define EVENTS_SIZE events_size
+#else /* PROCESS_CONF_GROW_EVENTS */
 static struct event_data events[PROCESS_CONF_NUMEVENTS];
+#define EVENTS_SIZE PROCESS_CONF_NUMEVENTS
+#endif /* PROCESS_CONF_GROW_EVENTS */
 
 #if PROCESS_CONF_STATS
 process_num_events_t process_maxevents;
+/* Number of events that could not be posted because the queue was full. */
+unsigned long process_lostevents;
 #endif
 
+#if PROCESS_CONF_POLL_LIST
+/*
+ * Processes that have been polled, most recently polled first. A
+ * process is on the list while its needspoll flag is set.
+ */
+static struct process *poll_list;
+#define poll_requested (__atomic_load_n(&poll_list, __ATOMIC_RELAXED) != NULL)
+#else /* PROCESS_CONF_POLL_LIST */
 static volatile unsigned char poll_requested;
+#endif /* PROCESS_CONF_POLL_LIST */
+
+#if PROCESS_CONF_PROFILE
+/* Time spent in processes called by the one currently running, which
+   is not counted as its own. */
+static rtimer_clock_t nested_time;
+#endif /* PROCESS_CONF_PROFILE */
 
 #define PROCESS_STATE_NONE        0
 #define PROCESS_STATE_RUNNING     1
@@ -175,6 +209,9 @@ static void
 call_process(struct process *p, process_event_t ev, process_data_t data)
 {
   int ret;
+#if PROCESS_CONF_PROFILE
+  rtimer_clock_t start, elapsed, own, outer_nested_time;
+#endif /* PROCESS_CONF_PROFILE */
 
 #if DEBUG
   if(p->state == PROCESS_STATE_CALLED) {
@@ -187,7 +224,30 @@ call_process(struct process *p, process_event_t ev, process_data_t data)
     PRINTF("process: calling process '%s' with event %d\n", PROCESS_NAME_STRING(p), ev);
     process_current = p;
     p->state = PROCESS_STATE_CALLED;
+#if PROCESS_CONF_COUNTERS
+    if(ev == PROCESS_EVENT_POLL) {
+      p->npolls++;
+    } else {
+      p->nevents++;
+    }
+#endif /* PROCESS_CONF_COUNTERS */
+    TRACE(TRACE_PROCESS_BEGIN, ev, TRACE_PTR(p), 0);
+#if PROCESS_CONF_PROFILE
+    outer_nested_time = nested_time;
+    nested_time = 0;
+    start = RTIMER_NOW();
+#endif /* PROCESS_CONF_PROFILE */
     ret = p->thread(&p->pt, ev, data);
+#if PROCESS_CONF_PROFILE
+    elapsed = RTIMER_NOW() - start;
+    own = elapsed - nested_time;
+    p->runtime += own;
+    if(own > p->maxtime) {
+      p->maxtime = own;
+    }
+    nested_time = outer_nested_time + elapsed;
+#endif /* PROCESS_CONF_PROFILE */
+    TRACE(TRACE_PROCESS_END, ev, TRACE_PTR(p), ret);
     if(ret == PT_EXITED ||
        ret == PT_ENDED ||
        ev == PROCESS_EVENT_EXIT) {
@@ -212,6 +272,7 @@ process_init(void)
   nevents = fevent = 0;
 #if PROCESS_CONF_STATS
   process_maxevents = 0;
+  process_lostevents = 0;
 #endif /* PROCESS_CONF_STATS */
 
   process_current = process_list = NULL;
@@ -221,6 +282,40 @@ process_init(void)
  * Call each process' poll handler.
  */
 /*---------------------------------------------------------------------------*/
+#if PROCESS_CONF_POLL_LIST
+static void
+do_poll(void)
+{
+  struct process *p, *next, *list;
+
+  /* Take the whole list at once; processes polled from here on are
+     queued on a new list and handled in the next round. */
+  p = __atomic_exchange_n(&poll_list, NULL, __ATOMIC_ACQUIRE);
+
+  /* Reverse the list so that processes are polled in the order in
+     which the polls were requested. */
+  list = NULL;
+  while(p != NULL) {
+    next = p->nextpoll;
+    p->nextpoll = list;
+    list = p;
+    p = next;
+  }
+
+  for(p = list; p != NULL; p = next) {
+    next = p->nextpoll;
+    p->nextpoll = NULL;
+    /* Clear the flag before calling the process, so that it can be
+       polled again while it runs. */
+    __atomic_store_n(&p->needspoll, 0, __ATOMIC_RELEASE);
+    /* The process may have exited after it was polled. */
+    if(p->state != PROCESS_STATE_NONE) {
+      p->state = PROCESS_STATE_RUNNING;
+      call_process(p, PROCESS_EVENT_POLL, NULL);
+    }
+  }
+}
+#else /* PROCESS_CONF_POLL_LIST */
 static void
 do_poll(void)
 {
@@ -236,6 +331,52 @@ do_poll(void)
     }
   }
 }
+#endif /* PROCESS_CONF_POLL_LIST */
+/*---------------------------------------------------------------------------*/
+#if PROCESS_CONF_GROW_EVENTS
+/*
+ * Double the size of the event queue, up to PROCESS_CONF_MAX_EVENTS.
+ * The queued events are moved to the start of the new queue.
+ */
+static int
+grow_events(void)
+{
+  struct event_data *new_events;
+  process_num_events_t new_size;
+  process_num_events_t i;
+
+  if(events_size >= PROCESS_CONF_MAX_EVENTS || !PROCESS_CONF_CAN_GROW_EVENTS()) {
+    return 0;
+  }
+  if(events_size > PROCESS_CONF_MAX_EVENTS / 2) {
+    new_size = PROCESS_CONF_MAX_EVENTS;
+  } else {
+    new_size = events_size * 2;
+  }
+
+  new_events = malloc(new_size * sizeof(struct event_data));
+  if(new_events == NULL) {
+    return 0;
+  }
+  for(i = 0; i < nevents; i++) {
+    new_events[i] = events[(fevent + i) % events_size];
+  }
+  if(events != initial_events) {
+    free(events);
+  }
+
+  PRINTF("process: event queue grown from %u to %u events\n",
+         events_size, new_size);
+
+  /* events_size is updated last: until then the queue still looks
+     full, so a post from interrupt context is dropped rather than
+     written into the wrong slot. */
+  fevent = 0;
+  events = new_events;
+  events_size = new_size;
+  return 1;
+}
+#endif /* PROCESS_CONF_GROW_EVENTS */
 /*---------------------------------------------------------------------------*/
 /*
  * Process the next event in the event queue and deliver it to
@@ -268,7 +409,7 @@ do_event(void)
 
     /* Since we have seen the new event, we move pointer upwards
        and decrease the number of events. */
-    fevent = (fevent + 1) % PROCESS_CONF_NUMEVENTS;
+    fevent = (fevent + 1) % EVENTS_SIZE;
     --nevents;
 
     /* If this is a broadcast event, we deliver it to all events, in
@@ -318,6 +459,33 @@ process_nevents(void)
   return nevents + poll_requested;
 }
 /*---------------------------------------------------------------------------*/
+#if PROCESS_CONF_PROFILE
+int
+process_profile_top(struct process **top, int n)
+{
+  struct process *p;
+  int count;
+  int i;
+
+  /* Insertion sort into the array, dropping what falls off its end. */
+  count = 0;
+  for(p = process_list; p != NULL; p = p->next) {
+    for(i = count; i > 0 && top[i - 1]->runtime < p->runtime; i--) {
+      if(i < n) {
+        top[i] = top[i - 1];
+      }
+    }
+    if(i < n) {
+      top[i] = p;
+      if(count < n) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+/*---------------------------------------------------------------------------*/
+#endif /* PROCESS_CONF_PROFILE */
 int
 process_post(struct process *p, process_event_t ev, process_data_t data)
 {
@@ -332,7 +500,14 @@ process_post(struct process *p, process_event_t ev, process_data_t data)
 	   p == PROCESS_BROADCAST? "<broadcast>": PROCESS_NAME_STRING(p), nevents);
   }
   
-  if(nevents == PROCESS_CONF_NUMEVENTS) {
+  if(nevents == EVENTS_SIZE
+#if PROCESS_CONF_GROW_EVENTS
+     && !grow_events()
+#endif /* PROCESS_CONF_GROW_EVENTS */
+     ) {
+#if PROCESS_CONF_STATS
+    process_lostevents++;
+#endif /* PROCESS_CONF_STATS */
 #if DEBUG
     if(p == PROCESS_BROADCAST) {
       printf("soft panic: event queue is full when broadcast event %d was posted from %s\n", ev, PROCESS_NAME_STRING(process_current));
@@ -343,7 +518,7 @@ process_post(struct process *p, process_event_t ev, process_data_t data)
     return PROCESS_ERR_FULL;
   }
   
-  snum = (process_num_events_t)(fevent + nevents) % PROCESS_CONF_NUMEVENTS;
+  snum = (process_num_events_t)(fevent + nevents) % EVENTS_SIZE;
   events[snum].ev = ev;
   events[snum].data = data;
   events[snum].p = p;
@@ -373,8 +548,19 @@ process_poll(struct process *p)
   if(p != NULL) {
     if(p->state == PROCESS_STATE_RUNNING ||
        p->state == PROCESS_STATE_CALLED) {
+#if PROCESS_CONF_POLL_LIST
+      /* Only the caller that sets the flag puts the process on the
+         list, so it is never queued twice. */
+      if(__atomic_exchange_n(&p->needspoll, 1, __ATOMIC_ACQ_REL) == 0) {
+        p->nextpoll = __atomic_load_n(&poll_list, __ATOMIC_RELAXED);
+        while(!__atomic_compare_exchange_n(&poll_list, &p->nextpoll, p, 1,
+                                           __ATOMIC_RELEASE,
+                                           __ATOMIC_RELAXED));
+      }
+#else /* PROCESS_CONF_POLL_LIST */
       p->needspoll = 1;
       poll_requested = 1;
+#endif /* PROCESS_CONF_POLL_LIST */
     }
   }
 }
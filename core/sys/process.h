@@ -58,7 +58,73 @@
 
 typedef unsigned char process_event_t;
 typedef void *        process_data_t;
+
+/*
+ * With PROCESS_CONF_GROW_EVENTS set, the event queue starts out with
+ * room for PROCESS_CONF_NUMEVENTS events and is enlarged on the heap
+ * when it fills up, up to PROCESS_CONF_MAX_EVENTS. Since this calls
+ * malloc() from process_post(), a platform that posts events from
+ * interrupt context must define PROCESS_CONF_CAN_GROW_EVENTS() to
+ * evaluate to 0 there; such posts are then dropped when the queue is
+ * full, as without growth.
+ */
+#ifndef PROCESS_CONF_GROW_EVENTS
+#define PROCESS_CONF_GROW_EVENTS 0
+#endif /* PROCESS_CONF_GROW_EVENTS */
+
+#ifndef PROCESS_CONF_CAN_GROW_EVENTS
+#define PROCESS_CONF_CAN_GROW_EVENTS() 1
+#endif /* PROCESS_CONF_CAN_GROW_EVENTS */
+
+#ifndef PROCESS_CONF_MAX_EVENTS
+#define PROCESS_CONF_MAX_EVENTS 1024
+#endif /* PROCESS_CONF_MAX_EVENTS */
+
+#if PROCESS_CONF_GROW_EVENTS
+typedef unsigned short process_num_events_t;
+#else
 typedef unsigned char process_num_events_t;
+#endif
+
+/*
+ * With PROCESS_CONF_POLL_LIST set, polled processes are queued on a
+ * list so that the scheduler only visits the processes that were
+ * actually polled. process_poll() may be called from interrupts, so
+ * the list is maintained with atomic operations; it is enabled by
+ * default when the compiler provides lock-free atomics for pointers.
+ */
+#ifndef PROCESS_CONF_POLL_LIST
+#if defined(__GCC_ATOMIC_POINTER_LOCK_FREE) && \
+    __GCC_ATOMIC_POINTER_LOCK_FREE == 2 && __GCC_ATOMIC_CHAR_LOCK_FREE == 2
+#define PROCESS_CONF_POLL_LIST 1
+#else
+#define PROCESS_CONF_POLL_LIST 0
+#endif
+#endif /* PROCESS_CONF_POLL_LIST */
+
+/*
+ * With PROCESS_CONF_COUNTERS set, each process counts the events and
+ * polls delivered to it in its nevents and npolls fields.
+ */
+#ifndef PROCESS_CONF_COUNTERS
+#define PROCESS_CONF_COUNTERS 0
+#endif /* PROCESS_CONF_COUNTERS */
+
+/*
+ * With PROCESS_CONF_PROFILE set, each process accumulates the time it
+ * runs, in rtimer ticks, in its runtime field, and the longest single
+ * call in maxtime. Time spent in processes it calls synchronously is
+ * not included. Implies PROCESS_CONF_COUNTERS, for the number of
+ * calls.
+ */
+#ifndef PROCESS_CONF_PROFILE
+#define PROCESS_CONF_PROFILE 0
+#endif /* PROCESS_CONF_PROFILE */
+
+#if PROCESS_CONF_PROFILE && !PROCESS_CONF_COUNTERS
+#undef PROCESS_CONF_COUNTERS
+#define PROCESS_CONF_COUNTERS 1
+#endif /* PROCESS_CONF_PROFILE && !PROCESS_CONF_COUNTERS */
 
 /**
  * \name Return values
@@ -323,6 +389,15 @@ struct process {
   PT_THREAD((* thread)(struct pt *, process_event_t, process_data_t));
   struct pt pt;
   unsigned char state, needspoll;
+#if PROCESS_CONF_POLL_LIST
+  struct process *nextpoll;
+#endif /* PROCESS_CONF_POLL_LIST */
+#if PROCESS_CONF_COUNTERS
+  unsigned long nevents, npolls;
+#endif /* PROCESS_CONF_COUNTERS */
+#if PROCESS_CONF_PROFILE
+  unsigned long runtime, maxtime;
+#endif /* PROCESS_CONF_PROFILE */
 };
 
 /**
@@ -519,6 +594,18 @@ CCIF int process_is_running(struct process *p);
  */
 int process_nevents(void);
 
+#if PROCESS_CONF_PROFILE
+/**
+ * Find the processes that have run the longest.
+ *
+ * \param top An array of n pointers, filled in with the running
+ * processes with the largest runtime, longest first.
+ * \param n The size of the array.
+ * \return The number of processes filled in.
+ */
+int process_profile_top(struct process **top, int n);
+#endif /* PROCESS_CONF_PROFILE */
+
 /** @} */
 
 CCIF extern struct process *process_list;
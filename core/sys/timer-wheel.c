@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ * Hierarchical timer wheel implementation.
+ */
+
+/**
+ * \addtogroup timerwheel
+ * @{
+ */
+
+#include "sys/timer-wheel.h"
+
+#include <string.h>
+
+#define SLOT_MASK     (TIMER_WHEEL_SLOTS - 1)
+#define WHEEL_SPAN    ((unsigned long)TIMER_WHEEL_SLOTS * TIMER_WHEEL_SLOTS)
+
+/*---------------------------------------------------------------------------*/
+static void
+entry_link(struct timer_wheel_entry **head, struct timer_wheel_entry *e)
+{
+  e->next = *head;
+  if(e->next != NULL) {
+    e->next->pprev = &e->next;
+  }
+  e->pprev = head;
+  *head = e;
+}
+/*---------------------------------------------------------------------------*/
+static void
+entry_unlink(struct timer_wheel_entry *e)
+{
+  *e->pprev = e->next;
+  if(e->next != NULL) {
+    e->next->pprev = e->pprev;
+  }
+  e->next = NULL;
+  e->pprev = NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Detach a list so that it can be walked while entries are relinked. */
+static struct timer_wheel_entry *
+list_detach(struct timer_wheel_entry **head, struct timer_wheel_entry **to)
+{
+  *to = *head;
+  *head = NULL;
+  if(*to != NULL) {
+    (*to)->pprev = to;
+  }
+  return *to;
+}
+/*---------------------------------------------------------------------------*/
+static void
+place(struct timer_wheel *w, struct timer_wheel_entry *e)
+{
+  unsigned long delta;
+
+  delta = e->expires - w->now;
+  if((long)delta <= 0) {
+    entry_link(&w->due, e);
+  } else if(delta < TIMER_WHEEL_SLOTS) {
+    entry_link(&w->slots[0][e->expires & SLOT_MASK], e);
+  } else if((e->expires >> TIMER_WHEEL_SLOT_BITS) -
+            (w->now >> TIMER_WHEEL_SLOT_BITS) < TIMER_WHEEL_SLOTS) {
+    entry_link(&w->slots[1][(e->expires >> TIMER_WHEEL_SLOT_BITS) & SLOT_MASK], e);
+  } else {
+    entry_link(&w->overflow, e);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+requeue(struct timer_wheel *w, struct timer_wheel_entry **head)
+{
+  struct timer_wheel_entry *list;
+  struct timer_wheel_entry *e;
+
+  list_detach(head, &list);
+  while((e = list) != NULL) {
+    entry_unlink(e);
+    place(w, e);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+advance(struct timer_wheel *w, unsigned long now)
+{
+  unsigned long t;
+  int i;
+
+  if((long)(now - w->now) <= 0) {
+    return;
+  }
+
+  if(now - w->now >= WHEEL_SPAN) {
+    /* Too far behind for stepping to pay off: sort every entry again. */
+    w->now = now;
+    requeue(w, &w->overflow);
+    for(i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+      requeue(w, &w->slots[1][i]);
+      requeue(w, &w->slots[0][i]);
+    }
+    return;
+  }
+
+  while(w->now != now) {
+    t = ++w->now;
+    if((t & (WHEEL_SPAN - 1)) == 0) {
+      requeue(w, &w->overflow);
+    }
+    if((t & SLOT_MASK) == 0) {
+      requeue(w, &w->slots[1][(t >> TIMER_WHEEL_SLOT_BITS) & SLOT_MASK]);
+    }
+    /* All entries in the current first-level slot expire at t. */
+    requeue(w, &w->slots[0][t & SLOT_MASK]);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+timer_wheel_init(struct timer_wheel *w)
+{
+  memset(w, 0, sizeof(struct timer_wheel));
+  w->now = clock_seconds();
+}
+/*---------------------------------------------------------------------------*/
+void
+timer_wheel_entry_init(struct timer_wheel_entry *e)
+{
+  e->next = NULL;
+  e->pprev = NULL;
+}
+/*---------------------------------------------------------------------------*/
+void
+timer_wheel_set(struct timer_wheel *w, struct timer_wheel_entry *e,
+                unsigned long interval, void (*f)(void *), void *ptr)
+{
+  timer_wheel_stop(e);
+  e->f = f;
+  e->ptr = ptr;
+  e->expires = clock_seconds() + interval;
+  place(w, e);
+}
+/*---------------------------------------------------------------------------*/
+void
+timer_wheel_stop(struct timer_wheel_entry *e)
+{
+  if(e->pprev != NULL) {
+    entry_unlink(e);
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+timer_wheel_pending(const struct timer_wheel_entry *e)
+{
+  return e->pprev != NULL;
+}
+/*---------------------------------------------------------------------------*/
+unsigned long
+timer_wheel_remaining(const struct timer_wheel_entry *e)
+{
+  unsigned long left;
+
+  if(e->pprev == NULL) {
+    return 0;
+  }
+  left = e->expires - clock_seconds();
+  return (long)left > 0 ? left : 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+timer_wheel_run(struct timer_wheel *w)
+{
+  struct timer_wheel_entry *expired;
+  struct timer_wheel_entry *e;
+
+  advance(w, clock_seconds());
+
+  /* Entries rescheduled as due by a callback wait for the next run. */
+  list_detach(&w->due, &expired);
+  while((e = expired) != NULL) {
+    entry_unlink(e);
+    e->f(e->ptr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
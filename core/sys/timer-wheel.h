@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ * Hierarchical timer wheel header file.
+ */
+
+/** \addtogroup sys
+ * @{ */
+
+/**
+ * \defgroup timerwheel Hierarchical timer wheel
+ *
+ * The timer wheel keeps a large number of second-granularity timers
+ * sorted into buckets, so that the periodic work needed to find the
+ * expired ones is proportional to the number of timers that actually
+ * expire rather than to the number of timers in use.
+ *
+ * The wheel has two levels of TIMER_WHEEL_SLOTS slots each. The first
+ * level covers the next TIMER_WHEEL_SLOTS seconds with one slot per
+ * second, the second level covers the following TIMER_WHEEL_SLOTS^2
+ * seconds with one slot per TIMER_WHEEL_SLOTS seconds. Timers further
+ * away are kept on an overflow list that is revisited once per turn
+ * of the second level.
+ *
+ * Timers are \c struct \c timer_wheel_entry objects, typically
+ * embedded in the data structure they age. The owner of the wheel
+ * calls timer_wheel_run() regularly, which calls the callback of
+ * every entry that has expired since the previous call.
+ *
+ * \note Like the \ref stimer "Seconds timer library", the timer wheel
+ * uses clock_seconds() to measure time.
+ *
+ * @{
+ */
+
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+#include "contiki-conf.h"
+#include "sys/clock.h"
+
+/* TIMER_WHEEL_SLOT_BITS is the log2 of the number of slots per level */
+#ifdef TIMER_WHEEL_CONF_SLOT_BITS
+#define TIMER_WHEEL_SLOT_BITS TIMER_WHEEL_CONF_SLOT_BITS
+#else
+#define TIMER_WHEEL_SLOT_BITS 4
+#endif
+
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_LEVELS 2
+
+/**
+ * A timer wheel entry.
+ *
+ * An entry must be initialized with timer_wheel_entry_init() before
+ * it is used for the first time.
+ */
+struct timer_wheel_entry {
+  struct timer_wheel_entry *next;
+  struct timer_wheel_entry **pprev;
+  unsigned long expires;
+  void (*f)(void *);
+  void *ptr;
+};
+
+/** A timer wheel. */
+struct timer_wheel {
+  struct timer_wheel_entry *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+  struct timer_wheel_entry *overflow;
+  struct timer_wheel_entry *due;
+  unsigned long now;
+};
+
+/**
+ * \brief Initialize a timer wheel with no pending entries
+ * \param w The timer wheel
+ */
+void timer_wheel_init(struct timer_wheel *w);
+
+/**
+ * \brief Initialize an entry as not pending
+ * \param e The entry
+ */
+void timer_wheel_entry_init(struct timer_wheel_entry *e);
+
+/**
+ * \brief Schedule an entry
+ * \param w The timer wheel
+ * \param e The entry; if it is already pending it is rescheduled
+ * \param interval Seconds from now until the entry expires. An
+ *        interval of zero makes the entry expire on the next call to
+ *        timer_wheel_run().
+ * \param f The function called when the entry expires
+ * \param ptr Opaque argument passed to f
+ */
+void timer_wheel_set(struct timer_wheel *w, struct timer_wheel_entry *e,
+                     unsigned long interval, void (*f)(void *), void *ptr);
+
+/**
+ * \brief Stop an entry. Stopping an entry that is not pending is a no-op.
+ * \param e The entry
+ */
+void timer_wheel_stop(struct timer_wheel_entry *e);
+
+/**
+ * \brief Check if an entry is pending
+ * \param e The entry
+ * \return Non-zero if the entry is scheduled and has not yet expired
+ */
+int timer_wheel_pending(const struct timer_wheel_entry *e);
+
+/**
+ * \brief Get the time until an entry expires
+ * \param e The entry
+ * \return The number of seconds until expiration, 0 if the entry is
+ *         due or not pending
+ */
+unsigned long timer_wheel_remaining(const struct timer_wheel_entry *e);
+
+/**
+ * \brief Advance the wheel to the current time and call the callback
+ *        of every expired entry
+ * \param w The timer wheel
+ *
+ * Callbacks may stop, reschedule or free any entry, including the one
+ * being expired. An entry rescheduled with a zero interval from a
+ * callback expires on the next call.
+ */
+void timer_wheel_run(struct timer_wheel *w);
+
+#endif /* TIMER_WHEEL_H_ */
+
+/** @} */
+/** @} */
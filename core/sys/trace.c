@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Low-overhead event tracing
+ */
+
+#include "contiki.h"
+#include "sys/trace.h"
+
+#if TRACE_ON
+
+#include "lib/lfring.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+/* Number of records in the ring, a power of two. */
+#ifdef TRACE_CONF_SIZE
+#define TRACE_SIZE TRACE_CONF_SIZE
+#else
+#define TRACE_SIZE 256
+#endif
+
+/* How often the trace process drains the ring. */
+#ifdef TRACE_CONF_INTERVAL
+#define TRACE_INTERVAL TRACE_CONF_INTERVAL
+#else
+#define TRACE_INTERVAL CLOCK_SECOND
+#endif
+
+/* If defined, the name of the CFS file to write the trace to instead
+   of the console. */
+#ifdef TRACE_CONF_FILE
+#include "cfs/cfs.h"
+static int fd = -1;
+#endif /* TRACE_CONF_FILE */
+
+/* With compare-and-swap, events can be traced from interrupts and
+   threads too; otherwise only from one context. */
+#if LFRING_MP_SUPPORTED
+LFRING_MP(ring, struct trace_record, TRACE_SIZE);
+#else /* LFRING_MP_SUPPORTED */
+LFRING(ring, struct trace_record, TRACE_SIZE);
+#endif /* LFRING_MP_SUPPORTED */
+
+/* Number of records dropped because the ring was full. Not updated
+   atomically, so it may be slightly low. */
+static unsigned long lost, lost_reported;
+
+static char outbuf[256];
+static int outlen;
+
+static const char *const names[] = {
+  "NONE",
+  "PROCESS_BEGIN",
+  "PROCESS_END",
+  "MAC_INPUT",
+  "MAC_OUTPUT",
+  "SICSLOWPAN_INPUT_BEGIN",
+  "SICSLOWPAN_INPUT_END",
+  "SICSLOWPAN_OUTPUT_BEGIN",
+  "SICSLOWPAN_OUTPUT_END",
+  "UIP_INPUT_BEGIN",
+  "UIP_INPUT_END",
+  "UIP_OUTPUT",
+  "TUNNEL_ENCAP",
+  "TUNNEL_DECAP",
+};
+
+PROCESS(trace_process, "Trace");
+/*---------------------------------------------------------------------------*/
+void
+trace_event(uint16_t id, uint16_t a, uint32_t b, uint32_t c)
+{
+  struct trace_record r;
+
+  r.time = RTIMER_NOW();
+  r.id = id;
+  r.a = a;
+  r.b = b;
+  r.c = c;
+#if LFRING_MP_SUPPORTED
+  if(!lfring_mp_put(&ring, &r)) {
+#else /* LFRING_MP_SUPPORTED */
+  if(!lfring_put(&ring, &r)) {
+#endif /* LFRING_MP_SUPPORTED */
+    lost++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+flush(void)
+{
+  if(outlen == 0) {
+    return;
+  }
+#ifdef TRACE_CONF_FILE
+  if(fd >= 0) {
+    cfs_write(fd, outbuf, outlen);
+  }
+#else /* TRACE_CONF_FILE */
+  outbuf[outlen] = '\0';
+  printf("%s", outbuf);
+#endif /* TRACE_CONF_FILE */
+  outlen = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+output(const char *fmt, ...)
+{
+  va_list ap;
+  int len;
+
+  /* Lines are short, so flush while there is room for a full one. */
+  if(outlen > (int)sizeof(outbuf) - 96) {
+    flush();
+  }
+  va_start(ap, fmt);
+  len = vsnprintf(&outbuf[outlen], sizeof(outbuf) - outlen, fmt, ap);
+  va_end(ap);
+  if(len > 0) {
+    outlen += len;
+    if(outlen >= (int)sizeof(outbuf)) {
+      /* Truncated */
+      outlen = sizeof(outbuf) - 1;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static const char *
+process_name(uint32_t ptr)
+{
+  struct process *p;
+
+  for(p = process_list; p != NULL; p = p->next) {
+    if(TRACE_PTR(p) == ptr) {
+      return PROCESS_NAME_STRING(p);
+    }
+  }
+  return "";
+}
+/*---------------------------------------------------------------------------*/
+static void
+output_record(const struct trace_record *r)
+{
+  /* Lines are "TRACE <time> <event> <a> <b> <c>", followed by the
+     name of the process for process events. */
+  if(r->id < sizeof(names) / sizeof(names[0])) {
+    output("TRACE %lu %s", (unsigned long)r->time, names[r->id]);
+  } else {
+    output("TRACE %lu %u", (unsigned long)r->time, r->id);
+  }
+  if(r->id == TRACE_PROCESS_BEGIN || r->id == TRACE_PROCESS_END) {
+    output(" %u %lx %lx %s\n", r->a, (unsigned long)r->b,
+           (unsigned long)r->c, process_name(r->b));
+  } else {
+    output(" %u %lx %lx\n", r->a, (unsigned long)r->b,
+           (unsigned long)r->c);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+trace_drain(void)
+{
+  struct trace_record *r;
+
+  while((r = lfring_peek_get(&ring)) != NULL) {
+    output_record(r);
+    lfring_commit_get(&ring);
+  }
+  if(lost != lost_reported) {
+    lost_reported = lost;
+    output("TRACE-LOST %lu\n", lost_reported);
+  }
+  flush();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(trace_process, ev, data)
+{
+  static struct etimer et;
+
+  PROCESS_BEGIN();
+
+  etimer_set(&et, TRACE_INTERVAL);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    etimer_reset(&et);
+    trace_drain();
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+void
+trace_init(void)
+{
+  /* The ring starts out empty, so events traced before this point
+     are kept. */
+#ifdef TRACE_CONF_FILE
+  fd = cfs_open(TRACE_CONF_FILE, CFS_WRITE);
+#endif /* TRACE_CONF_FILE */
+
+  /* Tell the converter how to turn timestamps into time. */
+  output("TRACE-START %lu %u\n", (unsigned long)RTIMER_ARCH_SECOND,
+         (unsigned)(sizeof(rtimer_clock_t) * 8));
+  flush();
+
+  process_start(&trace_process, NULL);
+}
+/*---------------------------------------------------------------------------*/
+#endif /* TRACE_ON */
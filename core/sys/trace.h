@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Low-overhead event tracing
+ *
+ *         Tracepoints store fixed-size binary records (a timestamp, an
+ *         event id and three arguments) in a lock-free ring in RAM.
+ *         The trace process drains the ring as text lines, either to
+ *         the console, which works over serial and SLIP, or to a CFS
+ *         file. tools/trace/trace2chrome.py converts these lines to the
+ *         Chrome trace format, for viewing in chrome://tracing or
+ *         Perfetto.
+ *
+ *         Tracing is enabled with TRACE_CONF_ON; otherwise TRACE()
+ *         compiles to nothing. Events named _BEGIN and _END mark the
+ *         start and end of a span, all others are instants.
+ *         Applications may use their own ids from TRACE_USER on.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "contiki-conf.h"
+#include <stdint.h>
+
+#ifdef TRACE_CONF_ON
+#define TRACE_ON TRACE_CONF_ON
+#else
+#define TRACE_ON 0
+#endif
+
+enum {
+  TRACE_NONE,
+  /* a: event, b: process */
+  TRACE_PROCESS_BEGIN,
+  TRACE_PROCESS_END,
+  /* a: frame or packet length */
+  TRACE_MAC_INPUT,
+  TRACE_MAC_OUTPUT,
+  TRACE_SICSLOWPAN_INPUT_BEGIN,
+  TRACE_SICSLOWPAN_INPUT_END,
+  TRACE_SICSLOWPAN_OUTPUT_BEGIN,
+  TRACE_SICSLOWPAN_OUTPUT_END,
+  TRACE_UIP_INPUT_BEGIN,
+  TRACE_UIP_INPUT_END,
+  TRACE_UIP_OUTPUT,
+  TRACE_TUNNEL_ENCAP,
+  TRACE_TUNNEL_DECAP,
+
+  TRACE_USER = 0x100
+};
+
+struct trace_record {
+  uint32_t time;
+  uint16_t id;
+  uint16_t a;
+  uint32_t b;
+  uint32_t c;
+};
+
+#if TRACE_ON
+/**
+ * \brief Record an event
+ * \param id The event id
+ * \param a, b, c Arguments of the event
+ *
+ *        Takes a few instructions and never blocks. When the ring is
+ *        full, the record is dropped and counted.
+ */
+#define TRACE(id, a, b, c) trace_event(id, a, b, c)
+#else /* TRACE_ON */
+#define TRACE(id, a, b, c)
+#endif /* TRACE_ON */
+
+/** \brief Convert a pointer to a trace argument. */
+#define TRACE_PTR(p) ((uint32_t)(uintptr_t)(p))
+
+void trace_event(uint16_t id, uint16_t a, uint32_t b, uint32_t c);
+
+/**
+ * \brief Start the trace process, which drains the ring.
+ *
+ *        Must be called after process_init(). Events may be traced
+ *        before; they stay in the ring until it is first drained.
+ */
+void trace_init(void);
+
+/**
+ * \brief Write all traced records to the output now.
+ */
+void trace_drain(void);
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         AES-128 driver for the native platform. Uses the AES-NI
+ *         instructions when the host CPU has them, and the software
+ *         driver otherwise.
+ */
+
+#include "contiki.h"
+#include "dev/native-aes-128.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define NATIVE_AES_128_WITH_AESNI 1
+#include <wmmintrin.h>
+#else
+#define NATIVE_AES_128_WITH_AESNI 0
+#endif
+
+#if NATIVE_AES_128_WITH_AESNI
+
+#define AESNI __attribute__((target("aes,sse2")))
+
+/* Expanded keys of the most recently used keys */
+static __m128i key_cache[AES_128_KEY_CACHE_SIZE][11];
+static uint8_t key_cache_used;
+static uint8_t key_cache_next;
+static const __m128i *round_keys = key_cache[0];
+
+/* -1: not checked yet, 0: no AES-NI, 1: AES-NI */
+static int8_t has_aesni = -1;
+/*---------------------------------------------------------------------------*/
+static int
+aesni_available(void)
+{
+  if(has_aesni < 0) {
+    __builtin_cpu_init();
+    has_aesni = __builtin_cpu_supports("aes") ? 1 : 0;
+  }
+  return has_aesni;
+}
+/*---------------------------------------------------------------------------*/
+static inline AESNI __m128i
+expand_step(__m128i key, __m128i keygened)
+{
+  keygened = _mm_shuffle_epi32(keygened, _MM_SHUFFLE(3, 3, 3, 3));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  return _mm_xor_si128(key, keygened);
+}
+#define EXPAND_STEP(k, i, rcon) \
+  k[i] = expand_step(k[i - 1], _mm_aeskeygenassist_si128(k[i - 1], rcon))
+/*---------------------------------------------------------------------------*/
+static AESNI void
+expand_key(__m128i *keys, const uint8_t *key)
+{
+  keys[0] = _mm_loadu_si128((const __m128i *)key);
+  EXPAND_STEP(keys, 1, 0x01);
+  EXPAND_STEP(keys, 2, 0x02);
+  EXPAND_STEP(keys, 3, 0x04);
+  EXPAND_STEP(keys, 4, 0x08);
+  EXPAND_STEP(keys, 5, 0x10);
+  EXPAND_STEP(keys, 6, 0x20);
+  EXPAND_STEP(keys, 7, 0x40);
+  EXPAND_STEP(keys, 8, 0x80);
+  EXPAND_STEP(keys, 9, 0x1b);
+  EXPAND_STEP(keys, 10, 0x36);
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_key(const uint8_t *key)
+{
+  uint8_t i;
+
+  if(!aesni_available()) {
+    aes_128_driver.set_key(key);
+    return;
+  }
+
+  /* The first round key is the key itself */
+  for(i = 0; i < key_cache_used; i++) {
+    if(memcmp(&key_cache[i][0], key, AES_128_KEY_LENGTH) == 0) {
+      round_keys = key_cache[i];
+      return;
+    }
+  }
+
+  i = key_cache_next;
+  key_cache_next = (key_cache_next + 1) % AES_128_KEY_CACHE_SIZE;
+  if(key_cache_used < AES_128_KEY_CACHE_SIZE) {
+    key_cache_used++;
+  }
+  expand_key(key_cache[i], key);
+  round_keys = key_cache[i];
+}
+/*---------------------------------------------------------------------------*/
+static AESNI void
+aesni_encrypt(uint8_t *state)
+{
+  __m128i m;
+  int round;
+
+  m = _mm_xor_si128(_mm_loadu_si128((const __m128i *)state), round_keys[0]);
+  for(round = 1; round < 10; round++) {
+    m = _mm_aesenc_si128(m, round_keys[round]);
+  }
+  m = _mm_aesenclast_si128(m, round_keys[10]);
+  _mm_storeu_si128((__m128i *)state, m);
+}
+/*---------------------------------------------------------------------------*/
+static void
+encrypt(uint8_t *plaintext_and_result)
+{
+  if(has_aesni > 0) {
+    aesni_encrypt(plaintext_and_result);
+  } else {
+    aes_128_driver.encrypt(plaintext_and_result);
+  }
+}
+/*---------------------------------------------------------------------------*/
+const struct aes_128_driver native_aes_128_driver = {
+  set_key,
+  encrypt
+};
+#else /* NATIVE_AES_128_WITH_AESNI */
+/*---------------------------------------------------------------------------*/
+static void
+set_key(const uint8_t *key)
+{
+  aes_128_driver.set_key(key);
+}
+/*---------------------------------------------------------------------------*/
+static void
+encrypt(uint8_t *plaintext_and_result)
+{
+  aes_128_driver.encrypt(plaintext_and_result);
+}
+/*---------------------------------------------------------------------------*/
+const struct aes_128_driver native_aes_128_driver = {
+  set_key,
+  encrypt
+};
+#endif /* NATIVE_AES_128_WITH_AESNI */
+/*---------------------------------------------------------------------------*/
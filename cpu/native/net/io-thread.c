@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Worker threads for blocking device I/O on the native platform.
+ */
+
+#include "contiki.h"
+#include "lib/list.h"
+#include "io-thread.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEBUG 0
+#if DEBUG
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
+
+LIST(rx_list);
+
+/* Written by the worker threads to wake up the main thread. */
+static int wakeup[2] = { -1, -1 };
+
+PROCESS(io_thread_process, "I/O threads");
+/*---------------------------------------------------------------------------*/
+static void
+queue_init(struct io_thread_queue *q)
+{
+  lfring_setup(&q->ring, q->packets, sizeof(struct io_thread_packet),
+               IO_THREAD_QUEUE_LEN, NULL);
+  q->dropped = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+notify(int fd)
+{
+  char c = 0;
+
+  if(write(fd, &c, 1) < 0) {
+    /* The pipe is full, so a wakeup is pending anyway. */
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Create a worker thread with all signals blocked, so that they keep
+   being delivered to the main thread. */
+static int
+start_thread(pthread_t *thread, void *(*fn)(void *), void *arg)
+{
+  sigset_t all, old;
+  int ret;
+
+  sigfillset(&all);
+  pthread_sigmask(SIG_BLOCK, &all, &old);
+  ret = pthread_create(thread, NULL, fn, arg);
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+  if(ret != 0) {
+    fprintf(stderr, "io-thread: pthread_create: %s\n", strerror(ret));
+    return -1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void *
+rx_thread(void *arg)
+{
+  struct io_thread_rx *rx = arg;
+  struct io_thread_packet *p;
+  uint8_t scratch[IO_THREAD_MTU];
+  int len;
+
+  while(1) {
+    /* When the ring is full the packet is still read, so that the
+       device does not back up, but then dropped. */
+    p = lfring_peek_put(&rx->queue.ring);
+    len = rx->read(rx->fd, p != NULL ? p->data : scratch, IO_THREAD_MTU);
+    if(len < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      perror("io-thread: read");
+      break;
+    }
+    if(len == 0) {
+      continue;
+    }
+    if(p == NULL) {
+      rx->queue.dropped++;
+      continue;
+    }
+    p->len = len;
+    lfring_commit_put(&rx->queue.ring);
+    notify(wakeup[1]);
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void *
+tx_thread(void *arg)
+{
+  struct io_thread_tx *tx = arg;
+  struct io_thread_packet *p;
+  char c;
+
+  while(1) {
+    while((p = lfring_peek_get(&tx->queue.ring)) != NULL) {
+      if(tx->write(tx->fd, p->data, p->len) < 0) {
+        perror("io-thread: write");
+      }
+      lfring_commit_get(&tx->queue.ring);
+    }
+    if(read(tx->wakeup[0], &c, 1) < 0 && errno != EINTR) {
+      perror("io-thread: wakeup");
+      break;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static int
+set_fd(fd_set *rset, fd_set *wset)
+{
+  FD_SET(wakeup[0], rset);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_fd(fd_set *rset, fd_set *wset)
+{
+  char buf[32];
+
+  if(FD_ISSET(wakeup[0], rset)) {
+    while(read(wakeup[0], buf, sizeof(buf)) > 0);
+    process_poll(&io_thread_process);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static const struct select_callback wakeup_callback = { set_fd, handle_fd };
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(io_thread_process, ev, data)
+{
+  struct io_thread_rx *rx;
+  struct io_thread_packet *p;
+
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
+
+    for(rx = list_head(rx_list); rx != NULL; rx = rx->next) {
+      while((p = lfring_peek_get(&rx->queue.ring)) != NULL) {
+        if(rx->input(rx, p->data, p->len)) {
+          /* The driver is not ready for it; try again later. */
+          process_poll(&io_thread_process);
+          break;
+        }
+        lfring_commit_get(&rx->queue.ring);
+      }
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+static int
+open_pipe(int fds[2], int nonblock_read)
+{
+  if(pipe(fds) < 0) {
+    perror("io-thread: pipe");
+    return -1;
+  }
+  if(nonblock_read) {
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+  }
+  fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+io_thread_rx_start(struct io_thread_rx *rx)
+{
+  if(wakeup[0] < 0) {
+    if(open_pipe(wakeup, 1) < 0) {
+      return -1;
+    }
+    select_set_callback(wakeup[0], &wakeup_callback);
+    process_start(&io_thread_process, NULL);
+  }
+
+  queue_init(&rx->queue);
+  list_add(rx_list, rx);
+
+  if(start_thread(&rx->thread, rx_thread, rx) < 0) {
+    list_remove(rx_list, rx);
+    return -1;
+  }
+  PRINTF("io-thread: reading fd %d\n", rx->fd);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+io_thread_tx_start(struct io_thread_tx *tx)
+{
+  queue_init(&tx->queue);
+
+  if(open_pipe(tx->wakeup, 0) < 0) {
+    return -1;
+  }
+  if(start_thread(&tx->thread, tx_thread, tx) < 0) {
+    close(tx->wakeup[0]);
+    close(tx->wakeup[1]);
+    return -1;
+  }
+  PRINTF("io-thread: writing fd %d\n", tx->fd);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+io_thread_send(struct io_thread_tx *tx, const uint8_t *data, int len)
+{
+  struct io_thread_packet *p;
+
+  p = lfring_peek_put(&tx->queue.ring);
+  if(p == NULL || len > IO_THREAD_MTU) {
+    tx->queue.dropped++;
+    return -1;
+  }
+  memcpy(p->data, data, len);
+  p->len = len;
+  lfring_commit_put(&tx->queue.ring);
+  notify(tx->wakeup[1]);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
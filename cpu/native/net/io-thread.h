@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Worker threads for blocking device I/O on the native platform.
+ *
+ *         The Contiki kernel, uIP and the packet buffer are shared by all
+ *         processes and must only be touched from the main thread. What
+ *         can run elsewhere is the blocking read() and write() on the
+ *         devices: each io_thread_rx reads one file descriptor on its own
+ *         thread and hands the packets to the main thread through a
+ *         single-producer, single-consumer ring, and each io_thread_tx
+ *         writes the packets queued by the main thread from its own ring.
+ *
+ *         Enabled with NATIVE_CONF_IO_THREADS; drivers fall back to their
+ *         select() callbacks otherwise.
+ */
+
+#ifndef IO_THREAD_H_
+#define IO_THREAD_H_
+
+#include "contiki.h"
+#include "lib/lfring.h"
+
+#include <pthread.h>
+
+#ifdef NATIVE_CONF_IO_THREADS
+#define NATIVE_IO_THREADS NATIVE_CONF_IO_THREADS
+#else
+#define NATIVE_IO_THREADS 0
+#endif
+
+/* Number of packets in each ring, a power of two. */
+#ifdef IO_THREAD_CONF_QUEUE_LEN
+#define IO_THREAD_QUEUE_LEN IO_THREAD_CONF_QUEUE_LEN
+#else
+#define IO_THREAD_QUEUE_LEN 32
+#endif
+
+/* Largest packet that fits in a ring slot. */
+#ifdef IO_THREAD_CONF_MTU
+#define IO_THREAD_MTU IO_THREAD_CONF_MTU
+#else
+#define IO_THREAD_MTU 2048
+#endif
+
+struct io_thread_packet {
+  int len;
+  uint8_t data[IO_THREAD_MTU];
+};
+
+struct io_thread_queue {
+  struct lfring ring;
+  struct io_thread_packet packets[IO_THREAD_QUEUE_LEN];
+  /* Packets dropped because the ring was full. */
+  unsigned long dropped;
+};
+
+struct io_thread_rx {
+  struct io_thread_rx *next;
+  int fd;
+  /* Called on the worker thread; reads one packet, returns its length,
+     0 to skip, or -1 on error, which stops the thread. */
+  int (* read)(int fd, uint8_t *buf, int maxlen);
+  /* Called on the main thread for each received packet. Returns 0 once
+     the packet is consumed, or non-zero to keep it queued and be
+     called again later. */
+  int (* input)(struct io_thread_rx *rx, uint8_t *data, int len);
+  struct io_thread_queue queue;
+  pthread_t thread;
+};
+
+struct io_thread_tx {
+  int fd;
+  /* Called on the worker thread; writes one packet. */
+  int (* write)(int fd, const uint8_t *buf, int len);
+  struct io_thread_queue queue;
+  int wakeup[2];
+  pthread_t thread;
+};
+
+/**
+ * Start reading rx->fd on a new thread. fd, read and input must be set.
+ * \return 0 on success, -1 on error.
+ */
+int io_thread_rx_start(struct io_thread_rx *rx);
+
+/**
+ * Start a writer thread for tx->fd. fd and write must be set.
+ * \return 0 on success, -1 on error.
+ */
+int io_thread_tx_start(struct io_thread_tx *tx);
+
+/**
+ * Queue a packet for the writer thread. Called from the main thread.
+ * \return 0 if queued, -1 if the ring was full or the packet too large.
+ */
+int io_thread_send(struct io_thread_tx *tx, const uint8_t *data, int len);
+
+#endif /* IO_THREAD_H_ */
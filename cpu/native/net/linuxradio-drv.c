@@ -56,6 +56,8 @@
 #include <net/if.h>
 #include <linux/sockios.h>
 
+#include "io-thread.h"
+
 #define DEBUG 0
 #if DEBUG
 #include <stdio.h>
@@ -64,15 +66,56 @@
 #define PRINTF(...)
 #endif
 
-static int sockfd = -1;
+/* Interfaces to bind, e.g. { "wpan0", "wpan1" }, and the channel each
+   of them has been configured on (with iwpan) by the host. Every
+   interface is received from in parallel; the channel of the interface
+   a frame arrived on is passed up in PACKETBUF_ATTR_CHANNEL. */
+#ifdef LINUXRADIO_CONF_DEVS
+#define LINUXRADIO_DEVS LINUXRADIO_CONF_DEVS
+#else
+#define LINUXRADIO_DEVS { NETSTACK_CONF_LINUXRADIO_DEV }
+#endif
+
+#ifdef LINUXRADIO_CONF_CHANNELS
+#define LINUXRADIO_CHANNELS LINUXRADIO_CONF_CHANNELS
+#else
+#define LINUXRADIO_CHANNELS { 26 }
+#endif
+
+static const char *const devs[] = LINUXRADIO_DEVS;
+static const uint8_t channels[] = LINUXRADIO_CHANNELS;
+
+#define NUM_INSTANCES ((int)(sizeof(devs) / sizeof(devs[0])))
+
+/* Compile-time check that the two lists have the same length */
+typedef char linuxradio_channels_match_devs[
+  sizeof(channels) == sizeof(devs) / sizeof(devs[0]) ? 1 : -1];
+
+static int sockfd[NUM_INSTANCES];
+/* The instance that transmissions go out on, see RADIO_PARAM_CHANNEL */
+static int tx_instance;
 static char *sockbuf;
 static int buflen;
 
+#if NATIVE_IO_THREADS
+/* Each socket is read on its own thread; frames are handed to the
+   main thread through the io-thread rings. The sockets stay open while
+   the radio is off, and received frames are dropped instead. */
+static struct io_thread_rx rx[NUM_INSTANCES];
+static int radio_on;
+#endif /* NATIVE_IO_THREADS */
+
 #define MAX_PACKET_SIZE 256
 
 static int
 init(void)
 {
+  int i;
+
+  for(i = 0; i < NUM_INSTANCES; i++) {
+    sockfd[i] = -1;
+  }
+  tx_instance = 0;
   sockbuf = malloc(MAX_PACKET_SIZE);
   if(sockbuf == 0) {
     return 1;
@@ -94,7 +137,7 @@ static int
 transmit(unsigned short transmit_len)
 {
   int sent = 0;
-  sent = send(sockfd, sockbuf, buflen, 0);
+  sent = send(sockfd[tx_instance], sockbuf, buflen, 0);
   if(sent < 0) {
     perror("linuxradio send()");
     return RADIO_TX_ERR;
@@ -135,64 +178,245 @@ pending_packet(void)
 {
   return 0;
 }
+/* Pass a frame received on instance i up the stack. */
+static void
+deliver(int i, const void *data, int len)
+{
+  if(len <= 0 || len > PACKETBUF_SIZE) {
+    PRINTF("linuxradio: dropping frame of %d bytes on %s\n", len, devs[i]);
+    return;
+  }
+  packetbuf_clear();
+  memcpy(packetbuf_dataptr(), data, len);
+  packetbuf_set_datalen(len);
+  packetbuf_set_attr(PACKETBUF_ATTR_CHANNEL, channels[i]);
+  NETSTACK_RDC.input();
+}
+#if NATIVE_IO_THREADS
+static int
+sock_read(int fd, uint8_t *buf, int maxlen)
+{
+  return read(fd, buf, maxlen);
+}
+static int
+sock_input(struct io_thread_rx *r, uint8_t *data, int len)
+{
+  if(radio_on) {
+    deliver(r - rx, data, len);
+  }
+  return 0;
+}
+#else /* NATIVE_IO_THREADS */
 static int
 set_fd(fd_set *rset, fd_set *wset)
 {
-  FD_SET(sockfd, rset);
-  return 1;
+  int i;
+  int any = 0;
+
+  for(i = 0; i < NUM_INSTANCES; i++) {
+    if(sockfd[i] >= 0) {
+      FD_SET(sockfd[i], rset);
+      any = 1;
+    }
+  }
+  return any;
 }
 static void
 handle_fd(fd_set *rset, fd_set *wset)
 {
-  if(FD_ISSET(sockfd, rset)) {
-    int bytes = read(sockfd, sockbuf, MAX_PACKET_SIZE);
-    buflen = bytes;
-    memcpy(packetbuf_dataptr(), sockbuf, bytes);
-    packetbuf_set_datalen(bytes);
-    NETSTACK_RDC.input();
+  int i;
+  int bytes;
+
+  /* Serve every interface that has a frame waiting, so that no channel
+     is starved by a busy one */
+  for(i = 0; i < NUM_INSTANCES; i++) {
+    if(sockfd[i] >= 0 && FD_ISSET(sockfd[i], rset)) {
+      bytes = read(sockfd[i], sockbuf, MAX_PACKET_SIZE);
+      deliver(i, sockbuf, bytes);
+    }
   }
 }
 
 static const struct select_callback linuxradio_sock_callback = { set_fd, handle_fd };
 
+/* The main loop calls every registered callback with the full fd set,
+   so a single registration covers all sockets. It is made on the
+   highest descriptor, which keeps the select() maxfd right. */
+static void
+register_callback(void)
+{
+  int i;
+  int maxfd = -1;
+
+  for(i = 0; i < NUM_INSTANCES; i++) {
+    if(sockfd[i] > maxfd) {
+      maxfd = sockfd[i];
+    }
+  }
+  for(i = 0; i < NUM_INSTANCES; i++) {
+    if(sockfd[i] >= 0 && sockfd[i] != maxfd) {
+      select_set_callback(sockfd[i], NULL);
+    }
+  }
+  if(maxfd >= 0) {
+    select_set_callback(maxfd, &linuxradio_sock_callback);
+  }
+}
+#endif /* NATIVE_IO_THREADS */
 static int
-on(void)
+open_instance(int i)
 {
   struct ifreq ifr;
   int err;
   struct sockaddr_ll sll;
+  int fd;
 
-  sockfd = socket(PF_PACKET, SOCK_RAW, htons(ETH_P_IEEE802154));
-  if(sockfd < 0) {
+  fd = socket(PF_PACKET, SOCK_RAW, htons(ETH_P_IEEE802154));
+  if(fd < 0) {
     perror("linuxradio socket()");
-    return 0;
-  } else {
-    strncpy((char *)ifr.ifr_name, NETSTACK_CONF_LINUXRADIO_DEV, IFNAMSIZ);
-    err = ioctl(sockfd, SIOCGIFINDEX, &ifr);
-    if(err == -1) {
-      perror("linuxradio ioctl()");
-      return 0;
-    }
-    sll.sll_family = AF_PACKET;
-    sll.sll_ifindex = ifr.ifr_ifindex;
-    sll.sll_protocol = htons(ETH_P_IEEE802154);
+    return -1;
+  }
+  memset(&ifr, 0, sizeof(ifr));
+  strncpy((char *)ifr.ifr_name, devs[i], IFNAMSIZ - 1);
+  err = ioctl(fd, SIOCGIFINDEX, &ifr);
+  if(err == -1) {
+    perror("linuxradio ioctl()");
+    close(fd);
+    return -1;
+  }
+  memset(&sll, 0, sizeof(sll));
+  sll.sll_family = AF_PACKET;
+  sll.sll_ifindex = ifr.ifr_ifindex;
+  sll.sll_protocol = htons(ETH_P_IEEE802154);
 
-    if(bind(sockfd, (struct sockaddr *)&sll, sizeof(sll)) < 0) {
-      perror("linuxradio bind()");
-      return 0;
-    }
+  if(bind(fd, (struct sockaddr *)&sll, sizeof(sll)) < 0) {
+    perror("linuxradio bind()");
+    close(fd);
+    return -1;
+  }
+  PRINTF("linuxradio: %s on channel %u\n", devs[i], channels[i]);
+  return fd;
+}
+static int
+on(void)
+{
+  int i;
+  int opened = 0;
 
-    select_set_callback(sockfd, &linuxradio_sock_callback);
-    return 1;
+  for(i = 0; i < NUM_INSTANCES; i++) {
+    if(sockfd[i] < 0) {
+      sockfd[i] = open_instance(i);
+#if NATIVE_IO_THREADS
+      if(sockfd[i] >= 0) {
+        rx[i].fd = sockfd[i];
+        rx[i].read = sock_read;
+        rx[i].input = sock_input;
+        if(io_thread_rx_start(&rx[i]) < 0) {
+          close(sockfd[i]);
+          sockfd[i] = -1;
+        }
+      }
+#endif /* NATIVE_IO_THREADS */
+    }
+    if(sockfd[i] >= 0) {
+      opened++;
+    }
   }
+  if(opened == 0) {
+    return 0;
+  }
+  if(sockfd[tx_instance] < 0) {
+    /* Fall back to the first interface that could be opened */
+    for(i = 0; i < NUM_INSTANCES && sockfd[i] < 0; i++);
+    tx_instance = i;
+  }
+#if NATIVE_IO_THREADS
+  radio_on = 1;
+#else /* NATIVE_IO_THREADS */
+  register_callback();
+#endif /* NATIVE_IO_THREADS */
+  return 1;
 }
 static int
 off(void)
 {
-  close(sockfd);
-  sockfd = -1;
+#if NATIVE_IO_THREADS
+  radio_on = 0;
+#else /* NATIVE_IO_THREADS */
+  int i;
+
+  for(i = 0; i < NUM_INSTANCES; i++) {
+    if(sockfd[i] >= 0) {
+      select_set_callback(sockfd[i], NULL);
+      close(sockfd[i]);
+      sockfd[i] = -1;
+    }
+  }
+#endif /* NATIVE_IO_THREADS */
   return 1;
 }
+static radio_result_t
+get_value(radio_param_t param, radio_value_t *value)
+{
+  int i;
+
+  if(value == NULL) {
+    return RADIO_RESULT_INVALID_VALUE;
+  }
+  switch(param) {
+  case RADIO_PARAM_CHANNEL:
+    *value = channels[tx_instance];
+    return RADIO_RESULT_OK;
+  case RADIO_CONST_CHANNEL_MIN:
+    *value = channels[0];
+    for(i = 1; i < NUM_INSTANCES; i++) {
+      if(channels[i] < *value) {
+        *value = channels[i];
+      }
+    }
+    return RADIO_RESULT_OK;
+  case RADIO_CONST_CHANNEL_MAX:
+    *value = channels[0];
+    for(i = 1; i < NUM_INSTANCES; i++) {
+      if(channels[i] > *value) {
+        *value = channels[i];
+      }
+    }
+    return RADIO_RESULT_OK;
+  default:
+    return RADIO_RESULT_NOT_SUPPORTED;
+  }
+}
+static radio_result_t
+set_value(radio_param_t param, radio_value_t value)
+{
+  int i;
+
+  switch(param) {
+  case RADIO_PARAM_CHANNEL:
+    /* Reception is always on all channels; setting the channel only
+       selects the interface that transmissions go out on */
+    for(i = 0; i < NUM_INSTANCES; i++) {
+      if(channels[i] == value) {
+        tx_instance = i;
+        return RADIO_RESULT_OK;
+      }
+    }
+    return RADIO_RESULT_INVALID_VALUE;
+  default:
+    return RADIO_RESULT_NOT_SUPPORTED;
+  }
+}
+static radio_result_t
+get_object(radio_param_t param, void *dest, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+static radio_result_t
+set_object(radio_param_t param, const void *src, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
 const struct radio_driver linuxradio_driver =
 {
   init,
@@ -205,6 +429,10 @@ const struct radio_driver linuxradio_driver =
   pending_packet,
   on,
   off,
+  get_value,
+  set_value,
+  get_object,
+  set_object
 };
 
 #endif
@@ -38,6 +38,19 @@
 
 #include "dev/radio.h"
 
+/*
+ * The driver can bind several 802.15.4 interfaces at once, each of them
+ * set up by the host on its own channel:
+ *
+ *   #define LINUXRADIO_CONF_DEVS     { "wpan0", "wpan1", "wpan2" }
+ *   #define LINUXRADIO_CONF_CHANNELS { 15, 20, 25 }
+ *
+ * Frames are received on all interfaces in parallel and tagged with the
+ * channel they arrived on in PACKETBUF_ATTR_CHANNEL. Setting
+ * RADIO_PARAM_CHANNEL selects the interface used for transmission.
+ * Without these, NETSTACK_CONF_LINUXRADIO_DEV is used on channel 26.
+ */
+
 extern const struct radio_driver linuxradio_driver;
 
 #endif
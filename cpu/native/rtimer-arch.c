@@ -42,24 +42,57 @@
 #include <sys/time.h>
 #endif /* !_WIN32 */
 #include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif /* __linux__ */
 
 #include "sys/rtimer.h"
 #include "sys/clock.h"
 
 #define DEBUG 0
 #if DEBUG
-#include <stdio.h>
 #define PRINTF(...) printf(__VA_ARGS__)
 #else
 #define PRINTF(...)
 #endif
 
+/*
+ * With NATIVE_CONF_RTIMER_SPIN set, the timer signal is requested that
+ * many microseconds early and the handler busy-waits for the deadline,
+ * which hides most of the signal delivery latency at the cost of CPU.
+ */
+#ifdef NATIVE_CONF_RTIMER_SPIN
+#define RTIMER_SPIN NATIVE_CONF_RTIMER_SPIN
+#else
+#define RTIMER_SPIN 0
+#endif
+
+#if RTIMER_SPIN
+static rtimer_clock_t deadline;
+#endif /* RTIMER_SPIN */
+
+/* Set while rtimer callbacks run in the signal handler. */
+volatile int rtimer_arch_in_interrupt;
+
+#ifdef __linux__
+/* A POSIX timer on CLOCK_MONOTONIC, set to absolute deadlines so that
+   the time spent computing the delay is not added to it. */
+static timer_t timer;
+#endif /* __linux__ */
+
 /*---------------------------------------------------------------------------*/
 static void
 interrupt(int sig)
 {
   signal(sig, interrupt);
+#if RTIMER_SPIN
+  while(RTIMER_CLOCK_LT(rtimer_arch_now(), deadline));
+#endif /* RTIMER_SPIN */
+  rtimer_arch_in_interrupt = 1;
   rtimer_run_next();
+  rtimer_arch_in_interrupt = 0;
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -68,22 +101,90 @@ rtimer_arch_init(void)
 #ifndef _WIN32
   signal(SIGALRM, interrupt);
 #endif /* !_WIN32 */
+#ifdef __linux__
+  {
+    struct sigevent sev;
+
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = SIGALRM;
+    sev.sigev_value.sival_ptr = NULL;
+    if(timer_create(CLOCK_MONOTONIC, &sev, &timer) < 0) {
+      perror("rtimer: timer_create");
+    }
+    /* The default timer slack of 50 us would dominate the accuracy. */
+    prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0);
+  }
+#endif /* __linux__ */
+}
+/*---------------------------------------------------------------------------*/
+rtimer_clock_t
+rtimer_arch_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (rtimer_clock_t)((uint64_t)ts.tv_sec * RTIMER_ARCH_SECOND +
+                          ts.tv_nsec / (1000000000L / RTIMER_ARCH_SECOND));
 }
 /*---------------------------------------------------------------------------*/
 void
 rtimer_arch_schedule(rtimer_clock_t t)
 {
-#ifndef _WIN32
+#ifdef __linux__
+  struct itimerspec its;
+  struct timespec now;
+  int32_t c;
+  uint64_t ns;
+
+#if RTIMER_SPIN
+  deadline = t;
+  t -= RTIMER_SPIN;
+#endif /* RTIMER_SPIN */
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  c = RTIMER_CLOCK_DIFF(t, (rtimer_clock_t)((uint64_t)now.tv_sec *
+                        RTIMER_ARCH_SECOND + now.tv_nsec /
+                        (1000000000L / RTIMER_ARCH_SECOND)));
+  if(c < 0) {
+    c = 0;
+  }
+
+  /* Deadline: now, rounded down to the tick, plus c ticks. A zero
+     value would disarm the timer, so fire as soon as possible. */
+  ns = (uint64_t)now.tv_sec * 1000000000L +
+    now.tv_nsec - now.tv_nsec % (1000000000L / RTIMER_ARCH_SECOND) +
+    (uint64_t)c * (1000000000L / RTIMER_ARCH_SECOND);
+  its.it_value.tv_sec = ns / 1000000000L;
+  its.it_value.tv_nsec = ns % 1000000000L;
+  if(its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0) {
+    its.it_value.tv_nsec = 1;
+  }
+  its.it_interval.tv_sec = its.it_interval.tv_nsec = 0;
+
+  PRINTF("rtimer_arch_schedule time %lu in %ld us\n",
+         (unsigned long)t, (long)c);
+
+  timer_settime(timer, TIMER_ABSTIME, &its, NULL);
+#elif !defined(_WIN32)
   struct itimerval val;
-  rtimer_clock_t c;
+  int32_t c;
+
+#if RTIMER_SPIN
+  deadline = t;
+  t -= RTIMER_SPIN;
+#endif /* RTIMER_SPIN */
+
+  c = RTIMER_CLOCK_DIFF(t, rtimer_arch_now());
+  if(c <= 0) {
+    c = 1;
+  }
 
-  c = t - (unsigned short)clock_time();
-  
-  val.it_value.tv_sec = c / 1000;
-  val.it_value.tv_usec = (c % 1000) * 1000;
+  val.it_value.tv_sec = c / RTIMER_ARCH_SECOND;
+  val.it_value.tv_usec = (c % RTIMER_ARCH_SECOND) *
+    (1000000L / RTIMER_ARCH_SECOND);
 
-  PRINTF("rtimer_arch_schedule time %u %u in %d.%d seconds\n", t, c, c / 1000,
-	 (c % 1000) * 1000);
+  PRINTF("rtimer_arch_schedule time %lu in %ld us\n",
+         (unsigned long)t, (long)c);
 
   val.it_interval.tv_sec = val.it_interval.tv_usec = 0;
   setitimer(ITIMER_REAL, &val, NULL);
@@ -42,8 +42,13 @@
 
 #include "contiki-conf.h"
 
-#define RTIMER_ARCH_SECOND CLOCK_CONF_SECOND
+/* The native rtimer runs on CLOCK_MONOTONIC in microseconds. */
+#define RTIMER_ARCH_SECOND 1000000
 
-#define rtimer_arch_now() clock_time()
+rtimer_clock_t rtimer_arch_now(void);
+
+#define US_TO_RTIMERTICKS(US)  ((int32_t)(US))
+#define RTIMERTICKS_TO_US(T)   ((int32_t)(T))
+#define RTIMERTICKS_TO_US_64(T) ((uint32_t)(T))
 
 #endif /* RTIMER_ARCH_H_ */
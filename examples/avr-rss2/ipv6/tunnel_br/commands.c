@@ -214,8 +214,8 @@ show_routes(void)
     } else {
       printf("NULL");
     }
-    if(r->state.lifetime < 600) {
-      printf(" %ld s\n", r->state.lifetime);
+    if(uip_ds6_route_get_lifetime(r) < 600) {
+      printf(" %ld s\n", uip_ds6_route_get_lifetime(r));
     } else {
       printf(" >600 s\n");
     }
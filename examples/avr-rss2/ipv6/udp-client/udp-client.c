@@ -255,7 +255,7 @@ if(etimer_expired(&periodic)) {
           /* PRINT6ADDR(&r->ipaddr); */
           /* PRINTF(" -> "); */
           /* PRINT6ADDR(nexthop); */
-          PRINTF(" lt:%lu\n", r->state.lifetime);
+          PRINTF(" lt:%lu\n", uip_ds6_route_get_lifetime(r));
 
         }
       }
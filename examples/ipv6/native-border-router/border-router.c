@@ -173,8 +173,8 @@ PT_THREAD(generate_routes(struct httpd_state *s))
     ipaddr_add(&r->ipaddr);
     ADD("/%u (via ", r->length);
     ipaddr_add(uip_ds6_route_nexthop(r));
-    if(r->state.lifetime < 600) {
-      ADD(") %lus\n", (unsigned long)r->state.lifetime);
+    if(uip_ds6_route_get_lifetime(r) < 600) {
+      ADD(") %lus\n", (unsigned long)uip_ds6_route_get_lifetime(r));
     } else {
       ADD(")\n");
     }
@@ -55,6 +55,10 @@
 #include "net/packetbuf.h"
 #include "cmd.h"
 #include "border-router-cmds.h"
+#include "io-thread.h"
+#if NATIVE_IO_THREADS
+#include <poll.h>
+#endif /* NATIVE_IO_THREADS */
 
 extern int slip_config_verbose;
 extern int slip_config_flowcontrol;
@@ -169,6 +173,48 @@ slip_packet_input(unsigned char *data, int len)
   NETSTACK_RDC.input();
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Handle a complete SLIP frame: a command or debug output from the
+ * radio, or a packet.
+ */
+static void
+slip_frame_input(unsigned char *inbuf, int inbufptr)
+{
+  int i;
+
+  if(inbuf[0] == '!') {
+    command_context = CMD_CONTEXT_RADIO;
+    cmd_input(inbuf, inbufptr);
+  } else if(inbuf[0] == '?') {
+#define DEBUG_LINE_MARKER '\r'
+  } else if(inbuf[0] == DEBUG_LINE_MARKER) {
+    fwrite(inbuf + 1, inbufptr - 1, 1, stdout);
+  } else if(is_sensible_string(inbuf, inbufptr)) {
+    if(slip_config_verbose == 1) {   /* strings already echoed below for verbose>1 */
+      fwrite(inbuf, inbufptr, 1, stdout);
+    }
+  } else {
+    if(slip_config_verbose > 2) {
+      printf("Packet from SLIP of length %d - write TUN\n", inbufptr);
+      if(slip_config_verbose > 4) {
+#if WIRESHARK_IMPORT_FORMAT
+        printf("0000");
+        for(i = 0; i < inbufptr; i++) printf(" %02x", inbuf[i]);
+#else
+        printf("         ");
+        for(i = 0; i < inbufptr; i++) {
+          printf("%02x", inbuf[i]);
+          if((i & 3) == 3) printf(" ");
+          if((i & 15) == 15) printf("\n         ");
+        }
+#endif
+        printf("\n");
+      }
+    }
+    slip_packet_input(inbuf, inbufptr);
+  }
+}
+/*---------------------------------------------------------------------------*/
 /*
  * Read from serial, when we have a packet call slip_packet_input. No output
  * buffering, input buffered by stdio.
@@ -178,7 +224,7 @@ serial_input(FILE *inslip)
 {
   static unsigned char inbuf[2048];
   static int inbufptr = 0;
-  int ret,i;
+  int ret;
   unsigned char c;
 
 #ifdef linux
@@ -207,37 +253,7 @@ serial_input(FILE *inslip)
   switch(c) {
   case SLIP_END:
     if(inbufptr > 0) {
-      if(inbuf[0] == '!') {
-	command_context = CMD_CONTEXT_RADIO;
-	cmd_input(inbuf, inbufptr);
-      } else if(inbuf[0] == '?') {
-#define DEBUG_LINE_MARKER '\r'
-      } else if(inbuf[0] == DEBUG_LINE_MARKER) {
-	fwrite(inbuf + 1, inbufptr - 1, 1, stdout);
-      } else if(is_sensible_string(inbuf, inbufptr)) {
-        if(slip_config_verbose == 1) {   /* strings already echoed below for verbose>1 */
-          fwrite(inbuf, inbufptr, 1, stdout);
-        }
-      } else {
-        if(slip_config_verbose > 2) {
-          printf("Packet from SLIP of length %d - write TUN\n", inbufptr);
-          if(slip_config_verbose > 4) {
-#if WIRESHARK_IMPORT_FORMAT
-            printf("0000");
-	    for(i = 0; i < inbufptr; i++) printf(" %02x", inbuf[i]);
-#else
-            printf("         ");
-            for(i = 0; i < inbufptr; i++) {
-              printf("%02x", inbuf[i]);
-              if((i & 3) == 3) printf(" ");
-              if((i & 15) == 15) printf("\n         ");
-            }
-#endif
-            printf("\n");
-          }
-        }
-	slip_packet_input(inbuf, inbufptr);
-      }
+      slip_frame_input(inbuf, inbufptr);
       inbufptr = 0;
     }
     break;
@@ -280,6 +296,87 @@ serial_input(FILE *inslip)
   goto read_more;
 }
 
+#if NATIVE_IO_THREADS
+/*---------------------------------------------------------------------------*/
+/*
+ * With I/O threads, the serial line is read in blocks and decoded on a
+ * reader thread, and only complete frames are handed to the main
+ * thread. The per-character echo of the verbose modes is not done in
+ * this mode.
+ */
+static struct io_thread_rx slip_rx;
+/* Decoder state, only used on the reader thread. */
+static unsigned char rawbuf[512];
+static int rawlen, rawpos;
+static int framelen, frame_esc, frame_dropping;
+
+static int
+slip_read(int fd, uint8_t *buf, int maxlen)
+{
+  struct pollfd pfd;
+  unsigned char c;
+  int len;
+
+  while(1) {
+    if(rawpos == rawlen) {
+      pfd.fd = fd;
+      pfd.events = POLLIN;
+      if(poll(&pfd, 1, -1) < 0) {
+        return -1;
+      }
+      rawlen = read(fd, rawbuf, sizeof(rawbuf));
+      if(rawlen <= 0) {
+        if(rawlen < 0 && (errno == EAGAIN || errno == EINTR)) {
+          rawlen = rawpos = 0;
+          continue;
+        }
+        return -1;
+      }
+      rawpos = 0;
+      slip_received += rawlen;
+    }
+
+    while(rawpos < rawlen) {
+      c = rawbuf[rawpos++];
+      if(frame_esc) {
+        frame_esc = 0;
+        if(c == SLIP_ESC_END) {
+          c = SLIP_END;
+        } else if(c == SLIP_ESC_ESC) {
+          c = SLIP_ESC;
+        }
+      } else if(c == SLIP_ESC) {
+        frame_esc = 1;
+        continue;
+      } else if(c == SLIP_END) {
+        len = frame_dropping ? 0 : framelen;
+        framelen = 0;
+        frame_dropping = 0;
+        if(len > 0) {
+          return len;
+        }
+        continue;
+      }
+      if(framelen >= maxlen) {
+        if(!frame_dropping) {
+          fprintf(stderr, "*** dropping large %d byte packet\n", framelen);
+        }
+        frame_dropping = 1;
+        continue;
+      }
+      buf[framelen++] = c;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+slip_rx_input(struct io_thread_rx *rx, uint8_t *data, int len)
+{
+  slip_frame_input(data, len);
+  return 0;
+}
+#endif /* NATIVE_IO_THREADS */
+/*---------------------------------------------------------------------------*/
 unsigned char slip_buf[2048];
 int slip_end, slip_begin, slip_packet_end, slip_packet_count;
 static struct timer send_delay_timer;
@@ -467,16 +564,20 @@ set_fd(fd_set *rset, fd_set *wset)
     FD_SET(slipfd, wset);
   }
 
+#if !NATIVE_IO_THREADS
   FD_SET(slipfd, rset);	/* Read from slip ASAP! */
+#endif /* !NATIVE_IO_THREADS */
   return 1;
 }
 /*---------------------------------------------------------------------------*/
 static void
 handle_fd(fd_set *rset, fd_set *wset)
 {
+#if !NATIVE_IO_THREADS
   if(FD_ISSET(slipfd, rset)) {
     serial_input(inslip);
   }
+#endif /* !NATIVE_IO_THREADS */
 
   if(FD_ISSET(slipfd, wset)) {
     slip_flushbuf(slipfd);
@@ -542,5 +643,14 @@ slip_init(void)
   if(inslip == NULL) {
     err(1, "main: fdopen");
   }
+
+#if NATIVE_IO_THREADS
+  slip_rx.fd = slipfd;
+  slip_rx.read = slip_read;
+  slip_rx.input = slip_rx_input;
+  if(io_thread_rx_start(&slip_rx) < 0) {
+    errx(1, "slip_init: could not start I/O thread");
+  }
+#endif /* NATIVE_IO_THREADS */
 }
 /*---------------------------------------------------------------------------*/
@@ -64,6 +64,7 @@
 #include "net/packetbuf.h"
 #include "cmd.h"
 #include "border-router.h"
+#include "io-thread.h"
 
 extern const char *slip_config_ipaddr;
 extern char slip_config_tundev[32];
@@ -72,12 +73,14 @@ extern uint16_t slip_config_basedelay;
 #ifndef __CYGWIN__
 static int tunfd;
 
+#if !NATIVE_IO_THREADS
 static int set_fd(fd_set *rset, fd_set *wset);
 static void handle_fd(fd_set *rset, fd_set *wset);
 static const struct select_callback tun_select_callback = {
   set_fd,
   handle_fd
 };
+#endif /* !NATIVE_IO_THREADS */
 #endif /* __CYGWIN__ */
 
 int ssystem(const char *fmt, ...)
@@ -198,6 +201,15 @@ tun_init()
 static uint16_t delaymsec=0;
 static uint32_t delaystartsec,delaystartmsec;
 
+#if NATIVE_IO_THREADS
+static int tun_packet_input(struct io_thread_rx *rx, uint8_t *data, int len);
+static int tun_read(int fd, uint8_t *buf, int maxlen);
+static int tun_write(int fd, const uint8_t *buf, int len);
+
+static struct io_thread_rx tun_rx;
+static struct io_thread_tx tun_tx;
+#endif /* NATIVE_IO_THREADS */
+
 /*---------------------------------------------------------------------------*/
 void
 tun_init()
@@ -209,7 +221,17 @@ tun_init()
   tunfd = tun_alloc(slip_config_tundev);
   if(tunfd == -1) err(1, "main: open");
 
+#if NATIVE_IO_THREADS
+  tun_rx.fd = tun_tx.fd = tunfd;
+  tun_rx.read = tun_read;
+  tun_rx.input = tun_packet_input;
+  tun_tx.write = tun_write;
+  if(io_thread_rx_start(&tun_rx) < 0 || io_thread_tx_start(&tun_tx) < 0) {
+    errx(1, "tun_init: could not start I/O threads");
+  }
+#else /* NATIVE_IO_THREADS */
   select_set_callback(tunfd, &tun_select_callback);
+#endif /* NATIVE_IO_THREADS */
 
   fprintf(stderr, "opened %s device ``/dev/%s''\n",
           "tun", slip_config_tundev);
@@ -226,10 +248,17 @@ static int
 tun_output(uint8_t *data, int len)
 {
   /* fprintf(stderr, "*** Writing to tun...%d\n", len); */
+#if NATIVE_IO_THREADS
+  if(io_thread_send(&tun_tx, data, len) < 0) {
+    PRINTF("tun_output: queue full, dropping %d bytes\n", len);
+    return -1;
+  }
+#else /* NATIVE_IO_THREADS */
   if(write(tunfd, data, len) != len) {
     err(1, "serial_to_tun: write");
     return -1;
   }
+#endif /* NATIVE_IO_THREADS */
   return 0;
 }
 /*---------------------------------------------------------------------------*/
@@ -267,16 +296,7 @@ const struct uip_fallback_interface rpl_interface = {
 /* tun and slip select callback                                              */
 /*---------------------------------------------------------------------------*/
 static int
-set_fd(fd_set *rset, fd_set *wset)
-{
-  FD_SET(tunfd, rset);
-  return 1;
-}
-
-/*---------------------------------------------------------------------------*/
-
-static void
-handle_fd(fd_set *rset, fd_set *wset)
+delay_active(void)
 {
   /* Optional delay between outgoing packets */
   /* Base delay times number of 6lowpan fragments to be sent */
@@ -289,8 +309,36 @@ handle_fd(fd_set *rset, fd_set *wset)
     if(dmsec<0) delaymsec=0;
     if(dmsec>delaymsec) delaymsec=0;
   }
+  return delaymsec != 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+delay_start(void)
+{
+  if(slip_config_basedelay) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL) ;
+    delaymsec=slip_config_basedelay;
+    delaystartsec =tv.tv_sec;
+    delaystartmsec=tv.tv_usec/1000;
+  }
+}
+/*---------------------------------------------------------------------------*/
 
-  if(delaymsec==0) {
+#if !NATIVE_IO_THREADS
+static int
+set_fd(fd_set *rset, fd_set *wset)
+{
+  FD_SET(tunfd, rset);
+  return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void
+handle_fd(fd_set *rset, fd_set *wset)
+{
+  if(!delay_active()) {
     int size;
 
     if(FD_ISSET(tunfd, rset)) {
@@ -299,16 +347,44 @@ handle_fd(fd_set *rset, fd_set *wset)
       uip_len = size;
       tcpip_input();
 
-      if(slip_config_basedelay) {
-        struct timeval tv;
-      	gettimeofday(&tv, NULL) ;
-      	delaymsec=slip_config_basedelay;
-      	delaystartsec =tv.tv_sec;
-      	delaystartmsec=tv.tv_usec/1000;
-      }
+      delay_start();
     }
   }
 }
+/*---------------------------------------------------------------------------*/
+#else /* !NATIVE_IO_THREADS */
+/* Reader thread side: one packet per read() on the tun device. */
+static int
+tun_read(int fd, uint8_t *buf, int maxlen)
+{
+  return read(fd, buf, maxlen);
+}
+/*---------------------------------------------------------------------------*/
+static int
+tun_write(int fd, const uint8_t *buf, int len)
+{
+  return write(fd, buf, len) == len ? len : -1;
+}
+/*---------------------------------------------------------------------------*/
+/* Main thread side: feed a packet from the reader thread to uIP. */
+static int
+tun_packet_input(struct io_thread_rx *rx, uint8_t *data, int len)
+{
+  if(delay_active()) {
+    return 1;
+  }
+  if(len > UIP_BUFSIZE - UIP_LLH_LEN) {
+    PRINTF("tun_packet_input: dropping %d bytes\n", len);
+    return 0;
+  }
+  memcpy(&uip_buf[UIP_LLH_LEN], data, len);
+  uip_len = len;
+  tcpip_input();
+
+  delay_start();
+  return 0;
+}
+#endif /* NATIVE_IO_THREADS */
 #endif /*  __CYGWIN_ */
 
 /*---------------------------------------------------------------------------*/
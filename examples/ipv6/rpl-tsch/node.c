@@ -110,7 +110,7 @@ print_network_status(void)
     PRINT6ADDR(&route->ipaddr);
     PRINTF(" via ");
     PRINT6ADDR(uip_ds6_route_nexthop(route));
-    PRINTF(" (lifetime: %lu seconds)\n", (unsigned long)route->state.lifetime);
+    PRINTF(" (lifetime: %lu seconds)\n", (unsigned long)uip_ds6_route_get_lifetime(route));
     route = uip_ds6_route_next(route);
   }
 #endif
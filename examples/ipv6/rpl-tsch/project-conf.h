@@ -138,6 +138,7 @@
 #define TSCH_CALLBACK_PACKET_READY orchestra_callback_packet_ready
 #define NETSTACK_CONF_ROUTING_NEIGHBOR_ADDED_CALLBACK orchestra_callback_child_added
 #define NETSTACK_CONF_ROUTING_NEIGHBOR_REMOVED_CALLBACK orchestra_callback_child_removed
+#define TSCH_CALLBACK_LINK_ACKED orchestra_callback_link_acked
 
 #endif /* WITH_ORCHESTRA */
 
@@ -241,7 +241,7 @@ PROCESS_THREAD(udp_client_process, ev, data)
           /* PRINT6ADDR(&r->ipaddr); */
           /* PRINTF(" -> "); */
           /* PRINT6ADDR(nexthop); */
-          PRINTF(" lt:%lu\n", r->state.lifetime);
+          PRINTF(" lt:%lu\n", uip_ds6_route_get_lifetime(r));
 
         }
       }
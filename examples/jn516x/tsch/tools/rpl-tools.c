@@ -81,7 +81,7 @@ print_network_status(void)
     uip_debug_ipaddr_print(&route->ipaddr);
     PRINTA(" via ");
     uip_debug_ipaddr_print(uip_ds6_route_nexthop(route));
-    PRINTA(" (lifetime: %lu seconds)\n", (unsigned long)route->state.lifetime);
+    PRINTA(" (lifetime: %lu seconds)\n", (unsigned long)uip_ds6_route_get_lifetime(route));
     route = uip_ds6_route_next(route);
   }
   PRINTA("----------------------\n");
@@ -550,7 +550,7 @@ extern uip_ds6_netif_t uip_ds6_if;
       ipaddr_add(&r->ipaddr);
       PRINTF("/%u (via ", r->length);
       ipaddr_add(uip_ds6_route_nexthop(r));
-      PRINTF(") %lus\n", r->state.lifetime);
+      PRINTF(") %lus\n", uip_ds6_route_get_lifetime(r));
       j = 0;
     }
   }
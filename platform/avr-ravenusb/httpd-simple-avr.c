@@ -282,10 +282,10 @@ PT_THREAD(generate_routes(struct httpd_state *s))
     PSOCK_GENERATOR_SEND(&s->sout, generate_string, buf);
     blen=0;
     ipaddr_add(uip_ds6_route_nexthop(route));
-    if(route->state.lifetime < 600) {
+    if(uip_ds6_route_get_lifetime(route) < 600) {
       PSOCK_GENERATOR_SEND(&s->sout, generate_string, buf);
       blen=0;
-      ADD(") %lus<br>", route->state.lifetime);
+      ADD(") %lus<br>", uip_ds6_route_get_lifetime(route));
     } else {
       ADD(")<br>");
     }
@@ -42,14 +42,19 @@
 #include <sys/time.h>
 
 /*---------------------------------------------------------------------------*/
+/*
+ * clock_time() and the delay functions use CLOCK_MONOTONIC, which is
+ * not affected by changes of the wall clock and is read through the
+ * vDSO on Linux, without a system call.
+ */
 clock_time_t
 clock_time(void)
 {
-  struct timeval tv;
+  struct timespec ts;
 
-  gettimeofday(&tv, NULL);
+  clock_gettime(CLOCK_MONOTONIC, &ts);
 
-  return tv.tv_sec * 1000 + tv.tv_usec / 1000;
+  return ts.tv_sec * CLOCK_SECOND + ts.tv_nsec / (1000000000L / CLOCK_SECOND);
 }
 /*---------------------------------------------------------------------------*/
 unsigned long
@@ -68,3 +73,26 @@ clock_delay(unsigned int d)
   /* Does not do anything. */
 }
 /*---------------------------------------------------------------------------*/
+void
+clock_delay_usec(uint16_t dt)
+{
+  struct timespec start, now;
+
+  /* Busy-wait, as on the hardware platforms; sleeping would add the
+     scheduler latency to short delays. */
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  do {
+    clock_gettime(CLOCK_MONOTONIC, &now);
+  } while((now.tv_sec - start.tv_sec) * 1000000L +
+          (now.tv_nsec - start.tv_nsec) / 1000 < dt);
+}
+/*---------------------------------------------------------------------------*/
+void
+clock_wait(clock_time_t t)
+{
+  clock_time_t start;
+
+  start = clock_time();
+  while(clock_time() - start < t);
+}
+/*---------------------------------------------------------------------------*/
@@ -56,6 +56,27 @@ int select_set_callback(int fd, const struct select_callback *callback);
 #define CCIF
 #define CLIF
 
+/* Let the event queue grow on the heap instead of dropping events.
+   The rtimer runs in a SIGALRM handler and may post events from there
+   (TSCH does when it loses sync), so the queue is never grown from
+   within that handler. */
+#ifndef PROCESS_CONF_GROW_EVENTS
+#define PROCESS_CONF_GROW_EVENTS 1
+#endif
+extern volatile int rtimer_arch_in_interrupt;
+#define PROCESS_CONF_CAN_GROW_EVENTS() (!rtimer_arch_in_interrupt)
+
+/* Route tables and packet queues can get large on a border router;
+   keep a free list for them instead of searching on each allocation. */
+#ifndef MEMB_CONF_WITH_FREELIST
+#define MEMB_CONF_WITH_FREELIST 1
+#endif
+
+/* Do not stall on mmem_free() by compacting memory every time. */
+#ifndef MMEM_CONF_SEGREGATED
+#define MMEM_CONF_SEGREGATED 1
+#endif
+
 /* These names are deprecated, use C99 names. */
 typedef uint8_t   u8_t;
 typedef uint16_t u16_t;
@@ -78,6 +99,10 @@ typedef unsigned short uip_stats_t;
 #define NETSTACK_CONF_RDC_CHANNEL_CHECK_RATE 8
 #endif /* NETSTACK_CONF_RDC_CHANNEL_CHECK_RATE */
 
+#ifndef AES_128_CONF
+#define AES_128_CONF native_aes_128_driver
+#endif /* AES_128_CONF */
+
 #if NETSTACK_CONF_WITH_IPV6
 
 #define LINKADDR_CONF_SIZE              8
@@ -109,10 +134,16 @@ typedef unsigned short uip_stats_t;
 #define SICSLOWPAN_CONF_FRAG                    1
 #define SICSLOWPAN_CONF_MAXAGE                  8
 #endif /* SICSLOWPAN_CONF_FRAG */
+#ifndef SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS
 #define SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS       2
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS */
 
 #define UIP_CONF_IPV6_CHECKS     1
 #define UIP_CONF_IPV6_QUEUE_PKT  1
+#ifndef UIP_PKTBUF_CONF_NUM
+/* Gateway builds have RAM to spare for packets waiting in the stack */
+#define UIP_PKTBUF_CONF_NUM      8
+#endif /* UIP_PKTBUF_CONF_NUM */
 #define UIP_CONF_IPV6_REASSEMBLY 0
 #define UIP_CONF_NETIF_MAX_ADDRESSES  3
 #define UIP_CONF_ICMP6           1
@@ -234,6 +265,25 @@ typedef unsigned long clock_time_t;
 
 #define CLOCK_CONF_SECOND 1000
 
+/*
+ * rtimer.h typedefs rtimer_clock_t as unsigned short. The native rtimer
+ * counts microseconds, so it needs 32 bits.
+ */
+typedef uint32_t rtimer_clock_t;
+#define RTIMER_CLOCK_DIFF(a,b)     ((int32_t)((a)-(b)))
+
+/* Radio turnaround times, for TSCH. The native radios have none that
+   can be measured. */
+#ifndef RADIO_DELAY_BEFORE_TX
+#define RADIO_DELAY_BEFORE_TX 0
+#endif
+#ifndef RADIO_DELAY_BEFORE_RX
+#define RADIO_DELAY_BEFORE_RX 0
+#endif
+#ifndef RADIO_DELAY_BEFORE_DETECT
+#define RADIO_DELAY_BEFORE_DETECT 0
+#endif
+
 #define LOG_CONF_ENABLED 1
 
 #define PROGRAM_HANDLER_CONF_MAX_NUMDSCS 10
@@ -48,12 +48,28 @@
 #include <sys/select.h>
 #include <errno.h>
 
+#ifdef NATIVE_CONF_EPOLL
+#define NATIVE_EPOLL NATIVE_CONF_EPOLL
+#elif defined(__linux__)
+#define NATIVE_EPOLL 1
+#else
+#define NATIVE_EPOLL 0
+#endif
+
+#if NATIVE_EPOLL
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#endif /* NATIVE_EPOLL */
+
 #ifdef __CYGWIN__
 #include "net/wpcap-drv.h"
 #endif /* __CYGWIN__ */
 
 #include "contiki.h"
 #include "net/netstack.h"
+#include "sys/trace.h"
 
 #include "ctk/ctk.h"
 #include "ctk/ctk-curses.h"
@@ -87,6 +103,9 @@ static uint8_t serial_id[] = {0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08};
 #if !NETSTACK_CONF_WITH_IPV6
 static uint16_t node_id = 0x0102;
 #endif /* !NETSTACK_CONF_WITH_IPV6 */
+#if NATIVE_EPOLL
+static void epoll_forget(int fd);
+#endif /* NATIVE_EPOLL */
 /*---------------------------------------------------------------------------*/
 int
 select_set_callback(int fd, const struct select_callback *callback)
@@ -99,6 +118,12 @@ select_set_callback(int fd, const struct select_callback *callback)
       callback = NULL;
     }
 
+#if NATIVE_EPOLL
+    /* The owner may close the descriptor and get the same number back
+       for a new one, so never trust what was registered for it. */
+    epoll_forget(fd);
+#endif /* NATIVE_EPOLL */
+
     select_callback[fd] = callback;
 
     /* Update fd max */
@@ -141,6 +166,253 @@ const static struct select_callback stdin_fd = {
 };
 /*---------------------------------------------------------------------------*/
 static void
+handle_fds(int maxfd, fd_set *fdr, fd_set *fdw)
+{
+  int i;
+
+  for(i = 0; i <= maxfd; i++) {
+    if(select_callback[i] != NULL) {
+      select_callback[i]->handle_fd(fdr, fdw);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+#if NATIVE_EPOLL
+/*
+ * epoll backend. The callbacks keep their fd_set interface: set_fd()
+ * is still asked which descriptors to watch, but epoll is only told
+ * about changes, and the process sleeps on a timerfd armed for the
+ * next etimer expiration instead of waking up every millisecond.
+ *
+ * Descriptors are registered level-triggered, since the handlers
+ * read one packet per call and rely on being called again while more
+ * data is pending.
+ */
+static int epoll_fd = -1;
+static int timer_fd = -1;
+/* Events currently registered with epoll, per descriptor. */
+static uint32_t registered[SELECT_MAX];
+/* Descriptors that epoll refuses, such as regular files; they are
+   always considered ready, as select() does. */
+static fd_set always_ready;
+static clock_time_t armed_expiration;
+static int timer_armed;
+/*---------------------------------------------------------------------------*/
+static void
+epoll_init(void)
+{
+  struct epoll_event ev;
+
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if(epoll_fd < 0 || timer_fd < 0) {
+    perror("epoll");
+    exit(1);
+  }
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.fd = timer_fd;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &ev);
+  FD_ZERO(&always_ready);
+}
+/*---------------------------------------------------------------------------*/
+/* Drop whatever epoll knows about a descriptor, so that the next
+   update_interest() registers it from scratch. */
+static void
+epoll_forget(int fd)
+{
+  if(epoll_fd >= 0) {
+    /* Fails harmlessly if it was never added or is already closed. */
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+  }
+  registered[fd] = 0;
+  FD_CLR(fd, &always_ready);
+}
+/*---------------------------------------------------------------------------*/
+/* Bring the epoll registrations in line with what the callbacks want
+   to watch. Returns the highest descriptor that is watched. */
+static int
+update_interest(void)
+{
+  struct epoll_event ev;
+  fd_set fdr, fdw;
+  uint32_t events;
+  int maxfd;
+  int i;
+
+  FD_ZERO(&fdr);
+  FD_ZERO(&fdw);
+  maxfd = 0;
+  for(i = 0; i <= select_max; i++) {
+    if(select_callback[i] != NULL && select_callback[i]->set_fd(&fdr, &fdw)) {
+      maxfd = i;
+    }
+  }
+
+  for(i = 0; i < SELECT_MAX; i++) {
+    events = (FD_ISSET(i, &fdr) ? EPOLLIN : 0) |
+      (FD_ISSET(i, &fdw) ? EPOLLOUT : 0);
+    if(events == registered[i] || FD_ISSET(i, &always_ready)) {
+      continue;
+    }
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.fd = i;
+    if(events == 0) {
+      epoll_ctl(epoll_fd, EPOLL_CTL_DEL, i, NULL);
+    } else if(epoll_ctl(epoll_fd,
+                        registered[i] == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD,
+                        i, &ev) < 0 &&
+              /* The descriptor was closed and reopened in between. */
+              (errno != ENOENT ||
+               epoll_ctl(epoll_fd, EPOLL_CTL_ADD, i, &ev) < 0)) {
+      if(errno == EPERM) {
+        FD_SET(i, &always_ready);
+      } else {
+        perror("epoll_ctl");
+      }
+      continue;
+    }
+    registered[i] = events;
+  }
+  return maxfd;
+}
+/*---------------------------------------------------------------------------*/
+/* Arm the timerfd for the next etimer expiration, if it changed. */
+static void
+update_timer(void)
+{
+  struct itimerspec its;
+  clock_time_t next;
+  clock_time_t now;
+
+  if(!etimer_pending()) {
+    if(timer_armed) {
+      memset(&its, 0, sizeof(its));
+      timerfd_settime(timer_fd, 0, &its, NULL);
+      timer_armed = 0;
+    }
+    return;
+  }
+
+  next = etimer_next_expiration_time();
+  if(timer_armed && next == armed_expiration) {
+    return;
+  }
+
+  now = clock_time();
+  memset(&its, 0, sizeof(its));
+  if((long)(next - now) > 0) {
+    its.it_value.tv_sec = (next - now) / CLOCK_SECOND;
+    its.it_value.tv_nsec = ((next - now) % CLOCK_SECOND) *
+      (1000000000L / CLOCK_SECOND);
+  } else {
+    /* Already expired; a zero value would disarm the timer. */
+    its.it_value.tv_nsec = 1;
+  }
+  timerfd_settime(timer_fd, 0, &its, NULL);
+  armed_expiration = next;
+  timer_armed = 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+wait_for_events(int busy)
+{
+  struct epoll_event events[SELECT_MAX + 1];
+  fd_set fdr, fdw;
+  sigset_t alarm, unblocked;
+  uint64_t expirations;
+  int maxfd;
+  int n, i;
+
+  /* The rtimer runs from SIGALRM and may poll a process or post an
+     event. Hold the signal off from the last look at the event queue
+     until epoll_pwait() has started to sleep, or such a wakeup could
+     be lost until the next timer or I/O event. */
+  sigemptyset(&alarm);
+  sigaddset(&alarm, SIGALRM);
+  sigprocmask(SIG_BLOCK, &alarm, &unblocked);
+  if(process_nevents() > 0) {
+    busy = 1;
+  }
+
+  maxfd = update_interest();
+  update_timer();
+
+  FD_ZERO(&fdr);
+  FD_ZERO(&fdw);
+  for(i = 0; i <= maxfd; i++) {
+    if(FD_ISSET(i, &always_ready)) {
+      FD_SET(i, &fdr);
+      busy = 1;
+    }
+  }
+
+  n = epoll_pwait(epoll_fd, events, SELECT_MAX + 1, busy ? 0 : -1,
+                  &unblocked);
+  sigprocmask(SIG_SETMASK, &unblocked, NULL);
+  if(n < 0) {
+    if(errno != EINTR) {
+      perror("epoll_wait");
+    }
+    return;
+  }
+
+  for(i = 0; i < n; i++) {
+    if(events[i].data.fd == timer_fd) {
+      if(read(timer_fd, &expirations, sizeof(expirations)) < 0) {
+        /* Spurious wakeup; nothing to read. */
+      }
+      timer_armed = 0;
+      continue;
+    }
+    if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+      FD_SET(events[i].data.fd, &fdr);
+    }
+    if(events[i].events & EPOLLOUT) {
+      FD_SET(events[i].data.fd, &fdw);
+    }
+  }
+
+  handle_fds(maxfd, &fdr, &fdw);
+}
+#else /* NATIVE_EPOLL */
+/*---------------------------------------------------------------------------*/
+static void
+wait_for_events(int busy)
+{
+  fd_set fdr;
+  fd_set fdw;
+  int maxfd;
+  int i;
+  int retval;
+  struct timeval tv;
+
+  tv.tv_sec = 0;
+  tv.tv_usec = busy ? 1 : 1000;
+
+  FD_ZERO(&fdr);
+  FD_ZERO(&fdw);
+  maxfd = 0;
+  for(i = 0; i <= select_max; i++) {
+    if(select_callback[i] != NULL && select_callback[i]->set_fd(&fdr, &fdw)) {
+      maxfd = i;
+    }
+  }
+
+  retval = select(maxfd + 1, &fdr, &fdw, NULL, &tv);
+  if(retval < 0) {
+    if(errno != EINTR) {
+      perror("select");
+    }
+  } else if(retval > 0) {
+    /* timeout => retval == 0 */
+    handle_fds(maxfd, &fdr, &fdw);
+  }
+}
+#endif /* NATIVE_EPOLL */
+/*---------------------------------------------------------------------------*/
+static void
 set_rime_addr(void)
 {
   linkaddr_t addr;
@@ -203,6 +475,9 @@ main(int argc, char **argv)
 
   process_init();
   process_start(&etimer_process, NULL);
+#if TRACE_ON
+  trace_init();
+#endif /* TRACE_ON */
   ctimer_init();
   rtimer_init();
 
@@ -249,42 +524,17 @@ main(int argc, char **argv)
   /* Make standard output unbuffered. */
   setvbuf(stdout, (char *)NULL, _IONBF, 0);
 
+#if NATIVE_EPOLL
+  epoll_init();
+#endif /* NATIVE_EPOLL */
+
   select_set_callback(STDIN_FILENO, &stdin_fd);
   while(1) {
-    fd_set fdr;
-    fd_set fdw;
-    int maxfd;
-    int i;
     int retval;
-    struct timeval tv;
 
     retval = process_run();
 
-    tv.tv_sec = 0;
-    tv.tv_usec = retval ? 1 : 1000;
-
-    FD_ZERO(&fdr);
-    FD_ZERO(&fdw);
-    maxfd = 0;
-    for(i = 0; i <= select_max; i++) {
-      if(select_callback[i] != NULL && select_callback[i]->set_fd(&fdr, &fdw)) {
-        maxfd = i;
-      }
-    }
-
-    retval = select(maxfd + 1, &fdr, &fdw, NULL, &tv);
-    if(retval < 0) {
-      if(errno != EINTR) {
-        perror("select");
-      }
-    } else if(retval > 0) {
-      /* timeout => retval == 0 */
-      for(i = 0; i <= maxfd; i++) {
-        if(select_callback[i] != NULL) {
-          select_callback[i]->handle_fd(&fdr, &fdw);
-        }
-      }
-    }
+    wait_for_events(retval);
 
     etimer_request_poll();
 
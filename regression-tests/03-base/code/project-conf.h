@@ -34,4 +34,10 @@
 
 #define UNIT_TEST_PRINT_FUNCTION test_print_report
 
+/* test-memb.c tests the free list of MEMB_FREELIST() pools */
+#define MEMB_CONF_WITH_FREELIST 1
+
+/* test-lfring.c wraps the indices of lfring sequence numbers */
+#define LFRING_CONF_INDEX_TYPE uint8_t
+
 #endif /* !_PROJECT_CONF_H_ */
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "unit-test.h"
+
+#include "lib/lfring.h"
+
+PROCESS(test_process, "lfring.c test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define RING_SIZE 8
+
+/* None of the rings is passed to lfring_init(). */
+LFRING(ring, int, RING_SIZE);
+LFRING(bulk_ring, int, RING_SIZE);
+#if LFRING_MP_SUPPORTED
+LFRING_MP(mp_ring, int, RING_SIZE);
+#endif /* LFRING_MP_SUPPORTED */
+
+static void
+test_print_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+
+UNIT_TEST_REGISTER(test_lfring_put_get, "Put and get");
+UNIT_TEST(test_lfring_put_get)
+{
+  int i, v;
+  int *p;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(lfring_size(&ring) == RING_SIZE);
+  UNIT_TEST_ASSERT(lfring_elements(&ring) == 0);
+  UNIT_TEST_ASSERT(lfring_get(&ring, &v) == 0);
+  UNIT_TEST_ASSERT(lfring_peek_get(&ring) == NULL);
+
+  for(i = 0; i < RING_SIZE; i++) {
+    UNIT_TEST_ASSERT(lfring_put(&ring, &i) == 1);
+  }
+  UNIT_TEST_ASSERT(lfring_elements(&ring) == RING_SIZE);
+  UNIT_TEST_ASSERT(lfring_put(&ring, &i) == 0);
+  UNIT_TEST_ASSERT(lfring_peek_put(&ring) == NULL);
+
+  for(i = 0; i < RING_SIZE; i++) {
+    UNIT_TEST_ASSERT(lfring_get(&ring, &v) == 1 && v == i);
+  }
+  UNIT_TEST_ASSERT(lfring_elements(&ring) == 0);
+  UNIT_TEST_ASSERT(lfring_get(&ring, &v) == 0);
+
+  /* In place */
+  p = lfring_peek_put(&ring);
+  UNIT_TEST_ASSERT(p != NULL);
+  *p = 42;
+  UNIT_TEST_ASSERT(lfring_peek_get(&ring) == NULL);
+  lfring_commit_put(&ring);
+  p = lfring_peek_get(&ring);
+  UNIT_TEST_ASSERT(p != NULL && *p == 42);
+  lfring_commit_get(&ring);
+  UNIT_TEST_ASSERT(lfring_peek_get(&ring) == NULL);
+
+  UNIT_TEST_END();
+}
+
+UNIT_TEST_REGISTER(test_lfring_bulk, "Bulk put and get across the wrap");
+UNIT_TEST(test_lfring_bulk)
+{
+  int in[RING_SIZE + 2], out[RING_SIZE + 2];
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  for(i = 0; i < RING_SIZE + 2; i++) {
+    in[i] = 100 + i;
+  }
+
+  /* Move the indices close to the end of the storage */
+  UNIT_TEST_ASSERT(lfring_put_bulk(&bulk_ring, in, RING_SIZE - 3) == RING_SIZE - 3);
+  UNIT_TEST_ASSERT(lfring_get_bulk(&bulk_ring, out, RING_SIZE) == RING_SIZE - 3);
+
+  /* Both copies are split in two chunks; only as many as fit are put */
+  UNIT_TEST_ASSERT(lfring_put_bulk(&bulk_ring, in, 6) == 6);
+  UNIT_TEST_ASSERT(lfring_put_bulk(&bulk_ring, &in[6], 4) == 2);
+  UNIT_TEST_ASSERT(lfring_elements(&bulk_ring) == RING_SIZE);
+  UNIT_TEST_ASSERT(lfring_put_bulk(&bulk_ring, in, 1) == 0);
+
+  UNIT_TEST_ASSERT(lfring_get_bulk(&bulk_ring, out, 3) == 3);
+  UNIT_TEST_ASSERT(lfring_get_bulk(&bulk_ring, &out[3], RING_SIZE + 2) == RING_SIZE - 3);
+  for(i = 0; i < RING_SIZE; i++) {
+    UNIT_TEST_ASSERT(out[i] == in[i]);
+  }
+  UNIT_TEST_ASSERT(lfring_get_bulk(&bulk_ring, out, 1) == 0);
+
+  UNIT_TEST_END();
+}
+
+UNIT_TEST_REGISTER(test_lfring_mp_wrap, "Multi-producer index wrap");
+UNIT_TEST(test_lfring_mp_wrap)
+{
+#if LFRING_MP_SUPPORTED
+  int i, j, v;
+  int next_put, next_get;
+
+  UNIT_TEST_BEGIN();
+
+  /* With 8-bit indices (see project-conf.h) this wraps them and the
+     sequence numbers several times */
+  next_put = next_get = 0;
+  for(i = 0; i < 600; i++) {
+    for(j = 0; j < 3; j++) {
+      UNIT_TEST_ASSERT(lfring_mp_put(&mp_ring, &next_put) == 1);
+      next_put++;
+    }
+    for(j = 0; j < 3; j++) {
+      UNIT_TEST_ASSERT(lfring_get(&mp_ring, &v) == 1 && v == next_get);
+      next_get++;
+    }
+  }
+  UNIT_TEST_ASSERT(lfring_get(&mp_ring, &v) == 0);
+
+  /* Full and empty still work after the wrap */
+  for(i = 0; i < RING_SIZE; i++) {
+    UNIT_TEST_ASSERT(lfring_mp_put(&mp_ring, &i) == 1);
+  }
+  UNIT_TEST_ASSERT(lfring_mp_put(&mp_ring, &i) == 0);
+  for(i = 0; i < RING_SIZE; i++) {
+    UNIT_TEST_ASSERT(lfring_get(&mp_ring, &v) == 1 && v == i);
+  }
+  UNIT_TEST_ASSERT(lfring_get(&mp_ring, &v) == 0);
+
+  UNIT_TEST_END();
+#else /* LFRING_MP_SUPPORTED */
+  UNIT_TEST_BEGIN();
+  UNIT_TEST_END();
+#endif /* LFRING_MP_SUPPORTED */
+}
+
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test_lfring_put_get);
+  UNIT_TEST_RUN(test_lfring_bulk);
+  UNIT_TEST_RUN(test_lfring_mp_wrap);
+
+  printf("=check-me= DONE\n");
+  PROCESS_END();
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "unit-test.h"
+
+#include "lib/memb.h"
+
+PROCESS(test_process, "memb.c test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define POOL_SIZE 3
+
+struct item {
+  int a, b;
+};
+
+/* Deliberately never passed to memb_init(). */
+MEMB_FREELIST(uninit_pool, struct item, POOL_SIZE);
+MEMB_FREELIST(pool, struct item, POOL_SIZE);
+
+static void
+test_print_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+
+UNIT_TEST_REGISTER(test_memb_uninit, "Alloc without init");
+UNIT_TEST(test_memb_uninit)
+{
+  struct item *p[POOL_SIZE + 1];
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(memb_numfree(&uninit_pool) == POOL_SIZE);
+
+  for(i = 0; i < POOL_SIZE + 1; i++) {
+    p[i] = memb_alloc(&uninit_pool);
+  }
+  UNIT_TEST_ASSERT(p[0] != NULL && p[1] != NULL && p[2] != NULL);
+  UNIT_TEST_ASSERT(p[0] != p[1] && p[1] != p[2] && p[0] != p[2]);
+  UNIT_TEST_ASSERT(p[3] == NULL);
+  UNIT_TEST_ASSERT(memb_numfree(&uninit_pool) == 0);
+
+  UNIT_TEST_ASSERT(memb_free(&uninit_pool, p[1]) == 0);
+  UNIT_TEST_ASSERT(memb_numfree(&uninit_pool) == 1);
+  UNIT_TEST_ASSERT(memb_alloc(&uninit_pool) == p[1]);
+  UNIT_TEST_ASSERT(memb_alloc(&uninit_pool) == NULL);
+
+  UNIT_TEST_END();
+}
+
+UNIT_TEST_REGISTER(test_memb_reuse, "Alloc and free");
+UNIT_TEST(test_memb_reuse)
+{
+  struct item *p[POOL_SIZE];
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  memb_init(&pool);
+
+  for(i = 0; i < POOL_SIZE; i++) {
+    p[i] = memb_alloc(&pool);
+    UNIT_TEST_ASSERT(p[i] != NULL && memb_inmemb(&pool, p[i]));
+  }
+  UNIT_TEST_ASSERT(memb_alloc(&pool) == NULL);
+
+  /* Freed chunks keep their contents */
+  p[0]->a = 17;
+  UNIT_TEST_ASSERT(memb_free(&pool, p[0]) == 0);
+  UNIT_TEST_ASSERT(p[0]->a == 17);
+
+  /* Pointers that are not chunks, and chunks already free */
+  UNIT_TEST_ASSERT(memb_free(&pool, (char *)p[1] + 1) == -1);
+  UNIT_TEST_ASSERT(memb_free(&pool, p[0]) == 0);
+  UNIT_TEST_ASSERT(memb_numfree(&pool) == 1);
+
+  UNIT_TEST_ASSERT(memb_free(&pool, p[2]) == 0);
+  UNIT_TEST_ASSERT(memb_numfree(&pool) == 2);
+  UNIT_TEST_ASSERT(memb_alloc(&pool) == p[2]);
+  UNIT_TEST_ASSERT(memb_alloc(&pool) == p[0]);
+  UNIT_TEST_ASSERT(memb_alloc(&pool) == NULL);
+
+  /* Initializing again makes all chunks free */
+  memb_init(&pool);
+  UNIT_TEST_ASSERT(memb_numfree(&pool) == POOL_SIZE);
+  UNIT_TEST_ASSERT(memb_alloc(&pool) == p[0]);
+
+  UNIT_TEST_END();
+}
+
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test_memb_uninit);
+  UNIT_TEST_RUN(test_memb_reuse);
+
+  printf("=check-me= DONE\n");
+  PROCESS_END();
+}
@@ -60,7 +60,7 @@ PROCESS_THREAD(router_node_process, ev, data)
     	  //printf("Route: %p %02d -> ? nbr-routes:%p", r, r->ipaddr.u8[15],
 	  //r->neighbor_routes);
     	}
-    	printf(" lt:%lu\n", r->state.lifetime);
+    	printf(" lt:%lu\n", uip_ds6_route_get_lifetime(r));
       }
     }
   }
@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2017, Swedish Institute of Computer Science.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+# 3. Neither the name of the Institute nor the names of its contributors
+#    may be used to endorse or promote products derived from this software
+#    without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+# ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+# OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+# HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+# LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+# OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+# SUCH DAMAGE.
+
+"""Convert Contiki trace output to the Chrome trace event format.
+
+Reads the lines written by core/sys/trace.c, from a console log or a
+trace file, and writes JSON that chrome://tracing and Perfetto
+(ui.perfetto.dev) can open. Other lines in the input are ignored. Each
+input file is shown as a separate node.
+
+    trace2chrome.py node1.log [node2.log ...] > trace.json
+"""
+
+import json
+import re
+import sys
+
+LINE = re.compile(r'TRACE(-START|-LOST)? (.*)$')
+
+
+def convert(lines, pid, events):
+    second = 1000000
+    mask = 0xffffffff
+    last = None
+    now = 0
+
+    for line in lines:
+        m = LINE.search(line.rstrip('\r\n'))
+        if m is None:
+            continue
+        kind, rest = m.groups()
+
+        if kind == '-START':
+            fields = rest.split()
+            second = int(fields[0])
+            mask = (1 << int(fields[1])) - 1
+            last = None
+            continue
+        if kind == '-LOST':
+            events.append({'name': 'lost records', 'ph': 'i', 's': 'p',
+                           'ts': now * 1e6 / second, 'pid': pid, 'tid': 0,
+                           'args': {'total': int(rest)}})
+            continue
+
+        fields = rest.split(' ', 5)
+        if len(fields) < 5:
+            continue
+        t = int(fields[0]) & mask
+        event = fields[1]
+        a = int(fields[2])
+        b = int(fields[3], 16)
+        c = int(fields[4], 16)
+
+        # Timestamps wrap around; they are only used as differences.
+        if last is None:
+            now = t
+        else:
+            now += (t - last) & mask
+        last = t
+
+        if event.endswith('_BEGIN'):
+            ph, name = 'B', event[:-len('_BEGIN')]
+        elif event.endswith('_END'):
+            ph, name = 'E', event[:-len('_END')]
+        else:
+            ph, name = 'i', event
+        if name == 'PROCESS':
+            pname = fields[5] if len(fields) > 5 and fields[5] else None
+            name = pname or 'process %x' % b
+            args = {'event': a, 'process': '%x' % b}
+            if ph == 'E':
+                args['ret'] = c
+        else:
+            args = {'a': a, 'b': b, 'c': c}
+
+        e = {'name': name, 'ph': ph, 'ts': now * 1e6 / second,
+             'pid': pid, 'tid': 0, 'args': args}
+        if ph == 'i':
+            e['s'] = 't'
+        events.append(e)
+
+
+def main():
+    events = []
+    files = sys.argv[1:] or ['-']
+    for pid, name in enumerate(files, 1):
+        if name == '-':
+            convert(sys.stdin, pid, events)
+        else:
+            with open(name, errors='replace') as f:
+                convert(f, pid, events)
+        events.append({'name': 'process_name', 'ph': 'M', 'pid': pid,
+                       'args': {'name': name}})
+    json.dump({'traceEvents': events}, sys.stdout)
+    sys.stdout.write('\n')
+
+
+if __name__ == '__main__':
+    main()